@@ -7,11 +7,25 @@
 #define SLE_SOLVERS_INCLUDE_GUARD
 
 #include <boost/filesystem.hpp>  // path, create_directory
+#include <string>                // string, to_string
+#include <fstream>               // ofstream
+#include <sstream>               // ostringstream
+#include <vector>                // vector
 #include "matrix.h"
 #include "gaussian_method.h"
 #include "matrix_functions.h"
+#include "SOR_solvers.h"
+#include "multigrid.h"
+#include "sparse_direct.h"
+#include "matrix_structure.h"
+#include "mixed_precision.h"
+#include "batched_solver.h"
+#include "parallel.h"
 #include "tester.h"
 #include "tests.h"
+#include "result_sink.h"
+#include "instrumentation.h"
+#include "tracing.h"
 
 namespace SLESolvers
 {
@@ -92,11 +106,14 @@ namespace SLESolvers
 
     //   SOR method. w -- iteration coefficient, eps -- precision, 
     // max_iters -- maximum number of iterations, cnt_iter -- pointer to 
-    // variable where number of performed iterations is stored
+    // variable where number of performed iterations is stored, 
+    // stop_rule -- which rule is used to stop iterations (see 
+    // SOR_stop_rule). All columns of f are solved
     template <class T>
     auto SLE_SOR(const Matrix<T> &A, const Matrix<T> &f, 
             double w = 1, int *cnt_iter = NULL, const T &eps = 1e-10, 
-            size_t max_iters = 1000)
+            size_t max_iters = 1000, 
+            SOR_stop_rule stop_rule = SOR_STOP_DIFFERENCE)
     {
         //   If A is not square we leave
         if (A.get_rows() != A.get_cols()) {
@@ -116,96 +133,278 @@ namespace SLESolvers
             *cnt_iter = -1;
         }
 
-        //   prev - vector x from previous step, cur - vector x from 
-        // current step
-        Matrix<T> prev(A.get_rows(), 1, 0);
-        Matrix<T> cur(A.get_rows(), 1);
+        //   All work is done by SOR engine
+        SOREngine<T> engine(A.get_rows(), f.get_cols());
+        int iter = engine.solve(A, f, w, eps, max_iters, stop_rule);
 
-        //   Here I implemented formula (124) from page 50 from book [1]
-        int iter;
-        for (iter = 0; iter < max_iters; ++iter) {
-            for (int i = 0; i < A.get_rows(); ++i) {
-                T sum = f[i][0];
-                for (int j = 0; j < i; ++j) {
-                    sum -= A[i][j] * cur[j][0];
-                }
+        //   Save number of iterations
+        if (cnt_iter) {
+            *cnt_iter = iter;
+        }
+        return engine.get_solution();
+    }
 
-                for (int j = i; j < A.get_rows(); ++j) {
-                    sum -= A[i][j] * prev[j][0];
-                }
+    //   SOR method with some standard constants
+    template <class T>
+    auto SLE_SOR_standard(const Matrix<T> &A, const Matrix<T> &f)
+    {
+        return SLE_SOR(A, f);
+    }
 
-                cur[i][0] = prev[i][0] + w / A[i][i] * sum;
-            }
 
-            //   If at least one of vector's coordinates is infinity or NaN, 
-            // stop
-            for (int i = 0; i < A.get_rows(); ++i) {
-                if (!isfinite(cur[i][0])) {
-                    throw std::domain_error("SLE_SOR: such both parts of SLE "
-                            "caused discrepancy of method");
-                }
+    //   Kinds of solvers which can be chosen by 'solve' function
+    enum SLE_solver_kind
+    {
+        SOLVER_AUTO,
+        SOLVER_DIAGONAL,
+        SOLVER_LOWER_TRIANGULAR,
+        SOLVER_UPPER_TRIANGULAR,
+        SOLVER_BANDED,
+        SOLVER_SPARSE_DIRECT,
+        SOLVER_SSOR_CHEBYSHEV,
+        SOLVER_SOR,
+        SOLVER_MIXED_PRECISION,
+        SOLVER_GAUSS,
+    };
+
+    //   Thresholds of choice: banded solver is used if band takes not more
+    // than 1 / SOLVE_BAND_RATIO of row, sparse solver is used if not more
+    // than 1 / SOLVE_SPARSE_RATIO of elements are not zeros and matrix
+    // has at least SOLVE_SPARSE_MIN_SIZE rows
+    enum SLE_solve_constants
+    {
+        SOLVE_BAND_RATIO = 4,
+        SOLVE_SPARSE_RATIO = 10,
+        SOLVE_SPARSE_MIN_SIZE = 64,
+    };
+
+    //   What 'solve' function has done
+    struct SolverInfo
+    {
+        SLE_solver_kind kind = SOLVER_AUTO;
+        MatrixStructure structure;
+
+        //   Why this solver was chosen
+        std::string reason;
+
+        //   Number of iterations for iterative solvers (number of
+        // refinement steps for mixed precision solver)
+        int cnt_iter = 0;
+    };
+
+    //   Chooses the fastest solver which suits given structure of matrix
+    inline SLE_solver_kind choose_SLE_solver(const MatrixStructure &s,
+            std::string &reason)
+    {
+        if (!s.square) {
+            reason = "matrix is not square";
+            return SOLVER_GAUSS;
+        }
+
+        if (s.diagonal) {
+            reason = "matrix is diagonal";
+            return SOLVER_DIAGONAL;
+        }
+
+        if (s.lower_triangular) {
+            reason = "matrix is lower triangular";
+            return SOLVER_LOWER_TRIANGULAR;
+        }
+
+        if (s.upper_triangular) {
+            reason = "matrix is upper triangular";
+            return SOLVER_UPPER_TRIANGULAR;
+        }
+
+        if ((s.lower_bandwidth + s.upper_bandwidth + 1) * SOLVE_BAND_RATIO <=
+                s.rows) {
+            reason = "matrix is banded (bandwidths " +
+                    std::to_string(s.lower_bandwidth) + " and " +
+                    std::to_string(s.upper_bandwidth) + ")";
+            return SOLVER_BANDED;
+        }
+
+        //   Sparse factorization doesn't pivot, so it's used only for
+        // diagonally dominant matrices: their pivots stay dominant during
+        // elimination. Symmetric matrix with positive diagonal can be
+        // indefinite and need pivoting, so it isn't enough
+        if (s.rows >= SOLVE_SPARSE_MIN_SIZE &&
+                s.density * SOLVE_SPARSE_RATIO <= 1 && s.diagonally_dominant) {
+            reason = "matrix is sparse and diagonally dominant";
+            return SOLVER_SPARSE_DIRECT;
+        }
+
+        reason = "matrix has no special structure";
+        return SOLVER_GAUSS;
+    }
+
+    //   Solves SLE by the fastest solver which suits structure of A.
+    // 'kind' forces solver. If 'info' is given, chosen solver and reason
+    // of choice are stored there. All columns of f are solved
+    template <class T>
+    Matrix<T> solve(const Matrix<T> &A, const Matrix<T> &f,
+            SolverInfo *info = NULL, SLE_solver_kind kind = SOLVER_AUTO)
+    {
+        SolverInfo tmp_info;
+        if (!info) {
+            info = &tmp_info;
+        }
+
+        info->structure = analyze_structure(A);
+        const MatrixStructure &s = info->structure;
+
+        bool automatic = (kind == SOLVER_AUTO);
+        if (automatic) {
+            kind = choose_SLE_solver(s, info->reason);
+        } else {
+            info->reason = "chosen by user";
+
+            //   Special solvers ignore elements out of their structure,
+            // so they can't be forced for other matrices
+            if ((kind == SOLVER_DIAGONAL && !s.diagonal) ||
+                    (kind == SOLVER_LOWER_TRIANGULAR && !s.lower_triangular) ||
+                    (kind == SOLVER_UPPER_TRIANGULAR && !s.upper_triangular)) {
+                throw std::invalid_argument("solve: chosen solver doesn't "
+                        "suit structure of left part of SLE");
             }
+        }
+        info->kind = kind;
+        info->cnt_iter = 0;
+
+        switch (kind) {
+        case SOLVER_DIAGONAL:
+            return SLE_diagonal(A, f);
 
-            //   If current and previous vectors x are close enough, stop 
-            // (we use here constant eps for this check)
-            bool cur_close_to_prev = true;
-            for (int i = 0; i < A.get_rows(); ++i) {
-                if (std::abs(cur[i][0] - prev[i][0]) >= eps) {
-                    cur_close_to_prev = false;
-                    break;
+        case SOLVER_LOWER_TRIANGULAR:
+        case SOLVER_UPPER_TRIANGULAR:
+            return SLE_triangular(A, f, kind == SOLVER_LOWER_TRIANGULAR);
+
+        case SOLVER_BANDED:
+            return SLE_banded(A, f, s.lower_bandwidth, s.upper_bandwidth);
+
+        case SOLVER_SPARSE_DIRECT:
+            try {
+                return SLE_sparse_direct(A, f, SD_MINIMUM_DEGREE,
+                        s.symmetric ? SD_LDLT : SD_LU);
+            } catch (std::domain_error &e) {
+                //   Zero pivot: if solver was chosen automatically, gauss
+                // method with pivoting is used
+                if (!automatic) {
+                    throw;
                 }
+                info->kind = SOLVER_GAUSS;
+                info->reason += ", but it needs pivoting";
+                return SLEGM(A, f);
             }
 
-            if (cur_close_to_prev) {
-                break;
-            }
+        case SOLVER_SSOR_CHEBYSHEV:
+            return SLE_SSOR_Chebyshev(A, f, 1, &info->cnt_iter);
+
+        case SOLVER_SOR:
+            return SLE_SOR(A, f, 1, &info->cnt_iter);
 
-            prev = cur;
+        case SOLVER_MIXED_PRECISION: {
+            RefinementInfo refinement;
+            auto x = SLE_mixed_precision(A, f, &refinement);
+            info->cnt_iter = refinement.steps;
+            return x;
         }
 
-        //   Save number of iterations
-        if (cnt_iter) {
-            *cnt_iter = iter;
+        default:
+            return SLEGM(A, f);
         }
-        return cur;
     }
 
-    //   SOR method with some standard constants
+    //   Automatic solver with some standard constants
     template <class T>
-    auto SLE_SOR_standard(const Matrix<T> &A, const Matrix<T> &f)
+    Matrix<T> solve_standard(const Matrix<T> &A, const Matrix<T> &f)
     {
-        return SLE_SOR(A, f);
+        return solve(A, f);
     }
 
 
-    //   This function tests given solver of SLE
+    //   How answers of SLE solvers are checked: by comparison with right
+    // answer (tests without it are not checked) or by relative residual
+    // ||A x - f|| / (||A|| ||x||), which works for all tests
+    enum SLE_check_mode
+    {
+        SLE_CHECK_ANSWER,
+        SLE_CHECK_RESIDUAL,
+    };
+
+    //   Verifier for 'Tester::check_answer_by': answer is correct if its
+    // relative residual is not bigger than 'tol'
+    template <class T>
+    auto residual_verifier(T tol)
+    {
+        return [tol](const TesterT<T> &test, const TesterA<T> &ans, 
+                std::ostream &err) {
+            if (ans.get_rows() != test.first.get_cols() ||
+                    ans.get_cols() != test.second.get_cols()) {
+                err << "Sizes of answer are wrong\n";
+                return false;
+            }
+
+            T residual = MatrixFunctions::relative_residual(test.first, 
+                    ans, test.second);
+            if (!(residual <= tol)) {
+                err << "Relative residual: " << residual << "\n";
+                return false;
+            }
+            return true;
+        };
+    }
+
+    //   This function tests given solver of SLE. If 'sink' is given, 
+    // answers are written to it instead of separate files, and folder for
+    // answers isn't touched (it's created when archive is expanded)
     template <class T>
     void test_SLE_solver(SLE_solver_type<T> SLE_solver, 
             std::string path_to_answers = "answers/", 
-            std::ostream &out = std::cout)
+            std::ostream &out = std::cout,
+            SLE_check_mode mode = SLE_CHECK_ANSWER,
+            T residual_tol = 1e-8,
+            Results::ResultSink *sink = nullptr)
     {
         //   Create folder for answers (delete it if it exists)
-        boost::filesystem::path dir_answers(path_to_answers);
-        boost::filesystem::remove_all(dir_answers);
-        boost::filesystem::create_directory(dir_answers);
+        if (!sink) {
+            boost::filesystem::path dir_answers(path_to_answers);
+            boost::filesystem::remove_all(dir_answers);
+            boost::filesystem::create_directory(dir_answers);
+        }
     
-        //   Create Tester object and fill it with tests
-        TesterSLE<T> tester;
-        Tests::create_tests(tester);
+        //   Tests are shared with other users and can't be changed
+        auto tests = Tests::get_shared_tests<T>();
+        const TesterSLE<T> &tester = *tests;
     
-        //   Testing given SLE solver
-        for (int i = 0; i < tester.get_num_tests(); ++i) {
-            //   Bring next test and store both parts of SLE in 'A' and 'f' 
-            // matrices
-            auto Af = tester.next_test();
-            auto A = Af.first;
-            auto f = Af.second;
+        //   Testing given SLE solver. Tests are solved in parallel, 
+        // messages of each test are collected separately and printed in 
+        // order of tests
+        size_t num_tests = tester.get_num_tests();
+        std::vector<std::ostringstream> verdict_out(num_tests), 
+                verdict_err(num_tests), incorrect(num_tests);
+
+        Parallel::parallel_for(0, num_tests, [&](size_t i) {
+            TRACE_SCOPE("test", "solver", i + 1);
+
+            //   Take test number 'i' and store both parts of SLE in 'A' and
+            // 'f' matrices
+            const auto &Af = tester.get_test(i);
+            const auto &A = Af.first;
+            const auto &f = Af.second;
     
             //   Try to find solution. If exception is thrown, print message
             // about it
             try {
                 //   Solving SLE
+                Instrumentation::reset_stats();
                 auto ans = SLE_solver(A, f); // here exception can be thrown
+
+#if SLE_INSTRUMENTATION
+                //   ST - statistics of solve
+                verdict_err[i] << "[ST] Test #" << i + 1 << ": " << 
+                        Instrumentation::get_stats() << std::endl;
+#endif
     
                 //   I use these variables to calculate number of digits for 
                 // each test number
@@ -214,19 +413,74 @@ namespace SLESolvers
                 int make_zeros = pow(10, test_number_digits);
     
                 //   Print answer to file
-                std::ofstream fout(path_to_answers + "/ans" + 
-                        std::to_string(make_zeros + i + 1).substr(1) + ".txt");
-                fout << ans << std::endl;
-                fout.close();
+                std::string file = path_to_answers + "/ans" + 
+                        std::to_string(make_zeros + i + 1).substr(1) + ".txt";
+                if (sink) {
+                    std::ostringstream fout;
+                    fout << ans << std::endl;
+                    sink->write(file, fout.str());
+                } else {
+                    std::ofstream fout(file);
+                    fout << ans << std::endl;
+                    fout.close();
+                }
     
                 //   Check answer
-                tester.check_answer(ans);
+                if (mode == SLE_CHECK_RESIDUAL) {
+                    tester.check_answer_by(i, ans, 
+                            residual_verifier(residual_tol), 
+                            verdict_out[i], verdict_err[i]);
+                } else {
+                    tester.check_answer(i, ans, verdict_out[i], 
+                            verdict_err[i]);
+                }
             } catch (std::domain_error &e) {
                 //   IT - incorrect test
-                out << "[IT] Test #" << i + 1 << ": " << e.what() << std::endl;
+                incorrect[i] << "[IT] Test #" << i + 1 << ": " << e.what() 
+                        << std::endl;
             }
+        });
+
+        for (size_t i = 0; i < num_tests; ++i) {
+            std::cout << verdict_out[i].str();
+            std::cerr << verdict_err[i].str();
+            out << incorrect[i].str();
         }
     }
+
+    //   This function measures time of given solver of SLE on all tests 
+    // and writes results to 'path_to_results' + name + ".json" and ".csv".
+    // Rate is counted by number of operations of LU solving 
+    // (2/3 n^3 + 2 n^2 m for n x n matrix and m right parts), so it's 
+    // nominal for iterative solvers
+    template <class T>
+    std::vector<BenchmarkResult> benchmark_SLE_solver(
+            SLE_solver_type<T> SLE_solver, const std::string &name,
+            size_t runs = TESTER_BENCHMARK_RUNS,
+            std::string path_to_results = "benchmark/")
+    {
+        boost::filesystem::create_directory(
+                boost::filesystem::path(path_to_results));
+
+        auto tests = Tests::get_shared_tests<T>();
+        const TesterSLE<T> &tester = *tests;
+
+        auto flop_count = [](const TesterT<T> &test) {
+            double n = test.first.get_rows(), m = test.second.get_cols();
+            return 2.0 / 3 * n * n * n + 2 * n * n * m;
+        };
+
+        auto results = tester.benchmark([&](const TesterT<T> &test) {
+            return SLE_solver(test.first, test.second);
+        }, runs, TESTER_BENCHMARK_WARMUP, flop_count);
+
+        std::ofstream json(path_to_results + name + ".json");
+        print_benchmark_json(name, results, json);
+        std::ofstream csv(path_to_results + name + ".csv");
+        print_benchmark_csv(name, results, csv);
+
+        return results;
+    }
 }
 
 #endif // SLE_SOLVERS_INCLUDE_GUARD
@@ -0,0 +1,3 @@
+// SOR_solvers.cpp
+
+#include "SOR_solvers.h"
@@ -0,0 +1,971 @@
+// SOR_solvers.h
+
+//   Parallel variants of SOR method. Usual SOR can't use more than one
+// core, because row 'i' uses already updated values of rows j < i. Here
+// rows are split into colors (rows of one color don't depend on each
+// other) or into blocks (blocks are updated like in Jacobi method and
+// rows inside block -- like in SOR)
+
+
+#ifndef SOR_SOLVERS_INCLUDE_GUARD
+#define SOR_SOLVERS_INCLUDE_GUARD
+
+#include <vector>     // vector
+#include <stdexcept>  // invalid_argument, domain_error
+#include <algorithm>  // max, min, swap
+#include <cmath>      // abs, isfinite, sqrt
+#include <limits>     // numeric_limits
+#include "matrix.h"
+#include "sparse_matrix.h"
+#include "parallel.h"
+#include "instrumentation.h"
+
+namespace SLESolvers
+{
+    //   Coloring of rows of matrix. Two rows are coupled if A[i][j] != 0
+    // or A[j][i] != 0. Coloring is right if coupled rows have different
+    // colors. 'color' vector stores color of each row
+    namespace Coloring
+    {
+        //   Check whether given coloring is right
+        template <class T>
+        bool check_coloring(const SparseMatrix<T> &A,
+                const std::vector<size_t> &color)
+        {
+            const auto &row_ptr = A.get_row_ptr();
+            const auto &col_ind = A.get_col_ind();
+
+            for (size_t i = 0; i < A.get_rows(); ++i) {
+                for (size_t k = row_ptr[i]; k < row_ptr[i + 1]; ++k) {
+                    if (col_ind[k] != i && color[col_ind[k]] == color[i]) {
+                        return false;
+                    }
+                }
+            }
+
+            return true;
+        }
+
+        //   Red-black coloring for stencil matrices. Rows are treated as
+        // nodes of grid with 'nx' nodes in line and colored like a chess
+        // board. I try 1D grid (tridiagonal matrices) and 2D grid with
+        // nx equal to bandwidth of matrix (5-point stencil). Returns
+        // false if matrix isn't such stencil matrix
+        template <class T>
+        bool red_black_coloring(const SparseMatrix<T> &A,
+                std::vector<size_t> &color)
+        {
+            size_t n = A.get_rows();
+            if (n == 0) {
+                color.clear();
+                return true;
+            }
+
+            //   Bandwidth of matrix
+            const auto &row_ptr = A.get_row_ptr();
+            const auto &col_ind = A.get_col_ind();
+
+            size_t band = 1;
+            for (size_t i = 0; i < n; ++i) {
+                for (size_t k = row_ptr[i]; k < row_ptr[i + 1]; ++k) {
+                    size_t j = col_ind[k];
+                    band = std::max(band, i > j ? i - j : j - i);
+                }
+            }
+
+            for (size_t nx : { n, band }) {
+                color.resize(n);
+                for (size_t i = 0; i < n; ++i) {
+                    color[i] = (i % nx + i / nx) % 2;
+                }
+
+                if (check_coloring(A, color)) {
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        //   Greedy coloring for any sparse matrix. Each row gets the
+        // smallest color which isn't used by coupled rows. Returns number
+        // of colors
+        template <class T>
+        size_t greedy_coloring(const SparseMatrix<T> &A,
+                std::vector<size_t> &color)
+        {
+            size_t n = A.get_rows();
+
+            //   Coupled rows are stored in A and in transposed A
+            auto AT = A.get_transposed();
+            const SparseMatrix<T> *parts[] = { &A, &AT };
+
+            //   forbidden[c] == i means that color 'c' is used by row
+            // coupled with row 'i'
+            const size_t NONE = n;
+            color.assign(n, NONE);
+            std::vector<size_t> forbidden(n + 1, NONE);
+
+            size_t num_colors = 0;
+            for (size_t i = 0; i < n; ++i) {
+                for (const SparseMatrix<T> *part : parts) {
+                    const auto &row_ptr = part->get_row_ptr();
+                    const auto &col_ind = part->get_col_ind();
+
+                    for (size_t k = row_ptr[i]; k < row_ptr[i + 1]; ++k) {
+                        size_t j = col_ind[k];
+                        if (j != i && color[j] != NONE) {
+                            forbidden[color[j]] = i;
+                        }
+                    }
+                }
+
+                size_t c = 0;
+                while (forbidden[c] == i) {
+                    ++c;
+                }
+
+                color[i] = c;
+                num_colors = std::max(num_colors, c + 1);
+            }
+
+            return num_colors;
+        }
+
+        //   Returns lists of rows of each color
+        inline std::vector<std::vector<size_t>> group_by_color(
+                const std::vector<size_t> &color)
+        {
+            std::vector<std::vector<size_t>> groups;
+
+            for (size_t i = 0; i < color.size(); ++i) {
+                if (color[i] >= groups.size()) {
+                    groups.resize(color[i] + 1);
+                }
+                groups[color[i]].push_back(i);
+            }
+
+            return groups;
+        }
+    }
+
+
+    //   Rules which SOR uses to decide that iterations can be stopped
+    enum SOR_stop_rule
+    {
+        //   Stop when maximum change of x during iteration is less than
+        // eps (this rule is used by SLE_SOR by default)
+        SOR_STOP_DIFFERENCE,
+
+        //   Stop when ||f - Ax|| / ||f|| is less than eps (maximum norm).
+        // Residual is computed for x after the sweep, so it costs one more
+        // product A x per iteration
+        SOR_STOP_RESIDUAL,
+    };
+
+    //   SOR engine. It allocates memory once (in constructor) and then
+    // can solve many SLE with n unknowns and k right parts (all k right
+    // parts are solved at once, so each element of A is read once per
+    // iteration for all of them). x from previous and current iteration
+    // are stored in two buffers which are swapped instead of copying.
+    // Update of x, check for infinity/NaN and computing of norm of
+    // difference are made in one pass over A
+    template <class T>
+    class SOREngine
+    {
+    private:
+        size_t n, k;
+
+        //   prev - x from previous iteration, cur - x from current one.
+        // x[i * k + c] is element (i, c) of solution
+        std::vector<T> prev, cur;
+
+        //   Sums for k right parts of current row
+        std::vector<T> sums;
+
+        //   ||f - A x|| (maximum norm) for x from current iteration. Sums
+        // of rows with x from previous iteration can't be used here: they
+        // mix old and new elements of x
+        T residual_norm(const Matrix<T> &A, const Matrix<T> &f)
+        {
+            SLE_INSTR_ADD(flops, uint64_t(2) * n * n * k);
+
+            T res = 0;
+            for (size_t i = 0; i < n; ++i) {
+                const std::vector<T> &row = A[i];
+                std::copy(f[i].begin(), f[i].end(), sums.begin());
+
+                for (size_t j = 0; j < n; ++j) {
+                    for (size_t c = 0; c < k; ++c) {
+                        sums[c] -= row[j] * cur[j * k + c];
+                    }
+                }
+                for (size_t c = 0; c < k; ++c) {
+                    res = std::max(res, std::abs(sums[c]));
+                }
+            }
+            return res;
+        }
+
+    public:
+        //   Creates engine for SLE with n unknowns and k right parts
+        SOREngine(size_t n_init, size_t k_init = 1)
+            : n(n_init), k(k_init), prev(n * k), cur(n * k), sums(k)
+        {}
+
+        //   Solves SLE A x = f starting from x = 0. Arguments are the same
+        // as in SLE_SOR. Returns number of performed iterations
+        int solve(const Matrix<T> &A, const Matrix<T> &f, double w = 1,
+                const T &eps = 1e-10, size_t max_iters = 1000,
+                SOR_stop_rule stop_rule = SOR_STOP_DIFFERENCE)
+        {
+            if (A.get_rows() != n || A.get_cols() != n) {
+                throw std::invalid_argument("SOREngine: left part of SLE "
+                        "must be square matrix of engine's size");
+            }
+
+            if (f.get_rows() != n || f.get_cols() != k) {
+                throw std::invalid_argument("SOREngine: right part of SLE "
+                        "must have engine's sizes");
+            }
+
+            std::fill(cur.begin(), cur.end(), T(0));
+
+            //   Norm of right part for residual stopping rule
+            T f_norm = 0;
+            for (size_t i = 0; i < n; ++i) {
+                for (size_t c = 0; c < k; ++c) {
+                    f_norm = std::max(f_norm, std::abs(f[i][c]));
+                }
+            }
+            if (f_norm == T(0)) {
+                f_norm = 1;
+            }
+
+            //   Here I implemented formula (124) from page 50 from book [1]
+            // for k right parts at once
+            int iter;
+            for (iter = 0; iter < max_iters; ++iter) {
+                SLE_INSTR_SCOPE(sor_sweep_time);
+                SLE_INSTR_ADD(sor_iterations, 1);
+                SLE_INSTR_ADD(flops, uint64_t(2) * n * n * k);
+
+                std::swap(prev, cur);
+
+                T diff = 0;
+                bool finite = true;
+
+                for (size_t i = 0; i < n; ++i) {
+                    const std::vector<T> &row = A[i];
+                    const std::vector<T> &f_row = f[i];
+
+                    if (k == 1) {
+                        T sum = f_row[0];
+                        for (size_t j = 0; j < i; ++j) {
+                            sum -= row[j] * cur[j];
+                        }
+                        for (size_t j = i; j < n; ++j) {
+                            sum -= row[j] * prev[j];
+                        }
+                        sums[0] = sum;
+                    } else {
+                        std::copy(f_row.begin(), f_row.end(), sums.begin());
+                        for (size_t j = 0; j < i; ++j) {
+                            for (size_t c = 0; c < k; ++c) {
+                                sums[c] -= row[j] * cur[j * k + c];
+                            }
+                        }
+                        for (size_t j = i; j < n; ++j) {
+                            for (size_t c = 0; c < k; ++c) {
+                                sums[c] -= row[j] * prev[j * k + c];
+                            }
+                        }
+                    }
+
+                    T coef = w / row[i];
+                    for (size_t c = 0; c < k; ++c) {
+                        T val = prev[i * k + c] + coef * sums[c];
+                        cur[i * k + c] = val;
+
+                        finite &= std::isfinite(val);
+                        diff = std::max(diff, std::abs(val - prev[i * k + c]));
+                    }
+                }
+
+                //   If at least one of coordinates is infinity or NaN, stop
+                if (!finite) {
+                    throw std::domain_error("SLE_SOR: such both parts of SLE "
+                            "caused discrepancy of method");
+                }
+
+                //   Check stopping rule
+                if (stop_rule == SOR_STOP_DIFFERENCE && diff < eps) {
+                    break;
+                }
+                if (stop_rule == SOR_STOP_RESIDUAL &&
+                        residual_norm(A, f) / f_norm < eps) {
+                    break;
+                }
+            }
+
+            return iter;
+        }
+
+        //   Returns x from last iteration as n x k matrix
+        Matrix<T> get_solution() const
+        {
+            Matrix<T> x(n, k);
+
+            for (size_t i = 0; i < n; ++i) {
+                std::vector<T> &row = x[i];
+                for (size_t c = 0; c < k; ++c) {
+                    row[c] = cur[i * k + c];
+                }
+            }
+
+            return x;
+        }
+    };
+
+
+    //   Constants for parallel SOR
+    enum SOR_parallel_constants
+    {
+        //   Number of rows of one color processed by one task
+        SOR_COLOR_GRAIN = 256,
+    };
+
+    //   Multicolor SOR method. Arguments are the same as in SLE_SOR. All
+    // columns of 'f' are solved. Rows are colored (red-black if possible,
+    // greedy otherwise) and then colors are processed one by one, rows
+    // of one color -- in parallel. For red-black coloring it's SOR with
+    // red-black ordering of unknowns, so its convergence is the same as
+    // convergence of usual SOR for such matrices
+    template <class T>
+    Matrix<T> SLE_SOR_multicolor(const SparseMatrix<T> &A,
+            const Matrix<T> &f, double w = 1, int *cnt_iter = NULL,
+            const T &eps = 1e-10, size_t max_iters = 1000)
+    {
+        //   If A is not square we leave
+        if (A.get_rows() != A.get_cols()) {
+            throw std::invalid_argument("SLE_SOR_multicolor: left part of "
+                    "SLE must be square");
+        }
+
+        //   If number of rows of A and f are not equal we leave
+        if (A.get_rows() != f.get_rows()) {
+            throw std::invalid_argument("SLE_SOR_multicolor: left and "
+                    "right parts of SLE must have the same number of rows");
+        }
+
+        if (cnt_iter) {
+            *cnt_iter = -1;
+        }
+
+        size_t n = A.get_rows();
+        size_t k = f.get_cols();
+
+        auto diag = A.get_diagonal();
+        for (size_t i = 0; i < n; ++i) {
+            if (diag[i] == T(0)) {
+                throw std::domain_error("SLE_SOR_multicolor: there is zero "
+                        "on diagonal of left part of SLE");
+            }
+        }
+
+        std::vector<size_t> color;
+        if (!Coloring::red_black_coloring(A, color)) {
+            Coloring::greedy_coloring(A, color);
+        }
+        auto groups = Coloring::group_by_color(color);
+
+        const auto &row_ptr = A.get_row_ptr();
+        const auto &col_ind = A.get_col_ind();
+        const auto &values = A.get_values();
+
+        //   x[i * k + c] is element (i, c) of solution. 'chunk_diff' --
+        // maximum change of x in each chunk of rows
+        std::vector<T> x(n * k, T(0));
+        std::vector<T> chunk_diff(n / SOR_COLOR_GRAIN + 1);
+
+        int iter;
+        for (iter = 0; iter < max_iters; ++iter) {
+            T diff = 0;
+
+            for (const auto &group : groups) {
+                size_t num_chunks = (group.size() + SOR_COLOR_GRAIN - 1) /
+                        SOR_COLOR_GRAIN;
+
+                Parallel::parallel_for(0, num_chunks, [&](size_t chunk) {
+                    size_t from = chunk * SOR_COLOR_GRAIN;
+                    size_t to = std::min(group.size(), from + SOR_COLOR_GRAIN);
+                    T local_diff = 0;
+
+                    for (size_t r = from; r < to; ++r) {
+                        size_t i = group[r];
+
+                        for (size_t c = 0; c < k; ++c) {
+                            T sum = f[i][c];
+                            for (size_t p = row_ptr[i]; p < row_ptr[i + 1];
+                                    ++p) {
+                                sum -= values[p] * x[col_ind[p] * k + c];
+                            }
+
+                            T delta = w / diag[i] * sum;
+                            x[i * k + c] += delta;
+                            local_diff = std::max(local_diff, std::abs(delta));
+                        }
+                    }
+
+                    chunk_diff[chunk] = local_diff;
+                });
+
+                for (size_t chunk = 0; chunk < num_chunks; ++chunk) {
+                    diff = std::max(diff, chunk_diff[chunk]);
+                }
+            }
+
+            //   If at least one of coordinates is infinity or NaN, stop
+            if (!std::isfinite(diff)) {
+                throw std::domain_error("SLE_SOR_multicolor: such both parts "
+                        "of SLE caused discrepancy of method");
+            }
+
+            //   If current and previous vectors x are close enough, stop
+            if (diff < eps) {
+                break;
+            }
+        }
+
+        //   Save number of iterations
+        if (cnt_iter) {
+            *cnt_iter = iter;
+        }
+
+        Matrix<T> ans(n, k);
+        for (size_t i = 0; i < n; ++i) {
+            for (size_t c = 0; c < k; ++c) {
+                ans[i][c] = x[i * k + c];
+            }
+        }
+        return ans;
+    }
+
+    //   Multicolor SOR for dense left part. Zeros are dropped first
+    template <class T>
+    Matrix<T> SLE_SOR_multicolor(const Matrix<T> &A, const Matrix<T> &f,
+            double w = 1, int *cnt_iter = NULL, const T &eps = 1e-10,
+            size_t max_iters = 1000)
+    {
+        return SLE_SOR_multicolor(SparseMatrix<T>(A), f, w, cnt_iter, eps,
+                max_iters);
+    }
+
+    //   Multicolor SOR method with some standard constants
+    template <class T>
+    Matrix<T> SLE_SOR_multicolor_standard(const Matrix<T> &A,
+            const Matrix<T> &f)
+    {
+        return SLE_SOR_multicolor(A, f);
+    }
+
+
+    //   Block Jacobi-SOR method for dense matrices. Rows are split into
+    // 'num_blocks' blocks (by default -- one block per thread). Blocks
+    // are updated in parallel and use values of other blocks from
+    // previous iteration (like Jacobi method), rows inside block are
+    // updated one by one like in SOR. With one block it's usual SOR.
+    // Method converges for example for matrices with diagonal dominance
+    template <class T>
+    Matrix<T> SLE_SOR_block(const Matrix<T> &A, const Matrix<T> &f,
+            double w = 1, int *cnt_iter = NULL, const T &eps = 1e-10,
+            size_t max_iters = 1000, size_t num_blocks = 0)
+    {
+        //   If A is not square we leave
+        if (A.get_rows() != A.get_cols()) {
+            throw std::invalid_argument("SLE_SOR_block: left part of SLE "
+                    "must be square");
+        }
+
+        //   If number of rows of A and f are not equal we leave
+        if (A.get_rows() != f.get_rows()) {
+            throw std::invalid_argument("SLE_SOR_block: left and right "
+                    "parts of SLE must have the same number of rows");
+        }
+
+        if (cnt_iter) {
+            *cnt_iter = -1;
+        }
+
+        size_t n = A.get_rows();
+        size_t k = f.get_cols();
+
+        if (num_blocks == 0) {
+            num_blocks = Parallel::get_num_threads();
+        }
+        num_blocks = std::max<size_t>(1, std::min(num_blocks, n));
+
+        //   prev - x from previous iteration, cur - x from current one.
+        // Buffers are swapped on each iteration instead of copying
+        std::vector<T> prev(n * k, T(0)), cur(n * k, T(0));
+        std::vector<T> block_diff(num_blocks);
+
+        int iter;
+        for (iter = 0; iter < max_iters; ++iter) {
+            std::swap(prev, cur);
+
+            Parallel::parallel_for(0, num_blocks, [&](size_t b) {
+                size_t lo = b * n / num_blocks;
+                size_t hi = (b + 1) * n / num_blocks;
+                T local_diff = 0;
+
+                for (size_t i = lo; i < hi; ++i) {
+                    const std::vector<T> &row = A[i];
+
+                    for (size_t c = 0; c < k; ++c) {
+                        T sum = f[i][c];
+                        for (size_t j = 0; j < lo; ++j) {
+                            sum -= row[j] * prev[j * k + c];
+                        }
+                        for (size_t j = lo; j < i; ++j) {
+                            sum -= row[j] * cur[j * k + c];
+                        }
+                        for (size_t j = i; j < n; ++j) {
+                            sum -= row[j] * prev[j * k + c];
+                        }
+
+                        cur[i * k + c] = prev[i * k + c] + w / row[i] * sum;
+                        local_diff = std::max(local_diff,
+                                std::abs(cur[i * k + c] - prev[i * k + c]));
+                    }
+                }
+
+                block_diff[b] = local_diff;
+            });
+
+            T diff = 0;
+            for (size_t b = 0; b < num_blocks; ++b) {
+                diff = std::max(diff, block_diff[b]);
+            }
+
+            //   If at least one of coordinates is infinity or NaN, stop
+            if (!std::isfinite(diff)) {
+                throw std::domain_error("SLE_SOR_block: such both parts of "
+                        "SLE caused discrepancy of method");
+            }
+
+            //   If current and previous vectors x are close enough, stop
+            if (diff < eps) {
+                break;
+            }
+        }
+
+        //   Save number of iterations
+        if (cnt_iter) {
+            *cnt_iter = iter;
+        }
+
+        Matrix<T> ans(n, k);
+        for (size_t i = 0; i < n; ++i) {
+            for (size_t c = 0; c < k; ++c) {
+                ans[i][c] = cur[i * k + c];
+            }
+        }
+        return ans;
+    }
+
+    //   Block Jacobi-SOR method with some standard constants
+    template <class T>
+    Matrix<T> SLE_SOR_block_standard(const Matrix<T> &A, const Matrix<T> &f)
+    {
+        return SLE_SOR_block(A, f);
+    }
+
+    //   SSOR (symmetric SOR) preconditioner M for symmetric matrix A:
+    //   M = (D + wL) D^(-1) (D + wU) / (w (2 - w)),
+    // where D, L, U -- diagonal, lower and upper parts of A. For positive
+    // definite A and 0 < w < 2 all eigenvalues of M^(-1) A lie in (0, 1].
+    //   Rows are processed group by group, rows of one group -- in
+    // parallel. With natural order each row is a separate group, with
+    // multicolor order group is a color (then it's SSOR for matrix with
+    // rows ordered by colors)
+    template <class T>
+    class SSORPreconditioner
+    {
+    private:
+        const SparseMatrix<T> &A;
+        std::vector<T> diag;
+        double w;
+
+        //   position[i] -- number of group of row 'i'. Row 'j' is before
+        // row 'i' if position[j] < position[i]
+        std::vector<size_t> position;
+        std::vector<std::vector<size_t>> groups;
+
+        //   Sweep over groups: forward (from first group to last one) or
+        // backward. z_i = (y_i - w * sum of a_ij z_j) / a_ii, where sum is
+        // taken over rows 'j' which were processed before row 'i'
+        void sweep(const std::vector<T> &y, std::vector<T> &z,
+                bool forward) const
+        {
+            const auto &row_ptr = A.get_row_ptr();
+            const auto &col_ind = A.get_col_ind();
+            const auto &values = A.get_values();
+
+            for (size_t g = 0; g < groups.size(); ++g) {
+                const auto &group = groups[forward ? g : groups.size() - 1 - g];
+
+                Parallel::parallel_for(0, group.size(), [&](size_t r) {
+                    size_t i = group[r];
+
+                    T sum = 0;
+                    for (size_t p = row_ptr[i]; p < row_ptr[i + 1]; ++p) {
+                        size_t j = col_ind[p];
+                        if (forward ? position[j] < position[i] :
+                                position[j] > position[i]) {
+                            sum += values[p] * z[j];
+                        }
+                    }
+
+                    z[i] = (y[i] - w * sum) / diag[i];
+                }, SOR_COLOR_GRAIN);
+            }
+        }
+
+    public:
+        //   Creates preconditioner. If 'multicolor' is true, rows are
+        // colored like in SLE_SOR_multicolor
+        SSORPreconditioner(const SparseMatrix<T> &A_init, double w_init,
+                bool multicolor)
+            : A(A_init), diag(A_init.get_diagonal()), w(w_init)
+        {
+            size_t n = A.get_rows();
+
+            for (size_t i = 0; i < n; ++i) {
+                if (diag[i] == T(0)) {
+                    throw std::domain_error("SSORPreconditioner: there is "
+                            "zero on diagonal of matrix");
+                }
+            }
+
+            if (multicolor) {
+                if (!Coloring::red_black_coloring(A, position)) {
+                    Coloring::greedy_coloring(A, position);
+                }
+                groups = Coloring::group_by_color(position);
+            } else {
+                position.resize(n);
+                groups.resize(n);
+                for (size_t i = 0; i < n; ++i) {
+                    position[i] = i;
+                    groups[i].push_back(i);
+                }
+            }
+        }
+
+        //   z = M^(-1) r. 'tmp' is buffer of size n
+        void apply(const std::vector<T> &r, std::vector<T> &z,
+                std::vector<T> &tmp) const
+        {
+            size_t n = A.get_rows();
+            tmp.resize(n);
+            z.resize(n);
+
+            //   (D + wL) tmp = r
+            sweep(r, tmp, true);
+
+            //   tmp = w (2 - w) D tmp
+            for (size_t i = 0; i < n; ++i) {
+                tmp[i] *= w * (2 - w) * diag[i];
+            }
+
+            //   (D + wU) z = tmp
+            sweep(tmp, z, false);
+        }
+    };
+
+    //   Returns eigenvalue number 'index' (in increasing order) of
+    // symmetric tridiagonal matrix with diagonal 'a' and off-diagonal 'b'.
+    // I use bisection: number of eigenvalues less than x is equal to
+    // number of negative elements in Sturm sequence
+    template <class T>
+    T tridiagonal_eigenvalue(const std::vector<T> &a, const std::vector<T> &b,
+            size_t index)
+    {
+        size_t m = a.size();
+
+        //   Gershgorin circles give segment with all eigenvalues
+        T lo = a[0], hi = a[0];
+        for (size_t i = 0; i < m; ++i) {
+            T radius = (i > 0 ? std::abs(b[i - 1]) : 0) +
+                    (i + 1 < m ? std::abs(b[i]) : 0);
+            lo = std::min(lo, a[i] - radius);
+            hi = std::max(hi, a[i] + radius);
+        }
+
+        auto count_less = [&](T x) {
+            size_t cnt = 0;
+            T q = 1;
+            for (size_t i = 0; i < m; ++i) {
+                q = a[i] - x - (i > 0 ? b[i - 1] * b[i - 1] / q : 0);
+                if (q == T(0)) {
+                    q = std::numeric_limits<T>::epsilon() * (std::abs(x) + 1);
+                }
+                if (q < 0) {
+                    ++cnt;
+                }
+            }
+            return cnt;
+        };
+
+        for (int step = 0; step < 100; ++step) {
+            T mid = (lo + hi) / 2;
+            if (count_less(mid) > index) {
+                hi = mid;
+            } else {
+                lo = mid;
+            }
+        }
+
+        return (lo + hi) / 2;
+    }
+
+    //   Constants for Chebyshev acceleration
+    enum SSOR_Chebyshev_constants
+    {
+        //   Number of Lanczos steps used to estimate spectrum
+        LANCZOS_STEPS = 20,
+    };
+
+    //   SSOR method with Chebyshev acceleration for symmetric positive
+    // definite matrices. Arguments are the same as in SLE_SOR, stopping
+    // rule is residual one (||f - Ax|| / ||f|| < eps, maximum norm).
+    // 'multicolor' -- use multicolor order of rows, then SSOR sweeps are
+    // parallel.
+    //   At first few steps of conjugate gradient method with SSOR
+    // preconditioner are made. Its coefficients give Lanczos tridiagonal
+    // matrix, and its extreme eigenvalues estimate spectrum [lmin, lmax]
+    // of M^(-1) A. Then Chebyshev iteration on this segment is used. It
+    // doesn't need scalar products, so there is no synchronization
+    // between threads except SSOR sweeps and product A * d
+    template <class T>
+    Matrix<T> SLE_SSOR_Chebyshev(const SparseMatrix<T> &A, const Matrix<T> &f,
+            double w = 1, int *cnt_iter = NULL, const T &eps = 1e-10,
+            size_t max_iters = 1000, bool multicolor = false)
+    {
+        //   If A is not square we leave
+        if (A.get_rows() != A.get_cols()) {
+            throw std::invalid_argument("SLE_SSOR_Chebyshev: left part of "
+                    "SLE must be square");
+        }
+
+        //   If number of rows of A and f are not equal we leave
+        if (A.get_rows() != f.get_rows()) {
+            throw std::invalid_argument("SLE_SSOR_Chebyshev: left and right "
+                    "parts of SLE must have the same number of rows");
+        }
+
+        //   Method works only for symmetric matrices
+        if (!A.is_symmetric(std::numeric_limits<T>::epsilon() * 100)) {
+            throw std::domain_error("SLE_SSOR_Chebyshev: left part of SLE "
+                    "must be symmetric");
+        }
+
+        if (cnt_iter) {
+            *cnt_iter = -1;
+        }
+
+        size_t n = A.get_rows();
+        SSORPreconditioner<T> M(A, w, multicolor);
+
+        auto norm = [](const std::vector<T> &v) {
+            T res = 0;
+            for (const T &val : v) {
+                res = std::max(res, std::abs(val));
+            }
+            return res;
+        };
+
+        auto dot = [](const std::vector<T> &u, const std::vector<T> &v) {
+            T res = 0;
+            for (size_t i = 0; i < u.size(); ++i) {
+                res += u[i] * v[i];
+            }
+            return res;
+        };
+
+        Matrix<T> ans(n, f.get_cols());
+        std::vector<T> x(n), r(n), z(n), d(n), Ad(n), tmp(n);
+
+        //   Bounds of spectrum are estimated only once (for first column)
+        T lmin = 0, lmax = 0;
+        bool have_bounds = false;
+        int total_iters = 0;
+
+        for (size_t c = 0; c < f.get_cols(); ++c) {
+            for (size_t i = 0; i < n; ++i) {
+                r[i] = f[i][c];
+            }
+            std::fill(x.begin(), x.end(), T(0));
+
+            T f_norm = norm(r);
+            if (f_norm == T(0)) {
+                f_norm = 1;
+            }
+
+            int iter = 0;
+            bool converged = norm(r) / f_norm < eps;
+
+            //   Conjugate gradient steps. 'alpha' and 'beta' are stored
+            // to build Lanczos matrix
+            if (!have_bounds && !converged) {
+                std::vector<T> alpha, beta;
+
+                M.apply(r, z, tmp);
+                d = z;
+                T rz = dot(r, z);
+
+                for (int step = 0; step < LANCZOS_STEPS &&
+                        iter < max_iters; ++step, ++iter) {
+                    A.multiply(d, Ad);
+                    T dAd = dot(d, Ad);
+                    if (!(dAd > 0)) {
+                        throw std::domain_error("SLE_SSOR_Chebyshev: left "
+                                "part of SLE must be positive definite");
+                    }
+
+                    T a = rz / dAd;
+                    for (size_t i = 0; i < n; ++i) {
+                        x[i] += a * d[i];
+                        r[i] -= a * Ad[i];
+                    }
+                    alpha.push_back(a);
+
+                    if (norm(r) / f_norm < eps) {
+                        converged = true;
+                        ++iter;
+                        break;
+                    }
+
+                    M.apply(r, z, tmp);
+                    T rz_new = dot(r, z);
+                    T b = rz_new / rz;
+                    rz = rz_new;
+                    beta.push_back(b);
+
+                    for (size_t i = 0; i < n; ++i) {
+                        d[i] = z[i] + b * d[i];
+                    }
+                }
+
+                //   Lanczos matrix from coefficients of conjugate
+                // gradient method
+                size_t m = alpha.size();
+                std::vector<T> ta(m), tb(m > 0 ? m - 1 : 0);
+                for (size_t j = 0; j < m; ++j) {
+                    ta[j] = 1 / alpha[j] +
+                            (j > 0 ? beta[j - 1] / alpha[j - 1] : 0);
+                    if (j + 1 < m) {
+                        tb[j] = std::sqrt(beta[j]) / alpha[j];
+                    }
+                }
+
+                //   Eigenvalues of M^(-1) A are not greater than 1. Ritz
+                // values lie inside spectrum, so upper bound is increased
+                // a little (Chebyshev method diverges if real maximum is
+                // much greater then 'lmax') and lower one -- decreased
+                if (m > 0) {
+                    lmin = tridiagonal_eigenvalue(ta, tb, 0) * T(0.9);
+                    lmax = std::min<T>(1, tridiagonal_eigenvalue(ta, tb,
+                            m - 1) * T(1.1));
+
+                    if (!(lmin > 0)) {
+                        throw std::domain_error("SLE_SSOR_Chebyshev: left "
+                                "part of SLE must be positive definite");
+                    }
+                    have_bounds = lmin < lmax;
+                }
+            }
+
+            if (!converged && !have_bounds) {
+                //   Spectrum is too narrow for estimation (it happens
+                // when M^(-1) A is almost identity)
+                lmin = T(0.5);
+                lmax = 1;
+                have_bounds = true;
+            }
+
+            //   Chebyshev iteration
+            if (!converged) {
+                T theta = (lmax + lmin) / 2;
+                T delta = (lmax - lmin) / 2;
+                T sigma = theta / delta;
+                T rho = 1 / sigma;
+
+                M.apply(r, z, tmp);
+                for (size_t i = 0; i < n; ++i) {
+                    d[i] = z[i] / theta;
+                }
+
+                for (; iter < max_iters; ++iter) {
+                    A.multiply(d, Ad);
+                    for (size_t i = 0; i < n; ++i) {
+                        x[i] += d[i];
+                        r[i] -= Ad[i];
+                    }
+
+                    T r_norm = norm(r);
+                    if (!std::isfinite(r_norm)) {
+                        throw std::domain_error("SLE_SSOR_Chebyshev: such "
+                                "both parts of SLE caused discrepancy of "
+                                "method");
+                    }
+                    if (r_norm / f_norm < eps) {
+                        ++iter;
+                        break;
+                    }
+
+                    M.apply(r, z, tmp);
+                    T rho_new = 1 / (2 * sigma - rho);
+                    for (size_t i = 0; i < n; ++i) {
+                        d[i] = rho_new * rho * d[i] +
+                                2 * rho_new / delta * z[i];
+                    }
+                    rho = rho_new;
+                }
+            }
+
+            total_iters = std::max(total_iters, iter);
+            for (size_t i = 0; i < n; ++i) {
+                ans[i][c] = x[i];
+            }
+        }
+
+        //   Save number of iterations
+        if (cnt_iter) {
+            *cnt_iter = total_iters;
+        }
+        return ans;
+    }
+
+    //   SSOR method with Chebyshev acceleration for dense left part
+    template <class T>
+    Matrix<T> SLE_SSOR_Chebyshev(const Matrix<T> &A, const Matrix<T> &f,
+            double w = 1, int *cnt_iter = NULL, const T &eps = 1e-10,
+            size_t max_iters = 1000, bool multicolor = false)
+    {
+        return SLE_SSOR_Chebyshev(SparseMatrix<T>(A), f, w, cnt_iter, eps,
+                max_iters, multicolor);
+    }
+
+    //   SSOR method with Chebyshev acceleration with some standard
+    // constants
+    template <class T>
+    Matrix<T> SLE_SSOR_Chebyshev_standard(const Matrix<T> &A,
+            const Matrix<T> &f)
+    {
+        return SLE_SSOR_Chebyshev(A, f);
+    }
+}
+
+#endif // SOR_SOLVERS_INCLUDE_GUARD
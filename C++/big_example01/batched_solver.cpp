@@ -0,0 +1,3 @@
+// batched_solver.cpp
+
+#include "batched_solver.h"
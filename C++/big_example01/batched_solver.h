@@ -0,0 +1,303 @@
+// batched_solver.h
+
+//   Solver of many small SLE of the same size. Systems are stored
+// interleaved: element (i, j) of left part of system 'b' is
+//     A[(i * n + j) * batch + b],
+// so the same element of all systems lies in memory contiguously. Gauss
+// method with partial pivoting is done for all systems at once, and every
+// inner loop goes over systems, which compiler turns into SIMD
+// instructions. Pivot is chosen for each system independently. There is
+// no memory allocation per system and no overhead of Matrix class
+
+
+#ifndef BATCHED_SOLVER_INCLUDE_GUARD
+#define BATCHED_SOLVER_INCLUDE_GUARD
+
+#include <vector>     // vector
+#include <string>     // string
+#include <stdexcept>  // invalid_argument, out_of_range, domain_error
+#include <algorithm>  // min
+#include <cmath>      // abs
+#include "matrix.h"
+#include "gaussian_method.h"
+#include "parallel.h"
+
+namespace SLESolvers
+{
+    //   Systems are processed by chunks of this size. Chunks are solved in
+    // parallel
+    enum Batch_constants { BATCH_CHUNK = 256 };
+
+    template <class T>
+    class BatchedSLE
+    {
+    private:
+        static const std::string exception_prefix;
+
+        //   Size of systems, number of right parts and number of systems
+        size_t n, m, batch;
+
+        //   Left parts and right parts (solutions after 'solve'). After
+        // 'solve' left parts are overwritten: U is above diagonal, and
+        // multipliers of elimination are under it. Multipliers aren't
+        // permuted by later swaps of rows and pivots aren't kept, so they
+        // are not factors P A = L U and can't be reused
+        std::vector<T> A, F;
+
+        std::vector<char> singular;
+
+        //   Solves systems from 'begin' to 'end' (not more than
+        // BATCH_CHUNK systems)
+        void solve_chunk(size_t begin, size_t end);
+
+    public:
+        BatchedSLE(size_t n_init, size_t batch_init, size_t m_init = 1);
+
+        size_t get_size() const { return n; }
+        size_t get_num_right_parts() const { return m; }
+        size_t get_batch() const { return batch; }
+
+        //   Element (i, j) of left part of system 'b'
+        T &a(size_t b, size_t i, size_t j)
+        {
+            return A[(i * n + j) * batch + b];
+        }
+
+        //   Element (i, c) of right part of system 'b' (element of
+        // solution after 'solve')
+        T &f(size_t b, size_t i, size_t c = 0)
+        {
+            return F[(i * m + c) * batch + b];
+        }
+
+        //   Raw interleaved arrays
+        std::vector<T> &get_left_parts() { return A; }
+        std::vector<T> &get_right_parts() { return F; }
+
+        //   Copies system from matrices
+        void set_system(size_t b, const Matrix<T> &A_b, const Matrix<T> &f_b);
+
+        //   Solves all systems. Left parts are overwritten (see above) and
+        // right parts are replaced by solutions
+        void solve();
+
+        //   Returns solution of system 'b'
+        Matrix<T> get_solution(size_t b) const;
+
+        //   True if left part of system 'b' turned out to be degenerate.
+        // Solution of such system is meaningless
+        bool is_singular(size_t b) const
+        {
+            return singular[b];
+        }
+    };
+
+
+    template <class T>
+    const std::string BatchedSLE<T>::exception_prefix = "class BatchedSLE: ";
+
+    template <class T>
+    BatchedSLE<T>::BatchedSLE(size_t n_init, size_t batch_init,
+            size_t m_init)
+        : n(n_init), m(m_init), batch(batch_init),
+          A(n_init * n_init * batch_init, T(0)),
+          F(n_init * m_init * batch_init, T(0)),
+          singular(batch_init, 0)
+    {}
+
+    template <class T>
+    void BatchedSLE<T>::set_system(size_t b, const Matrix<T> &A_b,
+            const Matrix<T> &f_b)
+    {
+        if (b >= batch) {
+            throw std::out_of_range(exception_prefix + "there is no system "
+                    "with such number");
+        }
+
+        if (A_b.get_rows() != n || A_b.get_cols() != n ||
+                f_b.get_rows() != n || f_b.get_cols() != m) {
+            throw std::invalid_argument(exception_prefix + "sizes of system "
+                    "do not match sizes of batch");
+        }
+
+        for (size_t i = 0; i < n; ++i) {
+            for (size_t j = 0; j < n; ++j) {
+                a(b, i, j) = A_b[i][j];
+            }
+            for (size_t c = 0; c < m; ++c) {
+                f(b, i, c) = f_b[i][c];
+            }
+        }
+    }
+
+    template <class T>
+    Matrix<T> BatchedSLE<T>::get_solution(size_t b) const
+    {
+        Matrix<T> x(n, m);
+        for (size_t i = 0; i < n; ++i) {
+            for (size_t c = 0; c < m; ++c) {
+                x[i][c] = F[(i * m + c) * batch + b];
+            }
+        }
+        return x;
+    }
+
+    template <class T>
+    void BatchedSLE<T>::solve()
+    {
+        size_t num_chunks = (batch + BATCH_CHUNK - 1) / BATCH_CHUNK;
+        Parallel::parallel_for(0, num_chunks, [this](size_t chunk) {
+            size_t begin = chunk * BATCH_CHUNK;
+            solve_chunk(begin, std::min(batch, begin + BATCH_CHUNK));
+        });
+    }
+
+    template <class T>
+    void BatchedSLE<T>::solve_chunk(size_t begin, size_t end)
+    {
+        size_t len = end - begin;
+
+        //   Pointers to element (i, j) of left part and element (i, c) of
+        // right part of the first system of chunk
+        auto pa = [&](size_t i, size_t j) {
+            return A.data() + (i * n + j) * batch + begin;
+        };
+        auto pf = [&](size_t i, size_t c) {
+            return F.data() + (i * m + c) * batch + begin;
+        };
+
+        //   Pivot row and inverse of pivot of each system
+        size_t pivot[BATCH_CHUNK];
+        T best[BATCH_CHUNK], inv[BATCH_CHUNK], coef[BATCH_CHUNK];
+        char *sing = singular.data() + begin;
+
+        for (size_t b = 0; b < len; ++b) {
+            sing[b] = 0;
+        }
+
+        // DIRECT MOTION
+
+        for (size_t k = 0; k < n; ++k) {
+            //   Maximum element of column
+            const T *col_k = pa(k, k);
+            for (size_t b = 0; b < len; ++b) {
+                pivot[b] = k;
+                best[b] = std::abs(col_k[b]);
+            }
+            for (size_t i = k + 1; i < n; ++i) {
+                const T *col_i = pa(i, k);
+                for (size_t b = 0; b < len; ++b) {
+                    T val = std::abs(col_i[b]);
+                    bool better = val > best[b];
+                    best[b] = better ? val : best[b];
+                    pivot[b] = better ? i : pivot[b];
+                }
+            }
+
+            //   Swap of rows 'k' and 'pivot' in each system. Rows are
+            // swapped by selects, so the loop over systems has no branches
+            for (size_t i = k + 1; i < n; ++i) {
+                for (size_t j = k; j < n; ++j) {
+                    T *x = pa(k, j), *y = pa(i, j);
+                    for (size_t b = 0; b < len; ++b) {
+                        bool swap = (pivot[b] == i);
+                        T xv = x[b], yv = y[b];
+                        x[b] = swap ? yv : xv;
+                        y[b] = swap ? xv : yv;
+                    }
+                }
+                for (size_t c = 0; c < m; ++c) {
+                    T *x = pf(k, c), *y = pf(i, c);
+                    for (size_t b = 0; b < len; ++b) {
+                        bool swap = (pivot[b] == i);
+                        T xv = x[b], yv = y[b];
+                        x[b] = swap ? yv : xv;
+                        y[b] = swap ? xv : yv;
+                    }
+                }
+            }
+
+            //   Degenerate systems get pivot 1, so they don't spoil
+            // anything with infinities
+            const T *diag = pa(k, k);
+            for (size_t b = 0; b < len; ++b) {
+                bool zero = GaussianJordanElimination::check_is_zero(diag[b]);
+                sing[b] |= zero;
+                inv[b] = T(1) / (zero ? T(1) : diag[b]);
+            }
+
+            //   Elimination of elements under pivot. Coefficients are
+            // stored in place of eliminated elements
+            for (size_t i = k + 1; i < n; ++i) {
+                T *l = pa(i, k);
+                for (size_t b = 0; b < len; ++b) {
+                    coef[b] = l[b] * inv[b];
+                    l[b] = coef[b];
+                }
+
+                for (size_t j = k + 1; j < n; ++j) {
+                    T *dst = pa(i, j);
+                    const T *src = pa(k, j);
+                    for (size_t b = 0; b < len; ++b) {
+                        dst[b] -= coef[b] * src[b];
+                    }
+                }
+                for (size_t c = 0; c < m; ++c) {
+                    T *dst = pf(i, c);
+                    const T *src = pf(k, c);
+                    for (size_t b = 0; b < len; ++b) {
+                        dst[b] -= coef[b] * src[b];
+                    }
+                }
+            }
+        }
+
+        // COUNTER MOTION
+
+        for (size_t i = n; i-- > 0; ) {
+            const T *diag = pa(i, i);
+            for (size_t b = 0; b < len; ++b) {
+                inv[b] = T(1) / (sing[b] ? T(1) : diag[b]);
+            }
+
+            for (size_t c = 0; c < m; ++c) {
+                T *x = pf(i, c);
+                for (size_t j = i + 1; j < n; ++j) {
+                    const T *u = pa(i, j);
+                    const T *x_j = pf(j, c);
+                    for (size_t b = 0; b < len; ++b) {
+                        x[b] -= u[b] * x_j[b];
+                    }
+                }
+                for (size_t b = 0; b < len; ++b) {
+                    x[b] *= inv[b];
+                }
+            }
+        }
+    }
+
+
+    //   Solver of one SLE through batched solver. It's used to test
+    // batched solver on usual tests
+    template <class T>
+    Matrix<T> SLE_batched_standard(const Matrix<T> &A, const Matrix<T> &f)
+    {
+        if (A.get_rows() != A.get_cols()) {
+            throw std::invalid_argument("SLE_batched: left part of SLE must "
+                    "be square");
+        }
+
+        BatchedSLE<T> batch(A.get_rows(), 1, f.get_cols());
+        batch.set_system(0, A, f);
+        batch.solve();
+
+        if (batch.is_singular(0)) {
+            throw std::domain_error("SLE_batched: left part of SLE is "
+                    "degenerate");
+        }
+
+        return batch.get_solution(0);
+    }
+}
+
+#endif // BATCHED_SOLVER_INCLUDE_GUARD
@@ -0,0 +1,344 @@
+// benchmark.cpp
+
+//   Microbenchmarks of Matrix and Gaussian elimination kernels. Each
+// kernel is run on square matrices of sizes 8, 16, ..., max_size (8192 by
+// default) and for each size minimum time of several runs is printed with
+// rate in GFLOP/s (by nominal number of operations of kernel) and memory
+// used by Matrix per element (it's bigger than sizeof(T) because each row
+// is a separate vector).
+//   Kernels are O(n^2) or O(n^3), so big sizes can take hours. Kernel is
+// stopped when predicted time of the next size is bigger than time limit.
+//   Usage: './benchmark [max_size] [time_limit_in_seconds]'.
+//   If the program is compiled with USE_BLAS ('make benchmark BLAS=1'),
+// dgemm and dgesv of installed BLAS/LAPACK are measured too.
+//   If hardware counters are permitted, IPC and misses of L1 data cache,
+// last level cache and branches per 1000 instructions (MPKI) are printed
+// for each kernel. Otherwise these columns are "-"
+
+
+#include <iostream>   // cout
+#include <iomanip>    // setw, setprecision
+#include <fstream>    // ofstream
+#include <string>     // string, stoul, stod
+#include <vector>     // vector
+#include <functional> // function
+#include <chrono>     // steady_clock, duration
+#include <random>     // mt19937, uniform_real_distribution
+#include <cmath>      // pow
+#include <algorithm>  // min
+
+#ifdef USE_BLAS
+#include <cblas.h>    // cblas_dgemm
+#include <lapacke.h>  // LAPACKE_dgesv
+#endif
+
+#include "matrix.h"
+#include "gaussian_method.h"
+#include "matrix_functions.h"
+#include "SLE_solvers.h"
+#include "fast_multiply.h"
+#include "perf_counters.h"
+
+using namespace std;
+
+using namespace GaussianJordanElimination;
+using namespace MatrixFunctions;
+using namespace SLESolvers;
+using namespace PerfCounters;
+
+using element_type = double;
+using Me = Matrix<element_type>;
+
+//   Some constants
+enum
+{
+    //   For random generator
+    SEED = 0,
+
+    //   Sizes of matrices: from MIN_SIZE to MAX_SIZE, multiplied by 2
+    MIN_SIZE = 8,
+    MAX_SIZE = 8192,
+
+    //   Kernel is run until total time is bigger than MIN_TOTAL_TIME_MS,
+    // but not more than MAX_RUNS times
+    MIN_TOTAL_TIME_MS = 200,
+    MAX_RUNS = 1000,
+
+    //   Default limit for time of one run of kernel in seconds
+    TIME_LIMIT = 10,
+};
+
+//   Input data of kernels of size n
+struct BenchmarkData
+{
+    //   A - diagonally dominant matrix (so SOR converges and A is
+    // nondegenerate), f - right part, U - row echelon form of A
+    Me A, f, U;
+};
+
+//   Kernel: 'power' - time grows as n^power, 'run' - runs kernel and
+// returns number of floating point operations. Copies of arguments are
+// made inside 'run', they take O(n^2)
+struct Kernel
+{
+    string name;
+    int power;
+    function<double(const BenchmarkData &)> run;
+};
+
+BenchmarkData create_data(size_t n, bool need_echelon)
+{
+    mt19937 gen(SEED);
+    uniform_real_distribution<element_type> urd(-1, 1);
+
+    BenchmarkData data;
+    data.A = Me(n, n);
+    data.f = Me(n, 1);
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+            data.A[i][j] = urd(gen);
+        }
+        data.A[i][i] += n;
+        data.f[i][0] = urd(gen);
+    }
+
+    if (need_echelon) {
+        data.U = get_direct_motion_max_element<element_type>(data.A);
+    }
+
+    return data;
+}
+
+//   Memory used by matrix per element in bytes
+double bytes_per_element(const Me &A)
+{
+    double bytes = sizeof(Me);
+    for (size_t i = 0; i < A.get_rows(); ++i) {
+        bytes += sizeof(vector<element_type>) +
+                A[i].capacity() * sizeof(element_type);
+    }
+    return bytes / (A.get_rows() * A.get_cols());
+}
+
+vector<Kernel> get_kernels()
+{
+    vector<Kernel> kernels = {
+        { "operator*", 3, [](const BenchmarkData &d) {
+            Me C = d.A * d.A;
+            double n = d.A.get_rows();
+            return 2 * n * n * n;
+        } },
+        //   Nominal number of operations is the same as for usual
+        // multiplication, so rates can be compared
+        { "multiply_fast", 3, [](const BenchmarkData &d) {
+            Me C = multiply_fast(d.A, d.A);
+            double n = d.A.get_rows();
+            return 2 * n * n * n;
+        } },
+        { "transpose", 2, [](const BenchmarkData &d) {
+            Me T = d.A.get_transposed();
+            return 0.0;
+        } },
+        { "direct_motion", 3, [](const BenchmarkData &d) {
+            Me A = d.A;
+            direct_motion_max_element<element_type>(A);
+            double n = d.A.get_rows();
+            return 2.0 / 3 * n * n * n;
+        } },
+        { "counter_motion", 3, [](const BenchmarkData &d) {
+            Me U = d.U, f = d.f;
+            counter_motion(U, f);
+            double n = d.A.get_rows();
+            return 1.0 / 3 * n * n * n;
+        } },
+        { "determinant", 3, [](const BenchmarkData &d) {
+            determinant(d.A);
+            double n = d.A.get_rows();
+            return 2.0 / 3 * n * n * n;
+        } },
+        { "inverse_matrix", 3, [](const BenchmarkData &d) {
+            inverse_matrix(d.A);
+            double n = d.A.get_rows();
+            return 2 * n * n * n;
+        } },
+        { "rank_matrix", 3, [](const BenchmarkData &d) {
+            rank_matrix(d.A);
+            double n = d.A.get_rows();
+            return 2.0 / 3 * n * n * n;
+        } },
+        { "SLEGU", 3, [](const BenchmarkData &d) {
+            SLEGU(d.A, d.f);
+            double n = d.A.get_rows();
+            return 2.0 / 3 * n * n * n + 2 * n * n;
+        } },
+        { "SLEGM", 3, [](const BenchmarkData &d) {
+            SLEGM(d.A, d.f);
+            double n = d.A.get_rows();
+            return 2.0 / 3 * n * n * n + 2 * n * n;
+        } },
+        //   Each iteration of SOR takes 2 n^2 operations. Number of
+        // iterations doesn't depend on n for these matrices
+        { "SLE_SOR", 2, [](const BenchmarkData &d) {
+            int iters = 0;
+            SLE_SOR(d.A, d.f, 1, &iters);
+            double n = d.A.get_rows();
+            return 2 * n * n * iters;
+        } },
+    };
+
+#ifdef USE_BLAS
+    //   Reference implementations. Matrices are copied to contiguous
+    // arrays in row-major order
+    kernels.push_back({ "BLAS dgemm", 3, [](const BenchmarkData &d) {
+        int n = d.A.get_rows();
+        vector<double> A(n * n), C(n * n);
+        for (int i = 0; i < n; ++i) {
+            copy(d.A[i].begin(), d.A[i].end(), A.begin() + i * n);
+        }
+        cblas_dgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans, n, n, n,
+                1.0, A.data(), n, A.data(), n, 0.0, C.data(), n);
+        return 2.0 * n * n * n;
+    } });
+    kernels.push_back({ "LAPACK dgesv", 3, [](const BenchmarkData &d) {
+        int n = d.A.get_rows();
+        vector<double> A(n * n), f(n);
+        vector<int> ipiv(n);
+        for (int i = 0; i < n; ++i) {
+            copy(d.A[i].begin(), d.A[i].end(), A.begin() + i * n);
+            f[i] = d.f[i][0];
+        }
+        LAPACKE_dgesv(LAPACK_ROW_MAJOR, n, 1, A.data(), n, ipiv.data(),
+                f.data(), 1);
+        return 2.0 / 3 * n * n * n + 2.0 * n * n;
+    } });
+#endif
+
+    return kernels;
+}
+
+
+int main(int argc, char **argv)
+{
+    using clock = chrono::steady_clock;
+
+    size_t max_size = (argc > 1 ? stoul(argv[1]) : MAX_SIZE);
+    double time_limit = (argc > 2 ? stod(argv[2]) : TIME_LIMIT);
+
+    vector<Kernel> kernels = get_kernels();
+
+    //   Kernel is active while it's not stopped by time limit
+    vector<bool> active(kernels.size(), true);
+
+    //   Time of the last run of each kernel and its size
+    vector<double> last_time(kernels.size(), 0);
+    vector<size_t> last_size(kernels.size(), 0);
+
+    PerfCollector perf;
+    if (!perf.is_available()) {
+        cout << "Hardware counters are unavailable (" << perf.get_error() <<
+                ")" << endl;
+    }
+
+    ofstream csv("benchmark_kernels.csv");
+    csv << "kernel,n,time_s,gflops,bytes_per_element,"
+            "ipc,l1_mpki,llc_mpki,branch_mpki\n";
+
+    cout << left << setw(16) << "kernel" << right << setw(8) << "n" <<
+            setw(14) << "time, s" << setw(12) << "GFLOP/s" <<
+            setw(14) << "bytes/elem" << setw(8) << "IPC" <<
+            setw(10) << "L1 MPKI" << setw(10) << "LLC MPKI" <<
+            setw(10) << "br MPKI" << endl;
+    cout << setprecision(4);
+
+    for (size_t n = MIN_SIZE; n <= max_size; n *= 2) {
+        //   Kernels whose next run is predicted to be too long are stopped
+        bool need_echelon = false, any_active = false;
+        for (size_t k = 0; k < kernels.size(); ++k) {
+            if (active[k] && last_size[k] != 0 && last_time[k] *
+                    pow(double(n) / last_size[k], kernels[k].power) >
+                    time_limit) {
+                active[k] = false;
+                cout << left << setw(16) << kernels[k].name << right <<
+                        setw(8) << n << "  stopped by time limit" << endl;
+            }
+
+            any_active |= active[k];
+            need_echelon |= (active[k] && kernels[k].name == "counter_motion");
+        }
+        if (!any_active) {
+            break;
+        }
+
+        BenchmarkData data = create_data(n, need_echelon);
+        double bytes = bytes_per_element(data.A);
+
+        for (size_t k = 0; k < kernels.size(); ++k) {
+            if (!active[k]) {
+                continue;
+            }
+
+            //   Minimum time of runs
+            double best = -1, flops = 0, total = 0;
+            perf.start();
+            for (size_t run = 0; run < MAX_RUNS &&
+                    total * 1000 < MIN_TOTAL_TIME_MS; ++run) {
+                auto start = clock::now();
+                flops = kernels[k].run(data);
+                double time = chrono::duration<double>(clock::now() -
+                        start).count();
+
+                total += time;
+                best = (best < 0 ? time : min(best, time));
+            }
+
+            //   Ratios don't depend on number of runs, so counters of all
+            // runs are used
+            PerfValues counters = perf.stop();
+
+            last_time[k] = best;
+            last_size[k] = n;
+
+            cout << left << setw(16) << kernels[k].name << right <<
+                    setw(8) << n << setw(14) << best << setw(12);
+            csv << kernels[k].name << ',' << n << ',' << best << ',';
+
+            //   Kernels without floating point operations (transpose)
+            // have no rate, it's printed as "-" (empty in CSV)
+            if (flops > 0 && best > 0) {
+                double gflops = flops / best / 1e9;
+                cout << gflops;
+                csv << gflops;
+            } else {
+                cout << "-";
+            }
+            cout << setw(14) << bytes;
+            csv << ',' << bytes;
+
+            //   Unavailable counters are printed as "-" (empty in CSV)
+            double ratios[] = {
+                counters.ipc(),
+                counters.per_kilo_instruction(PERF_L1D_MISSES),
+                counters.per_kilo_instruction(PERF_LLC_MISSES),
+                counters.per_kilo_instruction(PERF_BRANCH_MISSES),
+            };
+            PerfEvent events[] = { PERF_CYCLES, PERF_L1D_MISSES,
+                    PERF_LLC_MISSES, PERF_BRANCH_MISSES };
+            for (size_t i = 0; i < 4; ++i) {
+                bool known = counters.has(events[i]) &&
+                        counters.has(PERF_INSTRUCTIONS);
+                cout << setw(i == 0 ? 8 : 10);
+                if (known) {
+                    cout << ratios[i];
+                    csv << ',' << ratios[i];
+                } else {
+                    cout << "-";
+                    csv << ',';
+                }
+            }
+            cout << endl;
+            csv << '\n';
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,3 @@
+// exact_methods.cpp
+
+#include "exact_methods.h"
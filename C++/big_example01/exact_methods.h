@@ -0,0 +1,1043 @@
+// exact_methods.h
+
+//   Exact rank and determinant of integer matrices. 'rank_matrix' and
+// 'determinant' compare elements with zero with fixed precision, which is
+// wrong for integer matrices with big elements or big determinants.
+//   1) Gaussian elimination modulo prime p < 2^31. Elements are kept in
+// Montgomery form (x * 2^32 mod p), so multiplication modulo p needs only
+// multiplications and shifts, and row operations have no branches and no
+// divisions, which lets compiler vectorize them. Primes are fixed: the
+// biggest primes below 2^31. Rank modulo big prime is equal to rank over
+// rationals unless p divides some special minor, so two primes are used
+// and maximum is taken.
+//   2) Exact determinant (Abbott, Bronstein, Mulders). Determinant modulo
+// one prime costs one elimination, and Hadamard bound |det A| <=
+// prod ||a_i|| needs thousands of bits for big matrices, so combining
+// only determinants modulo primes would need hundreds of eliminations.
+// Instead SLE A x = b with random b is solved exactly by p-adic lifting
+// (one elimination and O(n^2) per digit), and denominator d of the first
+// element of x is found by rational reconstruction. d divides det A and
+// usually it's almost all of it, so only cofactor det A / d is found
+// modulo few primes and combined by chinese remainder theorem (Garner's
+// algorithm). It stops earlier if last mixed radix digits are zero (it's
+// wrong with probability about 1 / p^2 per check). If A is singular
+// modulo EXACT_LIFT_TRIES primes, d = 1.
+//   3) Fraction-free Bareiss elimination in __int128: every intermediate
+// element is a minor of A, so division is exact. Throws overflow_error if
+// some minor doesn't fit in long long. It's for small and medium matrices
+
+
+#ifndef EXACT_METHODS_INCLUDE_GUARD
+#define EXACT_METHODS_INCLUDE_GUARD
+
+#include <vector>     // vector
+#include <string>     // string, to_string
+#include <cstdint>    // uint32_t, uint64_t, int64_t
+#include <cmath>      // abs, round, log2, isfinite
+#include <limits>     // numeric_limits
+#include <stdexcept>  // invalid_argument, overflow_error, domain_error
+#include <algorithm>  // min, swap_ranges, max_element
+#include <iostream>   // ostream
+#include <random>     // mt19937, uniform_int_distribution
+#include "matrix.h"
+#include "parallel.h"
+
+namespace MatrixFunctions
+{
+    //   Number of primes used by 'rank_exact', number of zero mixed
+    // radix digits after which 'determinant_exact' stops and grain of
+    // parallel loops over rows
+    enum Exact_constants
+    {
+        EXACT_RANK_PRIMES = 2,
+        EXACT_EARLY_STOP = 3,
+        EXACT_ROW_GRAIN = 16,
+
+        //   Number of primes tried for p-adic lifting and range of
+        // elements of random right part b ([-EXACT_RHS_RANGE,
+        // EXACT_RHS_RANGE])
+        EXACT_LIFT_TRIES = 3,
+        EXACT_RHS_RANGE = 100,
+    };
+
+    //   Signed integer of any size. Only operations which are needed for
+    // chinese remainder theorem are implemented
+    class BigInteger
+    {
+    private:
+        bool negative = false;
+
+        //   Digits in base 2^32, the least significant first, without
+        // leading zeros (zero has no digits)
+        std::vector<uint32_t> digits;
+
+        void trim()
+        {
+            while (!digits.empty() && digits.back() == 0) {
+                digits.pop_back();
+            }
+            if (digits.empty()) {
+                negative = false;
+            }
+        }
+
+        //   Compares absolute values
+        static int compare_abs(const BigInteger &a, const BigInteger &b)
+        {
+            if (a.digits.size() != b.digits.size()) {
+                return a.digits.size() < b.digits.size() ? -1 : 1;
+            }
+            for (size_t i = a.digits.size(); i-- > 0; ) {
+                if (a.digits[i] != b.digits[i]) {
+                    return a.digits[i] < b.digits[i] ? -1 : 1;
+                }
+            }
+            return 0;
+        }
+
+    public:
+        BigInteger(long long val = 0)
+        {
+            negative = (val < 0);
+            uint64_t abs_val = negative ? uint64_t(0) - uint64_t(val) :
+                    uint64_t(val);
+            while (abs_val) {
+                digits.push_back(uint32_t(abs_val));
+                abs_val >>= 32;
+            }
+        }
+
+        bool is_negative() const { return negative; }
+        bool is_zero() const { return digits.empty(); }
+
+        //   Number of bits of absolute value (0 for zero)
+        size_t bit_length() const
+        {
+            if (digits.empty()) {
+                return 0;
+            }
+            size_t bits = 32 * (digits.size() - 1);
+            for (uint32_t top = digits.back(); top; top >>= 1) {
+                ++bits;
+            }
+            return bits;
+        }
+
+        //   2^bits
+        static BigInteger power_of_two(size_t bits)
+        {
+            BigInteger res;
+            res.digits.assign(bits / 32 + 1, 0);
+            res.digits.back() = uint32_t(1) << (bits % 32);
+            return res;
+        }
+
+        //   this = this * mul + add (for nonnegative numbers)
+        void mul_add(uint32_t mul, uint32_t add)
+        {
+            uint64_t carry = add;
+            for (uint32_t &d : digits) {
+                uint64_t cur = uint64_t(d) * mul + carry;
+                d = uint32_t(cur);
+                carry = cur >> 32;
+            }
+            if (carry) {
+                digits.push_back(uint32_t(carry));
+            }
+            trim();
+        }
+
+        //   Divides absolute value by 'div', returns remainder
+        uint32_t div_small(uint32_t div)
+        {
+            uint64_t rem = 0;
+            for (size_t i = digits.size(); i-- > 0; ) {
+                uint64_t cur = (rem << 32) | digits[i];
+                digits[i] = uint32_t(cur / div);
+                rem = cur % div;
+            }
+            trim();
+            return uint32_t(rem);
+        }
+
+        //   Remainder of division of absolute value by 'div'
+        uint32_t mod_small(uint32_t div) const
+        {
+            uint64_t rem = 0;
+            for (size_t i = digits.size(); i-- > 0; ) {
+                rem = ((rem << 32) | digits[i]) % div;
+            }
+            return uint32_t(rem);
+        }
+
+        BigInteger operator - () const
+        {
+            BigInteger res = *this;
+            res.negative = !res.negative;
+            res.trim();
+            return res;
+        }
+
+        //   Difference of nonnegative numbers
+        friend BigInteger operator - (const BigInteger &a,
+                const BigInteger &b)
+        {
+            if (compare_abs(a, b) < 0) {
+                return -(b - a);
+            }
+
+            BigInteger res = a;
+            int64_t borrow = 0;
+            for (size_t i = 0; i < res.digits.size(); ++i) {
+                int64_t cur = int64_t(res.digits[i]) - borrow -
+                        (i < b.digits.size() ? int64_t(b.digits[i]) : 0);
+                borrow = (cur < 0);
+                res.digits[i] = uint32_t(cur + (borrow << 32));
+            }
+            res.trim();
+            return res;
+        }
+
+        //   Sum of nonnegative numbers
+        friend BigInteger operator + (const BigInteger &a,
+                const BigInteger &b)
+        {
+            BigInteger res = (a.digits.size() < b.digits.size() ? b : a);
+            const BigInteger &other = (a.digits.size() < b.digits.size() ?
+                    a : b);
+
+            uint64_t carry = 0;
+            for (size_t i = 0; i < res.digits.size(); ++i) {
+                carry += uint64_t(res.digits[i]) +
+                        (i < other.digits.size() ? other.digits[i] : 0);
+                res.digits[i] = uint32_t(carry);
+                carry >>= 32;
+            }
+            if (carry) {
+                res.digits.push_back(uint32_t(carry));
+            }
+            return res;
+        }
+
+        friend BigInteger operator * (const BigInteger &a,
+                const BigInteger &b)
+        {
+            BigInteger res;
+            if (a.is_zero() || b.is_zero()) {
+                return res;
+            }
+
+            res.digits.assign(a.digits.size() + b.digits.size(), 0);
+            for (size_t i = 0; i < a.digits.size(); ++i) {
+                uint64_t carry = 0;
+                for (size_t j = 0; j < b.digits.size(); ++j) {
+                    uint64_t cur = uint64_t(a.digits[i]) * b.digits[j] +
+                            res.digits[i + j] + carry;
+                    res.digits[i + j] = uint32_t(cur);
+                    carry = cur >> 32;
+                }
+                res.digits[i + b.digits.size()] = uint32_t(carry);
+            }
+            res.negative = (a.negative != b.negative);
+            res.trim();
+            return res;
+        }
+
+        //   Division of absolute values: |a| = q |b| + r, 0 <= r < |b|
+        // (Knuth's algorithm D). Throws domain_error if b is zero
+        static void divmod(const BigInteger &a, const BigInteger &b,
+                BigInteger &q, BigInteger &r)
+        {
+            if (b.is_zero()) {
+                throw std::domain_error("class BigInteger: division by zero");
+            }
+
+            if (compare_abs(a, b) < 0) {
+                r = a;
+                r.negative = false;
+                q = BigInteger(0);
+                return;
+            }
+
+            if (b.digits.size() == 1) {
+                q = a;
+                q.negative = false;
+                r = BigInteger(q.div_small(b.digits[0]));
+                return;
+            }
+
+            //   Divisor is shifted so that its top digit has highest bit
+            int shift = 0;
+            while (!(b.digits.back() << shift & 0x80000000u)) {
+                ++shift;
+            }
+            auto shifted = [shift](const std::vector<uint32_t> &x) {
+                std::vector<uint32_t> res(x.size() + 1, 0);
+                for (size_t i = 0; i < x.size(); ++i) {
+                    uint64_t cur = uint64_t(x[i]) << shift;
+                    res[i] |= uint32_t(cur);
+                    res[i + 1] = uint32_t(cur >> 32);
+                }
+                return res;
+            };
+
+            std::vector<uint32_t> u = shifted(a.digits);
+            std::vector<uint32_t> v = shifted(b.digits);
+            v.pop_back();
+
+            size_t n = v.size(), m = u.size() - n;
+            q.negative = false;
+            q.digits.assign(m, 0);
+
+            const uint64_t BASE = uint64_t(1) << 32;
+            for (size_t j = m; j-- > 0; ) {
+                //   Estimation of digit of quotient by two top digits
+                uint64_t num = (uint64_t(u[j + n]) << 32) | u[j + n - 1];
+                uint64_t qhat = num / v[n - 1], rhat = num % v[n - 1];
+                while (qhat >= BASE || qhat * v[n - 2] >
+                        ((rhat << 32) | u[j + n - 2])) {
+                    --qhat;
+                    rhat += v[n - 1];
+                    if (rhat >= BASE) {
+                        break;
+                    }
+                }
+
+                //   u = u - qhat * v * BASE^j
+                int64_t borrow = 0;
+                uint64_t carry = 0;
+                for (size_t i = 0; i < n; ++i) {
+                    uint64_t prod = qhat * v[i] + carry;
+                    carry = prod >> 32;
+                    int64_t cur = int64_t(u[i + j]) - borrow -
+                            int64_t(prod & 0xffffffffu);
+                    u[i + j] = uint32_t(cur);
+                    borrow = (cur < 0);
+                }
+                int64_t top = int64_t(u[j + n]) - borrow - int64_t(carry);
+                u[j + n] = uint32_t(top);
+
+                //   qhat was one bigger than digit, v is added back
+                if (top < 0) {
+                    --qhat;
+                    uint64_t sum = 0;
+                    for (size_t i = 0; i < n; ++i) {
+                        sum += uint64_t(u[i + j]) + v[i];
+                        u[i + j] = uint32_t(sum);
+                        sum >>= 32;
+                    }
+                    u[j + n] += uint32_t(sum);
+                }
+
+                q.digits[j] = uint32_t(qhat);
+            }
+            q.trim();
+
+            //   Remainder is in low digits of u, shifted back
+            r.negative = false;
+            r.digits.assign(n, 0);
+            for (size_t i = 0; i < n; ++i) {
+                uint64_t cur = (uint64_t(u[i + 1]) << 32) | u[i];
+                r.digits[i] = uint32_t(cur >> shift);
+            }
+            r.trim();
+        }
+
+        friend bool operator < (const BigInteger &a, const BigInteger &b)
+        {
+            if (a.negative != b.negative) {
+                return a.negative;
+            }
+            int cmp = compare_abs(a, b);
+            return a.negative ? cmp > 0 : cmp < 0;
+        }
+
+        friend bool operator == (const BigInteger &a, const BigInteger &b)
+        {
+            return a.negative == b.negative && a.digits == b.digits;
+        }
+
+        std::string to_string() const
+        {
+            if (is_zero()) {
+                return "0";
+            }
+
+            //   Digits in base 10^9
+            const uint32_t BASE = 1000000000;
+            BigInteger tmp = *this;
+            std::vector<uint32_t> parts;
+            while (!tmp.is_zero()) {
+                parts.push_back(tmp.div_small(BASE));
+            }
+
+            std::string res = (negative ? "-" : "") +
+                    std::to_string(parts.back());
+            for (size_t i = parts.size() - 1; i-- > 0; ) {
+                std::string part = std::to_string(parts[i]);
+                res += std::string(9 - part.size(), '0') + part;
+            }
+            return res;
+        }
+    };
+
+    inline std::ostream &operator << (std::ostream &out, const BigInteger &a)
+    {
+        return out << a.to_string();
+    }
+
+
+    namespace ExactDetail
+    {
+        //   Arithmetic modulo odd p < 2^31 in Montgomery form
+        struct Montgomery
+        {
+            uint32_t p;
+
+            //   -p^{-1} mod 2^32 and 2^64 mod p
+            uint32_t p_neg_inv;
+            uint32_t r2;
+
+            explicit Montgomery(uint32_t p_init)
+                : p(p_init)
+            {
+                //   Newton's iterations for inverse modulo 2^32
+                uint32_t inv = p;
+                for (int i = 0; i < 5; ++i) {
+                    inv *= 2 - p * inv;
+                }
+                p_neg_inv = uint32_t(0) - inv;
+                r2 = uint32_t((uint64_t(0) - uint64_t(p)) % p);
+            }
+
+            //   x * 2^{-32} mod p for x < p * 2^32
+            uint32_t reduce(uint64_t x) const
+            {
+                uint32_t m = uint32_t(x) * p_neg_inv;
+                uint32_t t = uint32_t((x + uint64_t(m) * p) >> 32);
+                return t >= p ? t - p : t;
+            }
+
+            uint32_t mul(uint32_t a, uint32_t b) const
+            {
+                return reduce(uint64_t(a) * b);
+            }
+
+            uint32_t sub(uint32_t a, uint32_t b) const
+            {
+                uint32_t d = a - b;
+                return a >= b ? d : d + p;
+            }
+
+            uint32_t to_form(uint32_t a) const { return mul(a, r2); }
+            uint32_t from_form(uint32_t a) const { return reduce(a); }
+
+            uint32_t pow(uint32_t a, uint32_t e) const
+            {
+                uint32_t res = to_form(1);
+                for (; e; e >>= 1) {
+                    if (e & 1) {
+                        res = mul(res, a);
+                    }
+                    a = mul(a, a);
+                }
+                return res;
+            }
+
+            uint32_t inverse(uint32_t a) const { return pow(a, p - 2); }
+        };
+
+        //   Deterministic Miller-Rabin test for 32-bit numbers
+        inline bool is_prime(uint32_t n)
+        {
+            if (n < 2 || n % 2 == 0) {
+                return n == 2;
+            }
+
+            uint32_t d = n - 1;
+            int s = 0;
+            while (d % 2 == 0) {
+                d /= 2, ++s;
+            }
+
+            for (uint32_t a : { 2u, 7u, 61u }) {
+                if (a % n == 0) {
+                    continue;
+                }
+
+                uint64_t x = 1, base = a % n;
+                for (uint32_t e = d; e; e >>= 1) {
+                    if (e & 1) {
+                        x = x * base % n;
+                    }
+                    base = base * base % n;
+                }
+
+                if (x == 1 || x == n - 1) {
+                    continue;
+                }
+
+                bool composite = true;
+                for (int r = 1; r < s && composite; ++r) {
+                    x = x * x % n;
+                    composite = (x != n - 1);
+                }
+                if (composite) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        //   'count' biggest primes which are less than 2^31
+        inline std::vector<uint32_t> get_primes(size_t count)
+        {
+            std::vector<uint32_t> primes;
+            for (uint32_t n = (1u << 31) - 1; primes.size() < count; n -= 2) {
+                if (is_prime(n)) {
+                    primes.push_back(n);
+                }
+            }
+            return primes;
+        }
+
+        //   row = row - coef * pivot_row (elements from 'begin' to 'end')
+        inline void subtract_row(uint32_t *row, const uint32_t *pivot_row,
+                size_t begin, size_t end, uint32_t coef, Montgomery mont)
+        {
+            for (size_t j = begin; j < end; ++j) {
+                row[j] = mont.sub(row[j], mont.mul(coef, pivot_row[j]));
+            }
+        }
+
+        //   Gaussian elimination of matrix A (rows x cols, by rows) modulo
+        // prime p. Returns rank; if 'det' isn't NULL, determinant modulo p
+        // (for square matrices) is written there
+        inline size_t eliminate_mod(const std::vector<long long> &A,
+                size_t rows, size_t cols, uint32_t p, uint32_t *det = NULL)
+        {
+            Montgomery mont(p);
+
+            std::vector<uint32_t> a(A.size());
+            for (size_t i = 0; i < A.size(); ++i) {
+                long long r = A[i] % (long long) p;
+                a[i] = mont.to_form(uint32_t(r < 0 ? r + p : r));
+            }
+
+            uint32_t d = mont.to_form(1);
+            size_t rank = 0;
+
+            for (size_t col = 0; col < cols && rank < rows; ++col) {
+                size_t pivot = rank;
+                while (pivot < rows && a[pivot * cols + col] == 0) {
+                    ++pivot;
+                }
+                if (pivot == rows) {
+                    d = 0;
+                    continue;
+                }
+
+                if (pivot != rank) {
+                    std::swap_ranges(a.begin() + pivot * cols + col,
+                            a.begin() + (pivot + 1) * cols,
+                            a.begin() + rank * cols + col);
+                    d = mont.sub(0, d);
+                }
+
+                const uint32_t *pivot_row = a.data() + rank * cols;
+                d = mont.mul(d, pivot_row[col]);
+                uint32_t inv = mont.inverse(pivot_row[col]);
+
+                //   Rows are eliminated in parallel (if it's called from
+                // parallel loop over primes, this loop is sequential)
+                uint32_t *data = a.data();
+                Parallel::parallel_for(rank + 1, rows, [=](size_t i) {
+                    uint32_t *row = data + i * cols;
+                    if (row[col] == 0) {
+                        return;
+                    }
+
+                    subtract_row(row, pivot_row, col + 1, cols,
+                            mont.mul(row[col], inv), mont);
+                    row[col] = 0;
+                }, EXACT_ROW_GRAIN);
+
+                ++rank;
+            }
+
+            if (det) {
+                *det = (rank == rows && rows == cols ? mont.from_form(d) : 0);
+            }
+            return rank;
+        }
+
+        //   LU factorization of square matrix modulo prime p for p-adic
+        // lifting. 'a' keeps U on and above diagonal and multipliers of L
+        // under it (in Montgomery form), row 'i' of factors is row
+        // perm[i] of A. If det = 0, factors can't be used
+        struct LUMod
+        {
+            Montgomery mont;
+            size_t n;
+            std::vector<uint32_t> a, inv_diag;
+            std::vector<size_t> perm;
+            uint32_t det;
+
+            LUMod(const std::vector<long long> &A, size_t n_init, uint32_t p)
+                : mont(p), n(n_init), a(A.size()), inv_diag(n_init),
+                  perm(n_init)
+            {
+                for (size_t i = 0; i < A.size(); ++i) {
+                    long long r = A[i] % (long long) p;
+                    a[i] = mont.to_form(uint32_t(r < 0 ? r + p : r));
+                }
+                for (size_t i = 0; i < n; ++i) {
+                    perm[i] = i;
+                }
+
+                uint32_t d = mont.to_form(1);
+                for (size_t k = 0; k < n; ++k) {
+                    size_t pivot = k;
+                    while (pivot < n && a[pivot * n + k] == 0) {
+                        ++pivot;
+                    }
+                    if (pivot == n) {
+                        det = 0;
+                        return;
+                    }
+
+                    //   Whole rows are swapped, with multipliers
+                    if (pivot != k) {
+                        std::swap_ranges(a.begin() + pivot * n,
+                                a.begin() + (pivot + 1) * n,
+                                a.begin() + k * n);
+                        std::swap(perm[pivot], perm[k]);
+                        d = mont.sub(0, d);
+                    }
+
+                    const uint32_t *pivot_row = a.data() + k * n;
+                    d = mont.mul(d, pivot_row[k]);
+                    uint32_t inv = mont.inverse(pivot_row[k]);
+                    inv_diag[k] = inv;
+
+                    uint32_t *data = a.data();
+                    Montgomery m = mont;
+                    size_t size = n;
+                    Parallel::parallel_for(k + 1, n, [=](size_t i) {
+                        uint32_t *row = data + i * size;
+                        uint32_t coef = m.mul(row[k], inv);
+                        subtract_row(row, pivot_row, k + 1, size, coef, m);
+                        row[k] = coef;
+                    }, EXACT_ROW_GRAIN);
+                }
+
+                det = mont.from_form(d);
+            }
+
+            //   Solves A x = r modulo p. Elements of r and x are usual
+            // residues (not in Montgomery form)
+            void solve(std::vector<uint32_t> &x) const
+            {
+                std::vector<uint32_t> y(n);
+                for (size_t i = 0; i < n; ++i) {
+                    y[i] = mont.to_form(x[perm[i]]);
+                }
+
+                //   Sums of products in Montgomery form are less than
+                // n p < 2^64, so they are reduced once
+                for (size_t i = 0; i < n; ++i) {
+                    const uint32_t *row = a.data() + i * n;
+                    uint64_t sum = 0;
+                    for (size_t j = 0; j < i; ++j) {
+                        sum += mont.mul(row[j], y[j]);
+                    }
+                    y[i] = mont.sub(y[i], uint32_t(sum % mont.p));
+                }
+
+                for (size_t i = n; i-- > 0; ) {
+                    const uint32_t *row = a.data() + i * n;
+                    uint64_t sum = 0;
+                    for (size_t j = i + 1; j < n; ++j) {
+                        sum += mont.mul(row[j], y[j]);
+                    }
+                    y[i] = mont.mul(mont.sub(y[i], uint32_t(sum % mont.p)),
+                            inv_diag[i]);
+                }
+
+                for (size_t i = 0; i < n; ++i) {
+                    x[i] = mont.from_form(y[i]);
+                }
+            }
+        };
+
+        //   Dixon's p-adic lifting: solution of A x = b is
+        //     x = c_0 + c_1 p + c_2 p^2 + ...,
+        // where c_i = A^{-1} r_i mod p, r_0 = b, r_{i+1} = (r_i - A c_i) / p
+        // (division is exact). Returns digits c_0, ..., c_{steps-1} of
+        // the first element of x. 'Acc' must hold n max|A| p + max|r|
+        template <class Acc>
+        std::vector<uint32_t> lift_first_element(
+                const std::vector<long long> &A, size_t n, const LUMod &lu,
+                const std::vector<long long> &b, size_t steps)
+        {
+            const long long p = lu.mont.p;
+            std::vector<Acc> r(b.begin(), b.end());
+            std::vector<uint32_t> c(n), digits;
+            digits.reserve(steps);
+
+            for (size_t step = 0; step < steps; ++step) {
+                for (size_t i = 0; i < n; ++i) {
+                    long long rem = (long long) (r[i] % p);
+                    c[i] = uint32_t(rem < 0 ? rem + p : rem);
+                }
+                lu.solve(c);
+                digits.push_back(c[0]);
+
+                Acc *r_data = r.data();
+                const uint32_t *c_data = c.data();
+                Parallel::parallel_for(0, n, [&, r_data, c_data](size_t i) {
+                    const long long *row = A.data() + i * n;
+                    Acc sum = r_data[i];
+                    for (size_t j = 0; j < n; ++j) {
+                        sum -= (Acc) row[j] * c_data[j];
+                    }
+                    r_data[i] = sum / p;
+                }, EXACT_ROW_GRAIN);
+            }
+
+            return digits;
+        }
+
+        //   Rational reconstruction: finds fraction num / den = u modulo m
+        // with |num| < 2^num_bits and 0 < den < 2^den_bits (it's unique if
+        // m > 2^(num_bits + den_bits + 1)) by extended Euclid's algorithm.
+        // Returns den in lowest terms, or 1 if there is no such fraction.
+        // Cofactors of Euclid's algorithm alternate in sign, so only their
+        // absolute values are kept
+        inline BigInteger reconstruct_denominator(const BigInteger &u,
+                const BigInteger &m, size_t num_bits, size_t den_bits)
+        {
+            const BigInteger num_bound = BigInteger::power_of_two(num_bits);
+            BigInteger r0 = m, r1 = u, t0(0), t1(1), q, rem;
+
+            while (!(r1 < num_bound)) {
+                BigInteger::divmod(r0, r1, q, rem);
+                r0 = r1;
+                r1 = rem;
+
+                BigInteger t2 = t0 + q * t1;
+                t0 = t1;
+                t1 = t2;
+            }
+
+            if (!(t1 < BigInteger::power_of_two(den_bits))) {
+                return BigInteger(1);
+            }
+
+            //   num / den in lowest terms
+            BigInteger a = r1, g = t1;
+            while (!a.is_zero()) {
+                BigInteger::divmod(g, a, q, rem);
+                g = a;
+                a = rem;
+            }
+            BigInteger::divmod(t1, g, q, rem);
+            return q;
+        }
+    }
+
+
+    //   True if all elements of matrix are integers which fit in long long
+    template <class T>
+    bool is_integer_matrix(const Matrix<T> &A)
+    {
+        for (size_t i = 0; i < A.get_rows(); ++i) {
+            for (const T &val : A[i]) {
+                if (!std::isfinite(val) || std::round(val) != val ||
+                        std::abs(val) >= T(9.2e18)) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    //   Elements of integer matrix by rows. Throws invalid_argument if
+    // some element isn't integer
+    template <class T>
+    std::vector<long long> get_integer_elements(const Matrix<T> &A,
+            const std::string &func_name)
+    {
+        if (!is_integer_matrix(A)) {
+            throw std::invalid_argument(func_name + ": elements of matrix "
+                    "must be integers");
+        }
+
+        std::vector<long long> res;
+        res.reserve(A.get_rows() * A.get_cols());
+        for (size_t i = 0; i < A.get_rows(); ++i) {
+            for (const T &val : A[i]) {
+                res.push_back((long long) val);
+            }
+        }
+        return res;
+    }
+
+    //   Determinant of integer matrix modulo prime p < 2^31
+    template <class T>
+    uint32_t determinant_mod(const Matrix<T> &A, uint32_t p)
+    {
+        if (A.get_rows() != A.get_cols()) {
+            throw std::invalid_argument("determinant_mod: matrix must be "
+                    "square");
+        }
+
+        uint32_t det = 0;
+        ExactDetail::eliminate_mod(get_integer_elements(A,
+                "determinant_mod"), A.get_rows(), A.get_cols(), p, &det);
+        return det;
+    }
+
+    //   Exact rank of integer matrix (with very high probability, see top
+    // of file)
+    template <class T>
+    size_t rank_exact(const Matrix<T> &A)
+    {
+        auto elements = get_integer_elements(A, "rank_exact");
+        auto primes = ExactDetail::get_primes(EXACT_RANK_PRIMES);
+
+        std::vector<size_t> ranks(primes.size());
+        Parallel::parallel_for(0, primes.size(), [&](size_t i) {
+            ranks[i] = ExactDetail::eliminate_mod(elements, A.get_rows(),
+                    A.get_cols(), primes[i]);
+        });
+
+        return *std::max_element(ranks.begin(), ranks.end());
+    }
+
+    //   Exact determinant of integer matrix (see top of file)
+    template <class T>
+    BigInteger determinant_exact(const Matrix<T> &A)
+    {
+        using ExactDetail::Montgomery;
+
+        if (A.get_rows() != A.get_cols()) {
+            throw std::invalid_argument("determinant_exact: matrix must be "
+                    "square");
+        }
+
+        size_t n = A.get_rows();
+        auto elements = get_integer_elements(A, "determinant_exact");
+        if (n == 0) {
+            return BigInteger(1);
+        }
+
+        //   Random right part of SLE for lifting
+        std::mt19937 gen(0);
+        std::uniform_int_distribution<long long> dist(-EXACT_RHS_RANGE,
+                EXACT_RHS_RANGE);
+        std::vector<long long> b(n);
+        for (long long &val : b) {
+            val = dist(gen);
+        }
+
+        //   log2 of Hadamard bound of det A and of numerator of x_0 (by
+        // Cramer's rule it's determinant of A with first column replaced
+        // by b) and maximum absolute value of elements
+        double log_bound = 0, log_num_bound = 0;
+        long double max_abs = 0;
+        for (size_t i = 0; i < n; ++i) {
+            long double norm = 0;
+            for (size_t j = 0; j < n; ++j) {
+                long double val = elements[i * n + j];
+                norm += val * val;
+                max_abs = std::max(max_abs, std::abs(val));
+            }
+            if (norm == 0) {
+                return BigInteger(0);
+            }
+            log_bound += 0.5 * std::log2((double) norm);
+            log_num_bound += 0.5 * std::log2((double) norm +
+                    (double) (b[i] * b[i]));
+        }
+
+        //   Primes are bigger than 2^30. Cofactor needs not more primes
+        // than det A, and some primes can be skipped
+        size_t max_primes = size_t(log_bound / 30) + 2;
+        auto primes = ExactDetail::get_primes(max_primes + EXACT_LIFT_TRIES);
+
+        //   Determinants modulo primes which are already known
+        std::vector<uint32_t> dets(primes.size());
+        std::vector<char> known(primes.size(), 0);
+
+        //   Denominator of x_0. It divides det A
+        BigInteger d(1);
+        for (size_t k = 0; k < EXACT_LIFT_TRIES && k < primes.size(); ++k) {
+            ExactDetail::LUMod lu(elements, n, primes[k]);
+            dets[k] = lu.det;
+            known[k] = 1;
+            if (lu.det == 0) {
+                continue;
+            }
+
+            //   p^steps > 2^(num_bits + den_bits + 1)
+            size_t num_bits = size_t(log_num_bound) + 1;
+            size_t den_bits = size_t(log_bound) + 1;
+            size_t steps = (num_bits + den_bits + 1) / 30 + 1;
+
+            //   Residuals are bounded by n max|A| + max|b|, so long long
+            // is enough for sums if n max|A| p < 2^62
+            std::vector<uint32_t> digits = ((long double) n * max_abs <
+                    (long double) (1u << 31)) ?
+                    ExactDetail::lift_first_element<long long>(elements, n,
+                            lu, b, steps) :
+                    ExactDetail::lift_first_element<__int128>(elements, n,
+                            lu, b, steps);
+
+            //   x_0 modulo p^steps by Horner's scheme
+            BigInteger u(0), m(1);
+            for (size_t i = digits.size(); i-- > 0; ) {
+                u.mul_add(primes[k], digits[i]);
+                m.mul_add(primes[k], 0);
+            }
+
+            d = ExactDetail::reconstruct_denominator(u, m, num_bits,
+                    den_bits);
+            break;
+        }
+
+        //   Mixed radix digits of cofactor c = det A / d and of -c by
+        // primes 'used' (primes which divide d are skipped):
+        //     c = v_0 + v_1 p_0 + v_2 p_0 p_1 + ...
+        std::vector<uint32_t> used, v, w;
+        size_t zeros_v = 0, zeros_w = 0;
+
+        auto add_digit = [&](std::vector<uint32_t> &digits, uint32_t r) {
+            size_t k = digits.size();
+            uint64_t p = used[k];
+            uint64_t x = r;
+            for (size_t j = 0; j < k; ++j) {
+                //   x = (x - v_j) / p_j mod p
+                x = (x + p - digits[j] % p) % p;
+                Montgomery mont((uint32_t) p);
+                uint32_t inv = mont.from_form(mont.inverse(
+                        mont.to_form(uint32_t(used[j] % p))));
+                x = x * inv % p;
+            }
+            digits.push_back(uint32_t(x));
+            return x == 0;
+        };
+
+        //   Cofactor is less than 2^(log_bound - log2 d)
+        double log_cofactor = std::max(0.0, log_bound -
+                double(d.bit_length()) + 1);
+        size_t num_primes = size_t(log_cofactor / 30) + 2;
+
+        size_t batch = Parallel::get_num_threads();
+        bool stop = false;
+        for (size_t k = 0; k < primes.size() && used.size() < num_primes &&
+                !stop; ) {
+            size_t cnt = std::min(batch, primes.size() - k);
+            Parallel::parallel_for(k, k + cnt, [&](size_t i) {
+                if (!known[i]) {
+                    ExactDetail::eliminate_mod(elements, n, n, primes[i],
+                            &dets[i]);
+                    known[i] = 1;
+                }
+            });
+
+            for (size_t end = k + cnt; k < end && used.size() < num_primes &&
+                    !stop; ++k) {
+                uint32_t p = primes[k];
+                uint32_t d_mod = d.mod_small(p);
+                if (d_mod == 0) {
+                    continue;
+                }
+
+                //   c = det A / d modulo p
+                Montgomery mont(p);
+                uint32_t c = mont.from_form(mont.mul(mont.to_form(dets[k]),
+                        mont.inverse(mont.to_form(d_mod))));
+
+                used.push_back(p);
+                zeros_v = add_digit(v, c) ? zeros_v + 1 : 0;
+                zeros_w = add_digit(w, (p - c) % p) ? zeros_w + 1 : 0;
+                stop = (zeros_v >= EXACT_EARLY_STOP ||
+                        zeros_w >= EXACT_EARLY_STOP);
+            }
+        }
+
+        //   Horner's scheme for mixed radix digits
+        auto compose = [&](const std::vector<uint32_t> &digits) {
+            BigInteger res(0);
+            for (size_t i = digits.size(); i-- > 0; ) {
+                res.mul_add(used[i], digits[i]);
+            }
+            return res;
+        };
+
+        BigInteger pos = compose(v), neg = compose(w);
+        return d * ((neg < pos) ? -neg : pos);
+    }
+
+    //   Determinant of integer matrix by Bareiss algorithm. Throws
+    // overflow_error if some minor of matrix doesn't fit in long long
+    template <class T>
+    long long determinant_bareiss(const Matrix<T> &A)
+    {
+        if (A.get_rows() != A.get_cols()) {
+            throw std::invalid_argument("determinant_bareiss: matrix must "
+                    "be square");
+        }
+
+        size_t n = A.get_rows();
+        auto a = get_integer_elements(A, "determinant_bareiss");
+        if (n == 0) {
+            return 1;
+        }
+
+        const __int128 max_val = std::numeric_limits<long long>::max();
+        long long prev = 1;
+        bool negative = false;
+
+        for (size_t k = 0; k + 1 < n; ++k) {
+            size_t pivot = k;
+            while (pivot < n && a[pivot * n + k] == 0) {
+                ++pivot;
+            }
+            if (pivot == n) {
+                return 0;
+            }
+            if (pivot != k) {
+                std::swap_ranges(a.begin() + pivot * n,
+                        a.begin() + (pivot + 1) * n, a.begin() + k * n);
+                negative = !negative;
+            }
+
+            const long long *row_k = a.data() + k * n;
+            const long long a_kk = row_k[k];
+
+            for (size_t i = k + 1; i < n; ++i) {
+                long long *row = a.data() + i * n;
+                const long long a_ik = row[k];
+
+                for (size_t j = k + 1; j < n; ++j) {
+                    __int128 x = (__int128) row[j] * a_kk -
+                            (__int128) a_ik * row_k[j];
+                    x /= prev;
+                    if (x > max_val || x < -max_val) {
+                        throw std::overflow_error("determinant_bareiss: "
+                                "minor of matrix doesn't fit in long long");
+                    }
+                    row[j] = (long long) x;
+                }
+            }
+            prev = a_kk;
+        }
+
+        long long det = a[n * n - 1];
+        return negative ? -det : det;
+    }
+}
+
+#endif // EXACT_METHODS_INCLUDE_GUARD
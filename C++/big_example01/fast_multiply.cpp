@@ -0,0 +1,3 @@
+// fast_multiply.cpp
+
+#include "fast_multiply.h"
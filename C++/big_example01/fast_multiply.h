@@ -0,0 +1,320 @@
+// fast_multiply.h
+
+//   Fast multiplication of big matrices by Strassen-Winograd algorithm.
+// Matrices are split into 2x2 blocks and product is computed with 7
+// multiplications of blocks (instead of 8) and 15 additions, recursively,
+// so it takes O(n^2.81) operations. When blocks become smaller than
+// crossover size, usual blocked multiplication is used. 7 products of the
+// top level are computed in parallel.
+//   Matrices are copied into contiguous buffers padded with zeros so
+// that each dimension is divisible by 2^levels. All temporary blocks are
+// taken from one arena which is allocated once: for square matrices of
+// size n it's about 5 n^2 elements for sequential recursion and 7 times
+// more for parallel top level.
+//   Accuracy. Usual multiplication has componentwise error bound
+//     |C - C'| <= n u |A| |B|    (u - unit roundoff),
+// Strassen-Winograd has only normwise one:
+//     ||C - C'|| <= (n0^2 + 5 n0) (n / n0)^(log2 18) u ||A|| ||B||,
+// where n0 is crossover size. So elements of C which are much smaller
+// than ||A|| ||B|| can lose their relative accuracy completely. For
+// matrices with elements of similar magnitude error is usually 10-100
+// times bigger than error of usual multiplication. Use multiply_fast
+// only when it's acceptable
+
+
+#ifndef FAST_MULTIPLY_INCLUDE_GUARD
+#define FAST_MULTIPLY_INCLUDE_GUARD
+
+#include <vector>     // vector
+#include <stdexcept>  // invalid_argument, logic_error
+#include <algorithm>  // min, max, fill, copy
+#include "matrix.h"
+#include "parallel.h"
+
+namespace MatrixFunctions
+{
+    //   Crossover size and sizes of blocks of usual multiplication.
+    // Rows of all buffers are padded by FM_ROW_PADDING elements: padded
+    // sizes are powers of 2, and rows with such distance between them
+    // fall into the same cache sets
+    enum FM_constants
+    {
+        FM_CROSSOVER = 128,
+        FM_BLOCK_ROWS = 128,
+        FM_BLOCK_COLS = 512,
+        FM_ROW_PADDING = 8,
+    };
+
+    namespace FastMultiplyDetail
+    {
+        //   Part of contiguous matrix: 'p' - first element, 'ld' - distance
+        // between rows
+        template <class T>
+        struct View
+        {
+            T *p;
+            size_t ld;
+
+            T *row(size_t i) const { return p + i * ld; }
+
+            //   Block (bi, bj) of matrix split into 2x2 blocks of size
+            // rows x cols
+            View block(size_t bi, size_t bj, size_t rows, size_t cols) const
+            {
+                return { p + bi * rows * ld + bj * cols, ld };
+            }
+        };
+
+        //   Stack of temporary buffers
+        template <class T>
+        class Arena
+        {
+        private:
+            T *base;
+            size_t size, top = 0;
+
+        public:
+            Arena(T *base_init, size_t size_init)
+                : base(base_init), size(size_init)
+            {}
+
+            View<T> allocate(size_t rows, size_t cols)
+            {
+                size_t ld = cols + FM_ROW_PADDING;
+                if (top + rows * ld > size) {
+                    throw std::logic_error("multiply_fast: arena is too "
+                            "small");
+                }
+                View<T> res = { base + top, ld };
+                top += rows * ld;
+                return res;
+            }
+
+            size_t get_top() const { return top; }
+            void release(size_t old_top) { top = old_top; }
+        };
+
+        //   C = A B (n x k times k x m), blocked i-k-j loops
+        template <class T>
+        void multiply_blocked(View<T> A, View<T> B, View<T> C,
+                size_t n, size_t k, size_t m)
+        {
+            for (size_t i = 0; i < n; ++i) {
+                std::fill(C.row(i), C.row(i) + m, T(0));
+            }
+
+            for (size_t jj = 0; jj < m; jj += FM_BLOCK_COLS) {
+                size_t j_end = std::min<size_t>(m, jj + FM_BLOCK_COLS);
+
+                for (size_t ll = 0; ll < k; ll += FM_BLOCK_ROWS) {
+                    size_t l_end = std::min<size_t>(k, ll + FM_BLOCK_ROWS);
+
+                    for (size_t i = 0; i < n; ++i) {
+                        const T *a_row = A.row(i);
+                        T *c_row = C.row(i);
+
+                        for (size_t l = ll; l < l_end; ++l) {
+                            const T a = a_row[l];
+                            const T *b_row = B.row(l);
+
+                            for (size_t j = jj; j < j_end; ++j) {
+                                c_row[j] += a * b_row[j];
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        //   C = A + B or C = A - B
+        template <class T>
+        void add(View<T> A, View<T> B, View<T> C, size_t rows, size_t cols,
+                bool subtract = false)
+        {
+            for (size_t i = 0; i < rows; ++i) {
+                const T *a = A.row(i), *b = B.row(i);
+                T *c = C.row(i);
+
+                if (subtract) {
+                    for (size_t j = 0; j < cols; ++j) {
+                        c[j] = a[j] - b[j];
+                    }
+                } else {
+                    for (size_t j = 0; j < cols; ++j) {
+                        c[j] = a[j] + b[j];
+                    }
+                }
+            }
+        }
+
+        template <class T>
+        void sub(View<T> A, View<T> B, View<T> C, size_t rows, size_t cols)
+        {
+            add(A, B, C, rows, cols, true);
+        }
+
+        //   Size of arena for sequential recursion with 'levels' levels
+        inline size_t arena_size(size_t n, size_t k, size_t m, size_t levels)
+        {
+            if (levels == 0) {
+                return 0;
+            }
+
+            n /= 2, k /= 2, m /= 2;
+            return 4 * n * (k + FM_ROW_PADDING) +
+                    4 * k * (m + FM_ROW_PADDING) +
+                    7 * n * (m + FM_ROW_PADDING) +
+                    arena_size(n, k, m, levels - 1);
+        }
+
+        template <class T>
+        void strassen(View<T> A, View<T> B, View<T> C, size_t n, size_t k,
+                size_t m, size_t levels, Arena<T> &arena);
+
+        //   One level of Strassen-Winograd. Products M[i] = X[i] Y[i] are
+        // computed by 'product(X, Y, M)'
+        template <class T, class F>
+        void winograd_level(View<T> A, View<T> B, View<T> C, size_t n,
+                size_t k, size_t m, Arena<T> &arena, F product)
+        {
+            size_t h = n / 2, w = k / 2, v = m / 2;
+
+            View<T> A11 = A.block(0, 0, h, w), A12 = A.block(0, 1, h, w);
+            View<T> A21 = A.block(1, 0, h, w), A22 = A.block(1, 1, h, w);
+            View<T> B11 = B.block(0, 0, w, v), B12 = B.block(0, 1, w, v);
+            View<T> B21 = B.block(1, 0, w, v), B22 = B.block(1, 1, w, v);
+            View<T> C11 = C.block(0, 0, h, v), C12 = C.block(0, 1, h, v);
+            View<T> C21 = C.block(1, 0, h, v), C22 = C.block(1, 1, h, v);
+
+            size_t old_top = arena.get_top();
+
+            View<T> S[4], R[4], M[7];
+            for (auto &X : S) {
+                X = arena.allocate(h, w);
+            }
+            for (auto &X : R) {
+                X = arena.allocate(w, v);
+            }
+            for (auto &X : M) {
+                X = arena.allocate(h, v);
+            }
+
+            add(A21, A22, S[0], h, w);      // S1 = A21 + A22
+            sub(S[0], A11, S[1], h, w);     // S2 = S1 - A11
+            sub(A11, A21, S[2], h, w);      // S3 = A11 - A21
+            sub(A12, S[1], S[3], h, w);     // S4 = A12 - S2
+
+            sub(B12, B11, R[0], w, v);      // T1 = B12 - B11
+            sub(B22, R[0], R[1], w, v);     // T2 = B22 - T1
+            sub(B22, B12, R[2], w, v);      // T3 = B22 - B12
+            sub(R[1], B21, R[3], w, v);     // T4 = T2 - B21
+
+            View<T> X[7] = { A11, A12, S[3], A22, S[0], S[1], S[2] };
+            View<T> Y[7] = { B11, B21, B22, R[3], R[0], R[1], R[2] };
+            product(X, Y, M);
+
+            //   U1 = M1 + M2, U2 = M1 + M6, U3 = U2 + M7, U4 = U2 + M5,
+            // C11 = U1, C12 = U4 + M3, C21 = U3 - M4, C22 = U3 + M5
+            add(M[0], M[1], C11, h, v);
+            add(M[0], M[5], M[0], h, v);    // M1 := U2
+            add(M[0], M[6], M[6], h, v);    // M7 := U3
+            add(M[0], M[4], M[0], h, v);    // M1 := U4
+            add(M[0], M[2], C12, h, v);
+            sub(M[6], M[3], C21, h, v);
+            add(M[6], M[4], C22, h, v);
+
+            arena.release(old_top);
+        }
+
+        //   Sequential recursion
+        template <class T>
+        void strassen(View<T> A, View<T> B, View<T> C, size_t n, size_t k,
+                size_t m, size_t levels, Arena<T> &arena)
+        {
+            if (levels == 0) {
+                multiply_blocked(A, B, C, n, k, m);
+                return;
+            }
+
+            winograd_level(A, B, C, n, k, m, arena,
+                    [&](View<T> *X, View<T> *Y, View<T> *M) {
+                        for (size_t i = 0; i < 7; ++i) {
+                            strassen(X[i], Y[i], M[i], n / 2, k / 2, m / 2,
+                                    levels - 1, arena);
+                        }
+                    });
+        }
+    }
+
+    //   Product of matrices by Strassen-Winograd algorithm. See accuracy
+    // notes at the top of file. 'crossover' - size of blocks which are
+    // multiplied in usual way
+    template <class T>
+    Matrix<T> multiply_fast(const Matrix<T> &A, const Matrix<T> &B,
+            size_t crossover = FM_CROSSOVER)
+    {
+        using namespace FastMultiplyDetail;
+
+        if (A.get_cols() != B.get_rows()) {
+            throw std::invalid_argument("multiply_fast: sizes of matrices "
+                    "do not match");
+        }
+
+        size_t n = A.get_rows(), k = A.get_cols(), m = B.get_cols();
+        crossover = std::max<size_t>(crossover, 1);
+
+        //   Number of levels of recursion: blocks of the last level must
+        // not be smaller than crossover
+        size_t levels = 0;
+        while ((std::min(n, std::min(k, m)) >> (levels + 1)) >= crossover) {
+            ++levels;
+        }
+
+        if (levels == 0) {
+            return A * B;
+        }
+
+        //   Padded sizes
+        size_t mask = (size_t(1) << levels) - 1;
+        size_t np = (n + mask) & ~mask, kp = (k + mask) & ~mask;
+        size_t mp = (m + mask) & ~mask;
+
+        size_t lda = kp + FM_ROW_PADDING, ldb = mp + FM_ROW_PADDING;
+        size_t ldc = mp + FM_ROW_PADDING;
+
+        std::vector<T> a(np * lda, T(0)), b(kp * ldb, T(0)), c(np * ldc);
+        for (size_t i = 0; i < n; ++i) {
+            std::copy(A[i].begin(), A[i].end(), a.begin() + i * lda);
+        }
+        for (size_t i = 0; i < k; ++i) {
+            std::copy(B[i].begin(), B[i].end(), b.begin() + i * ldb);
+        }
+
+        //   Top level: 7 products in parallel, each has its own part of
+        // arena
+        size_t child_size = arena_size(np / 2, kp / 2, mp / 2, levels - 1);
+        size_t top_size = arena_size(np, kp, mp, 1);
+        std::vector<T> memory(top_size + 7 * child_size);
+
+        Arena<T> arena(memory.data(), top_size);
+        winograd_level(View<T>{ a.data(), lda }, View<T>{ b.data(), ldb },
+                View<T>{ c.data(), ldc }, np, kp, mp, arena,
+                [&](View<T> *X, View<T> *Y, View<T> *M) {
+                    Parallel::parallel_for(0, 7, [&](size_t i) {
+                        Arena<T> child(memory.data() + top_size +
+                                i * child_size, child_size);
+                        strassen(X[i], Y[i], M[i], np / 2, kp / 2, mp / 2,
+                                levels - 1, child);
+                    });
+                });
+
+        Matrix<T> C(n, m);
+        for (size_t i = 0; i < n; ++i) {
+            std::copy(c.begin() + i * ldc, c.begin() + i * ldc + m,
+                    C[i].begin());
+        }
+        return C;
+    }
+}
+
+#endif // FAST_MULTIPLY_INCLUDE_GUARD
@@ -0,0 +1,3 @@
+// fixed_matrix.cpp
+
+#include "fixed_matrix.h"
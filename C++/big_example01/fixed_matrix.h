@@ -0,0 +1,424 @@
+// fixed_matrix.h
+
+//   Definition and implementation of class FixedMatrix: matrix with sizes
+// known at compile time. Elements are stored in array inside object (on
+// stack), so there is no memory allocation, and all loops have constant
+// bounds. Multiplication is unrolled completely at compile time,
+// determinant and inverse matrix of sizes 1-3 are computed by explicit
+// formulas. Bigger sizes use gauss method with maximum pivot in column
+// which works on copy of array (loops with constant bounds, which
+// compiler may unroll, and no allocation). It's meant for small matrices
+// (2x2 - 8x8)
+
+
+#ifndef FIXED_MATRIX_INCLUDE_GUARD
+#define FIXED_MATRIX_INCLUDE_GUARD
+
+#include <iostream>          // ostream
+#include <initializer_list>  // initializer_list
+#include <utility>           // index_sequence, make_index_sequence, swap
+#include <cmath>             // abs
+#include <stdexcept>         // invalid_argument, out_of_range, domain_error
+#include <string>            // string
+#include "matrix.h"
+#include "gaussian_method.h"
+
+template <class T, size_t R, size_t C>
+class FixedMatrix
+{
+    static_assert(R > 0 && C > 0, "FixedMatrix: sizes must be positive");
+
+public:
+    using value_type = T;
+    using row_type = T[C];
+
+private:
+    T data[R][C];
+
+public:
+    //   Matrix of zeros
+    constexpr FixedMatrix() : data{} {}
+
+    //   Matrix from list of rows: FixedMatrix<double, 2, 2>{{1, 2}, {3, 4}}
+    constexpr FixedMatrix(std::initializer_list<std::initializer_list<T>> rows)
+        : data{}
+    {
+        if (rows.size() != R) {
+            throw std::invalid_argument("class FixedMatrix: wrong number "
+                    "of rows");
+        }
+
+        size_t i = 0;
+        for (const auto &row : rows) {
+            if (row.size() != C) {
+                throw std::invalid_argument("class FixedMatrix: wrong "
+                        "number of columns");
+            }
+
+            size_t j = 0;
+            for (const T &val : row) {
+                data[i][j++] = val;
+            }
+            ++i;
+        }
+    }
+
+    //   Conversion from dynamic matrix. Sizes must match
+    explicit FixedMatrix(const Matrix<T> &M)
+        : data{}
+    {
+        if (M.get_rows() != R || M.get_cols() != C) {
+            throw std::invalid_argument("class FixedMatrix: sizes of "
+                    "matrices do not match");
+        }
+
+        for (size_t i = 0; i < R; ++i) {
+            const std::vector<T> &row = M[i];
+            for (size_t j = 0; j < C; ++j) {
+                data[i][j] = row[j];
+            }
+        }
+    }
+
+    //   Conversion to dynamic matrix
+    Matrix<T> to_matrix() const
+    {
+        Matrix<T> M(R, C);
+        for (size_t i = 0; i < R; ++i) {
+            std::vector<T> &row = M[i];
+            for (size_t j = 0; j < C; ++j) {
+                row[j] = data[i][j];
+            }
+        }
+        return M;
+    }
+
+    //   Getters
+    static constexpr size_t get_rows() { return R; }
+    static constexpr size_t get_cols() { return C; }
+
+    //   Access to row without check of bounds
+    constexpr row_type &operator[] (size_t i) { return data[i]; }
+    constexpr const row_type &operator[] (size_t i) const { return data[i]; }
+
+    //   Access to row with check of bounds
+    row_type &at(size_t i)
+    {
+        if (i >= R) {
+            throw std::out_of_range("class FixedMatrix: index of row is out "
+                    "of matrix");
+        }
+        return data[i];
+    }
+
+    //   Identity matrix
+    static constexpr FixedMatrix get_I()
+    {
+        static_assert(R == C, "FixedMatrix: identity matrix must be square");
+
+        FixedMatrix I;
+        for (size_t i = 0; i < R; ++i) {
+            I.data[i][i] = T(1);
+        }
+        return I;
+    }
+
+    constexpr FixedMatrix<T, C, R> get_transposed() const
+    {
+        FixedMatrix<T, C, R> res;
+        for (size_t i = 0; i < R; ++i) {
+            for (size_t j = 0; j < C; ++j) {
+                res[j][i] = data[i][j];
+            }
+        }
+        return res;
+    }
+};
+
+
+//   Helpers for complete unrolling of loops: loops over index_sequence are
+// expanded into sequence of statements at compile time
+namespace FixedMatrixDetail
+{
+    //   Sum of A[i][k] * B[k][j] over all k
+    template <class T, size_t R, size_t K, size_t C, size_t ...k>
+    constexpr T dot(const FixedMatrix<T, R, K> &A,
+            const FixedMatrix<T, K, C> &B, size_t i, size_t j,
+            std::index_sequence<k...>)
+    {
+        T res = T(0);
+        int unused[] = { (res += A[i][k] * B[k][j], 0)... };
+        (void) unused;
+        return res;
+    }
+
+    //   Element 'e' of product is element (e / C, e % C)
+    template <class T, size_t R, size_t K, size_t C, size_t ...e>
+    constexpr FixedMatrix<T, R, C> multiply(const FixedMatrix<T, R, K> &A,
+            const FixedMatrix<T, K, C> &B, std::index_sequence<e...>)
+    {
+        FixedMatrix<T, R, C> res;
+        int unused[] = { (res[e / C][e % C] = dot(A, B, e / C, e % C,
+                std::make_index_sequence<K>()), 0)... };
+        (void) unused;
+        return res;
+    }
+
+    //   Elementwise operation
+    template <class T, size_t R, size_t C, class F, size_t ...e>
+    constexpr FixedMatrix<T, R, C> elementwise(const FixedMatrix<T, R, C> &A,
+            const FixedMatrix<T, R, C> &B, F op, std::index_sequence<e...>)
+    {
+        FixedMatrix<T, R, C> res;
+        int unused[] = { (res[e / C][e % C] =
+                op(A[e / C][e % C], B[e / C][e % C]), 0)... };
+        (void) unused;
+        return res;
+    }
+
+    //   Direct motion of gauss method with maximum pivot in column. Rows
+    // are swapped inside arrays, so nothing is allocated. Returns
+    // determinant of A (A is changed)
+    template <class T, size_t N>
+    T eliminate(FixedMatrix<T, N, N> &A)
+    {
+        T det = T(1);
+        for (size_t k = 0; k < N; ++k) {
+            size_t pivot = k;
+            for (size_t i = k + 1; i < N; ++i) {
+                if (std::abs(A[i][k]) > std::abs(A[pivot][k])) {
+                    pivot = i;
+                }
+            }
+
+            if (GaussianJordanElimination::check_is_zero(A[pivot][k])) {
+                return T(0);
+            }
+
+            if (pivot != k) {
+                std::swap(A[k], A[pivot]);
+                det = -det;
+            }
+            det *= A[k][k];
+
+            for (size_t i = k + 1; i < N; ++i) {
+                T coef = A[i][k] / A[k][k];
+                for (size_t j = k + 1; j < N; ++j) {
+                    A[i][j] -= coef * A[k][j];
+                }
+            }
+        }
+        return det;
+    }
+
+    //   Gauss-Jordan elimination with maximum pivot in column: A X = B is
+    // solved in place of B. Returns false if A is degenerate
+    template <class T, size_t N, size_t M>
+    bool gauss_jordan(FixedMatrix<T, N, N> &A, FixedMatrix<T, N, M> &B)
+    {
+        for (size_t k = 0; k < N; ++k) {
+            size_t pivot = k;
+            for (size_t i = k + 1; i < N; ++i) {
+                if (std::abs(A[i][k]) > std::abs(A[pivot][k])) {
+                    pivot = i;
+                }
+            }
+
+            if (GaussianJordanElimination::check_is_zero(A[pivot][k])) {
+                return false;
+            }
+
+            if (pivot != k) {
+                std::swap(A[k], A[pivot]);
+                std::swap(B[k], B[pivot]);
+            }
+
+            for (size_t i = k + 1; i < N; ++i) {
+                T coef = A[i][k] / A[k][k];
+                for (size_t j = k + 1; j < N; ++j) {
+                    A[i][j] -= coef * A[k][j];
+                }
+                for (size_t c = 0; c < M; ++c) {
+                    B[i][c] -= coef * B[k][c];
+                }
+            }
+        }
+
+        for (size_t k = N; k-- > 0; ) {
+            for (size_t c = 0; c < M; ++c) {
+                B[k][c] /= A[k][k];
+            }
+            for (size_t i = 0; i < k; ++i) {
+                T coef = A[i][k];
+                for (size_t c = 0; c < M; ++c) {
+                    B[i][c] -= coef * B[k][c];
+                }
+            }
+        }
+        return true;
+    }
+}
+
+
+template <class T, size_t R, size_t K, size_t C>
+constexpr FixedMatrix<T, R, C> operator * (const FixedMatrix<T, R, K> &A,
+        const FixedMatrix<T, K, C> &B)
+{
+    return FixedMatrixDetail::multiply(A, B,
+            std::make_index_sequence<R * C>());
+}
+
+template <class T, size_t R, size_t C>
+constexpr FixedMatrix<T, R, C> operator + (const FixedMatrix<T, R, C> &A,
+        const FixedMatrix<T, R, C> &B)
+{
+    return FixedMatrixDetail::elementwise(A, B,
+            [](const T &a, const T &b) { return a + b; },
+            std::make_index_sequence<R * C>());
+}
+
+template <class T, size_t R, size_t C>
+constexpr FixedMatrix<T, R, C> operator - (const FixedMatrix<T, R, C> &A,
+        const FixedMatrix<T, R, C> &B)
+{
+    return FixedMatrixDetail::elementwise(A, B,
+            [](const T &a, const T &b) { return a - b; },
+            std::make_index_sequence<R * C>());
+}
+
+template <class T, size_t R, size_t C>
+constexpr bool operator == (const FixedMatrix<T, R, C> &A,
+        const FixedMatrix<T, R, C> &B)
+{
+    for (size_t i = 0; i < R; ++i) {
+        for (size_t j = 0; j < C; ++j) {
+            if (A[i][j] != B[i][j]) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+template <class T, size_t R, size_t C>
+std::ostream &operator << (std::ostream &out, const FixedMatrix<T, R, C> &A)
+{
+    return out << A.to_matrix();
+}
+
+
+namespace MatrixFunctions
+{
+    //   Determinant of fixed size matrix (direct motion of gauss method).
+    // Sizes 1-3 are computed by explicit formulas below
+    template <class T, size_t N>
+    T determinant(const FixedMatrix<T, N, N> &A)
+    {
+        FixedMatrix<T, N, N> TMP = A;
+        return FixedMatrixDetail::eliminate(TMP);
+    }
+
+    template <class T>
+    constexpr T determinant(const FixedMatrix<T, 1, 1> &A)
+    {
+        return A[0][0];
+    }
+
+    template <class T>
+    constexpr T determinant(const FixedMatrix<T, 2, 2> &A)
+    {
+        return A[0][0] * A[1][1] - A[0][1] * A[1][0];
+    }
+
+    template <class T>
+    constexpr T determinant(const FixedMatrix<T, 3, 3> &A)
+    {
+        return A[0][0] * (A[1][1] * A[2][2] - A[1][2] * A[2][1]) -
+               A[0][1] * (A[1][0] * A[2][2] - A[1][2] * A[2][0]) +
+               A[0][2] * (A[1][0] * A[2][1] - A[1][1] * A[2][0]);
+    }
+
+    //   Inverse matrix of fixed size matrix (Gauss-Jordan elimination)
+    template <class T, size_t N>
+    FixedMatrix<T, N, N> inverse_matrix(const FixedMatrix<T, N, N> &A)
+    {
+        FixedMatrix<T, N, N> TMP = A;
+        auto B = FixedMatrix<T, N, N>::get_I();
+
+        if (!FixedMatrixDetail::gauss_jordan(TMP, B)) {
+            throw std::invalid_argument("'inverse_matrix: inverse "
+                    "matrix exists only for nondegenerate matrix");
+        }
+
+        return B;
+    }
+
+    //   For sizes 1-3 inverse matrix is adjugate matrix divided by
+    // determinant
+    template <class T>
+    T checked_determinant(const T &det)
+    {
+        if (GaussianJordanElimination::check_is_zero(det)) {
+            throw std::invalid_argument("'inverse_matrix: inverse matrix "
+                    "exists only for nondegenerate matrix");
+        }
+        return det;
+    }
+
+    template <class T>
+    FixedMatrix<T, 1, 1> inverse_matrix(const FixedMatrix<T, 1, 1> &A)
+    {
+        return {{ T(1) / checked_determinant(A[0][0]) }};
+    }
+
+    template <class T>
+    FixedMatrix<T, 2, 2> inverse_matrix(const FixedMatrix<T, 2, 2> &A)
+    {
+        T det = checked_determinant(determinant(A));
+        return {{  A[1][1] / det, -A[0][1] / det },
+                { -A[1][0] / det,  A[0][0] / det }};
+    }
+
+    template <class T>
+    FixedMatrix<T, 3, 3> inverse_matrix(const FixedMatrix<T, 3, 3> &A)
+    {
+        T det = checked_determinant(determinant(A));
+
+        //   Cofactor of element (j, i) is placed to (i, j). With cyclic
+        // order of rows and columns signs of cofactors come out by
+        // themselves
+        FixedMatrix<T, 3, 3> res;
+        for (size_t i = 0; i < 3; ++i) {
+            for (size_t j = 0; j < 3; ++j) {
+                size_t r1 = (j + 1) % 3, r2 = (j + 2) % 3;
+                size_t c1 = (i + 1) % 3, c2 = (i + 2) % 3;
+                res[i][j] = (A[r1][c1] * A[r2][c2] -
+                        A[r1][c2] * A[r2][c1]) / det;
+            }
+        }
+        return res;
+    }
+}
+
+
+namespace SLESolvers
+{
+    //   Solver of SLE with fixed size matrices (gauss method with finding
+    // maximum pivot). All columns of f are solved
+    template <class T, size_t N, size_t M>
+    FixedMatrix<T, N, M> solve(const FixedMatrix<T, N, N> &A,
+            const FixedMatrix<T, N, M> &f)
+    {
+        FixedMatrix<T, N, N> TMP = A;
+        FixedMatrix<T, N, M> x = f;
+
+        if (!FixedMatrixDetail::gauss_jordan(TMP, x)) {
+            throw std::domain_error("solve: left part of SLE is "
+                    "degenerate");
+        }
+
+        return x;
+    }
+}
+
+#endif // FIXED_MATRIX_INCLUDE_GUARD
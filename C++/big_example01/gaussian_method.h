@@ -9,8 +9,11 @@
 #define GAUSSIAN_METHOD_INCLUDE_GUARD
 
 #include "matrix.h"
-#include <utility>  // swap
-#include <cmath>    // abs
+#include "instrumentation.h"
+#include <utility>      // swap, declval
+#include <cmath>        // abs
+#include <vector>       // vector
+#include <type_traits>  // decay
 
 namespace GaussianJordanElimination
 {
@@ -32,6 +35,13 @@ namespace GaussianJordanElimination
         return std::abs(val) <= EPS;
     }
 
+    //   Type of elements of matrix type M. Methods which change matrices
+    // in place work with any matrix type which has 'get_rows', 'get_cols'
+    // and 'operator[]' returning row (Matrix<T>, FixedMatrix<T, R, C>)
+    template <class M>
+    using matrix_element_t = 
+            typename std::decay<decltype(std::declval<M &>()[0][0])>::type;
+
     // DIRECT MOTION
 
     //   A - main part of system, B - right part of system.
@@ -39,9 +49,11 @@ namespace GaussianJordanElimination
     //   Returns number of swaps occured during the method work. 
     // Is's necessary for computing determinant: when swap occured 
     // the sign of determinant changes
-    template <class T, class F>
-    size_t direct_motion(Matrix<T> &A, Matrix<T> &B, F find_pivot)
+    template <class MA, class MB, class F>
+    size_t direct_motion(MA &A, MB &B, F find_pivot)
     {
+        using T = matrix_element_t<MA>;
+
         //   If sizes of matrices are not the same we can't continue
         if (A.get_rows() != B.get_rows()) {
             throw std::invalid_argument(
@@ -64,11 +76,15 @@ namespace GaussianJordanElimination
 
             //   'ccol' is current column
             int pivot;
-            for (; ccol < A.get_cols(); ++ccol) {
-                pivot = find_pivot(row, ccol, A);
-
-                if (pivot < A.get_rows()) {
-                    break;
+            {
+                SLE_INSTR_SCOPE(pivot_search_time);
+                for (; ccol < A.get_cols(); ++ccol) {
+                    pivot = find_pivot(row, ccol, A);
+                    SLE_INSTR_ADD(pivot_searches, 1);
+
+                    if (pivot < A.get_rows()) {
+                        break;
+                    }
                 }
             }
 
@@ -82,11 +98,15 @@ namespace GaussianJordanElimination
                 std::swap(B[row], B[pivot]);
 
                 ++cnt_swaps;
+                SLE_INSTR_ADD(pivot_swaps, 1);
             }
 
             //   Here we perform all necessary operations with matrix
             // such that in current column all elements starting with
             // 'row' row are zeros. 'crow' is current row
+            SLE_INSTR_SCOPE(row_update_time);
+            SLE_INSTR_ADD(flops, uint64_t(A.get_rows() - row - 1) * 
+                    (1 + 2 * (A.get_cols() - ccol) + 2 * B.get_cols()));
             for (int crow = row + 1; crow < A.get_rows(); ++crow) {
                 T coef = A[crow][ccol] / A[row][ccol];
 
@@ -104,10 +124,10 @@ namespace GaussianJordanElimination
     }
 
     //   Direct motion for case when B is omitted
-    template <class T, class F>
-    size_t direct_motion(Matrix<T> &A, F find_pivot)
+    template <class MA, class F>
+    size_t direct_motion(MA &A, F find_pivot)
     {
-        Matrix<T> TMP(A.get_rows(), 0);
+        Matrix<matrix_element_t<MA>> TMP(A.get_rows(), 0);
 
         return direct_motion(A, TMP, find_pivot);
     }
@@ -169,19 +189,21 @@ namespace GaussianJordanElimination
         // element in column)
         template <class T>
         auto find_pivot_usual = 
-        [](size_t row, size_t col, const Matrix<T> &A)
+        [](size_t row, size_t col, const auto &A)
         {
             int pivot;
             for (pivot = row; pivot < A.get_rows() &&
                     check_is_zero(A[pivot][col]); ++pivot) {}
 
+            SLE_INSTR_ADD(pivot_candidates, 
+                    std::min<size_t>(pivot + 1, A.get_rows()) - row);
             return pivot;
         };
 
         //   'find_pivot' which finds maximum element in column
         template <class T>
         auto find_pivot_max_element = 
-        [](size_t row, size_t col, const Matrix<T> &A)
+        [](size_t row, size_t col, const auto &A)
         {
             //   'crow' is current row
             int pivot = row;
@@ -195,6 +217,7 @@ namespace GaussianJordanElimination
                 pivot = A.get_rows();
             }
 
+            SLE_INSTR_ADD(pivot_candidates, A.get_rows() - row);
             return pivot;
         };
     }
@@ -241,9 +264,11 @@ namespace GaussianJordanElimination
 
     //   A - main part of system, B - right part of system
     //   This method makes counter motion of Gaussian-Jordan elimination.
-    template <class T>
-    void counter_motion(Matrix<T> &A, Matrix<T> &B)
+    template <class MA, class MB>
+    void counter_motion(MA &A, MB &B)
     {
+        using T = matrix_element_t<MA>;
+
         if (A.get_rows() != B.get_rows()) {
             throw std::invalid_argument(
                     exception_matrices_rows_size_do_not_match);
@@ -265,6 +290,7 @@ namespace GaussianJordanElimination
             }
         }
 
+        SLE_INSTR_SCOPE(back_substitution_time);
         for (int row = (int) A.get_rows() - 1; row >= 0; --row) {
             //   first_nz - first element in row 'row' which is not 
             // equal to zero
@@ -280,6 +306,9 @@ namespace GaussianJordanElimination
                 continue;
             }
 
+            SLE_INSTR_ADD(flops, uint64_t(row + 1) * 
+                    (A.get_cols() - first_nz + B.get_cols()) * 2);
+
             //   Normalizing row
             T main_element = A[row][first_nz];
             for (int col = first_nz; col < A.get_cols(); ++col) {
@@ -306,10 +335,10 @@ namespace GaussianJordanElimination
     }
 
     //   Counter motion for case when B is omitted.
-    template <class T>
-    void counter_motion(Matrix<T> &A)
+    template <class MA>
+    void counter_motion(MA &A)
     {
-        Matrix<T> TMP(A.get_rows(), 0);
+        Matrix<matrix_element_t<MA>> TMP(A.get_rows(), 0);
 
         counter_motion(A, TMP);
     }
@@ -338,6 +367,194 @@ namespace GaussianJordanElimination
 
         return get_counter_motion(A, TMP).first;
     }
+
+    // LU FACTORIZATION
+
+    //   LU factorization of square matrix: P A = L U, where P is
+    // permutation matrix, L is lower triangular matrix with ones on
+    // diagonal and U is upper triangular. It's the same direct motion,
+    // but coefficients are saved, so the same matrix A can be used to
+    // solve many SLE without repeating of direct motion
+    template <class T>
+    struct LUFactorization
+    {
+        //   L (without diagonal) and U are stored in one matrix
+        Matrix<T> LU;
+
+        //   Row 'i' of P A is row perm[i] of A
+        std::vector<size_t> perm;
+
+        //   Number of swaps (for sign of determinant)
+        size_t cnt_swaps = 0;
+    };
+
+    //   Makes LU factorization. Pivot is chosen by given 'find_pivot'
+    // function (see FindPivotFunctions). Throws domain_error if matrix 
+    // is degenerate
+    template <class T, class F>
+    LUFactorization<T> lu_factorize(const Matrix<T> &A, F find_pivot)
+    {
+        if (A.get_rows() != A.get_cols()) {
+            throw std::invalid_argument(exception_prefix + 
+                    "LU factorization exists only for square matrices");
+        }
+
+        size_t n = A.get_rows();
+
+        LUFactorization<T> res;
+        res.LU = A;
+        res.perm.resize(n);
+        for (size_t i = 0; i < n; ++i) {
+            res.perm[i] = i;
+        }
+
+        Matrix<T> &LU = res.LU;
+        for (size_t k = 0; k < n; ++k) {
+            size_t pivot = find_pivot(k, k, LU);
+            if (pivot >= n) {
+                throw std::domain_error(exception_prefix + 
+                        "matrix is degenerate, LU factorization can't "
+                        "be done");
+            }
+
+            if (pivot != k) {
+                std::swap(LU[k], LU[pivot]);
+                std::swap(res.perm[k], res.perm[pivot]);
+                ++res.cnt_swaps;
+            }
+
+            //   Elimination of elements under pivot. Coefficients are 
+            // stored in place of eliminated elements
+            const std::vector<T> &pivot_row = LU[k];
+            for (size_t row = k + 1; row < n; ++row) {
+                std::vector<T> &cur_row = LU[row];
+
+                T coef = cur_row[k] / pivot_row[k];
+                cur_row[k] = coef;
+
+                for (size_t col = k + 1; col < n; ++col) {
+                    cur_row[col] -= coef * pivot_row[col];
+                }
+            }
+        }
+
+        return res;
+    }
+
+    //   LU factorization with finding maximum pivot in column
+    template <class T>
+    LUFactorization<T> lu_factorize_max_element(const Matrix<T> &A)
+    {
+        return lu_factorize(A, FindPivotFunctions::find_pivot_max_element<T>);
+    }
+
+    //   Solves SLE A X = B using LU factorization of A. All columns of B 
+    // are solved
+    template <class T>
+    Matrix<T> lu_solve(const LUFactorization<T> &F, const Matrix<T> &B)
+    {
+        const Matrix<T> &LU = F.LU;
+        size_t n = LU.get_rows();
+
+        if (B.get_rows() != n) {
+            throw std::invalid_argument(
+                    exception_matrices_rows_size_do_not_match);
+        }
+
+        //   X = P B
+        Matrix<T> X(n, B.get_cols());
+        for (size_t i = 0; i < n; ++i) {
+            X[i] = B[F.perm[i]];
+        }
+
+        //   L Y = P B (forward substitution)
+        for (size_t i = 0; i < n; ++i) {
+            const std::vector<T> &row = LU[i];
+            std::vector<T> &x_row = X[i];
+
+            for (size_t j = 0; j < i; ++j) {
+                const std::vector<T> &x_j = X[j];
+                for (size_t c = 0; c < x_row.size(); ++c) {
+                    x_row[c] -= row[j] * x_j[c];
+                }
+            }
+        }
+
+        //   U X = Y (back substitution)
+        for (size_t i = n; i-- > 0; ) {
+            const std::vector<T> &row = LU[i];
+            std::vector<T> &x_row = X[i];
+
+            for (size_t j = i + 1; j < n; ++j) {
+                const std::vector<T> &x_j = X[j];
+                for (size_t c = 0; c < x_row.size(); ++c) {
+                    x_row[c] -= row[j] * x_j[c];
+                }
+            }
+
+            for (size_t c = 0; c < x_row.size(); ++c) {
+                x_row[c] /= row[i];
+            }
+        }
+
+        return X;
+    }
+
+    //   Solves SLE A^T X = B using LU factorization of A. As P A = L U,
+    // A^T = U^T L^T P, so U^T Y = B and L^T Z = Y are solved and then
+    // rows of Z are put back by permutation. All columns of B are solved
+    template <class T>
+    Matrix<T> lu_solve_transposed(const LUFactorization<T> &F,
+            const Matrix<T> &B)
+    {
+        const Matrix<T> &LU = F.LU;
+        size_t n = LU.get_rows();
+
+        if (B.get_rows() != n) {
+            throw std::invalid_argument(
+                    exception_matrices_rows_size_do_not_match);
+        }
+
+        Matrix<T> Z = B;
+
+        //   U^T Y = B (forward substitution by columns of U)
+        for (size_t i = 0; i < n; ++i) {
+            const std::vector<T> &row = LU[i];
+            std::vector<T> &z_row = Z[i];
+
+            for (size_t c = 0; c < z_row.size(); ++c) {
+                z_row[c] /= row[i];
+            }
+
+            for (size_t j = i + 1; j < n; ++j) {
+                std::vector<T> &z_j = Z[j];
+                for (size_t c = 0; c < z_row.size(); ++c) {
+                    z_j[c] -= row[j] * z_row[c];
+                }
+            }
+        }
+
+        //   L^T Z = Y (back substitution by columns of L)
+        for (size_t i = n; i-- > 0; ) {
+            const std::vector<T> &row = LU[i];
+            const std::vector<T> &z_row = Z[i];
+
+            for (size_t j = 0; j < i; ++j) {
+                std::vector<T> &z_j = Z[j];
+                for (size_t c = 0; c < z_row.size(); ++c) {
+                    z_j[c] -= row[j] * z_row[c];
+                }
+            }
+        }
+
+        //   X = P^T Z
+        Matrix<T> X(n, B.get_cols());
+        for (size_t i = 0; i < n; ++i) {
+            X[F.perm[i]] = Z[i];
+        }
+
+        return X;
+    }
 }
 
 #endif // GAUSSIAN_METHOD_INCLUDE_GUARD
@@ -0,0 +1,3 @@
+// instrumentation.cpp
+
+#include "instrumentation.h"
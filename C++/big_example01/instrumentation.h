@@ -0,0 +1,110 @@
+// instrumentation.h
+
+//   Counters of hot paths of Gaussian elimination and SOR: time of pivot
+// search, row updates, back substitution and SOR sweeps, number of
+// floating point operations, pivot swaps and iterations. They show where
+// time of slow solve goes.
+//   Instrumentation is switched on at compile time by SLE_INSTRUMENTATION
+// ('make INSTRUMENTATION=1'). Without it all SLE_INSTR_* macros expand to
+// nothing, so kernels are the same as without instrumentation.
+//   Counters are kept per thread: call 'reset_stats' before solve and
+// 'get_stats' after it in the same thread
+
+
+#ifndef INSTRUMENTATION_INCLUDE_GUARD
+#define INSTRUMENTATION_INCLUDE_GUARD
+
+#include <iostream>  // ostream
+#include <chrono>    // steady_clock, duration
+#include <cstdint>   // uint64_t
+
+#ifndef SLE_INSTRUMENTATION
+#define SLE_INSTRUMENTATION 0
+#endif
+
+namespace Instrumentation
+{
+    //   Counters of one thread. Times are in seconds
+    struct SolveStats
+    {
+        double pivot_search_time = 0;
+        double row_update_time = 0;
+        double back_substitution_time = 0;
+        double sor_sweep_time = 0;
+
+        uint64_t flops = 0;
+
+        //   Number of calls of 'find_pivot', rows looked through by them
+        // and swaps of rows
+        uint64_t pivot_searches = 0;
+        uint64_t pivot_candidates = 0;
+        uint64_t pivot_swaps = 0;
+
+        uint64_t sor_iterations = 0;
+    };
+
+    //   Counters of calling thread
+    inline SolveStats &get_stats()
+    {
+        static thread_local SolveStats stats;
+        return stats;
+    }
+
+    inline void reset_stats()
+    {
+        get_stats() = SolveStats();
+    }
+
+    //   Adds time from construction to destruction to given counter
+    class ScopedTimer
+    {
+    private:
+        using clock = std::chrono::steady_clock;
+
+        double &counter;
+        clock::time_point start;
+
+    public:
+        explicit ScopedTimer(double &counter_init)
+            : counter(counter_init), start(clock::now())
+        {}
+
+        ~ScopedTimer()
+        {
+            counter += std::chrono::duration<double>(clock::now() -
+                    start).count();
+        }
+
+        ScopedTimer(const ScopedTimer &) = delete;
+        ScopedTimer &operator = (const ScopedTimer &) = delete;
+    };
+
+    inline std::ostream &operator << (std::ostream &out,
+            const SolveStats &stats)
+    {
+        out << "pivot search " << stats.pivot_search_time << " s (" <<
+                stats.pivot_searches << " searches, " <<
+                stats.pivot_candidates << " candidates, " <<
+                stats.pivot_swaps << " swaps), row updates " <<
+                stats.row_update_time << " s, back substitution " <<
+                stats.back_substitution_time << " s, SOR sweeps " <<
+                stats.sor_sweep_time << " s (" << stats.sor_iterations <<
+                " iterations), " << stats.flops << " flops";
+        return out;
+    }
+}
+
+//   SLE_INSTR_SCOPE(field) - time until the end of current scope is added
+// to counter 'field'. SLE_INSTR_ADD(field, value) - adds value to counter
+#if SLE_INSTRUMENTATION
+#define SLE_INSTR_SCOPE(field)                                              \
+    Instrumentation::ScopedTimer sle_instr_timer_##field(                   \
+            Instrumentation::get_stats().field)
+#define SLE_INSTR_ADD(field, value)                                         \
+    (Instrumentation::get_stats().field += (value))
+#else
+#define SLE_INSTR_SCOPE(field) ((void) 0)
+#define SLE_INSTR_ADD(field, value) ((void) 0)
+#endif
+
+#endif // INSTRUMENTATION_INCLUDE_GUARD
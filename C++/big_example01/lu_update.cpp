@@ -0,0 +1,3 @@
+// lu_update.cpp
+
+#include "lu_update.h"
@@ -0,0 +1,204 @@
+// lu_update.h
+
+//   Solving of SLE whose left part differs from matrix with known LU
+// factorization by matrix of low rank. If A = P^T L U is known and
+//     A' = A + U V^T    (U, V - n x k matrices, k << n),
+// then by Sherman-Morrison-Woodbury formula
+//     A'^{-1} B = Y - Z (I + V^T Z)^{-1} V^T Y,  Z = A^{-1} U, Y = A^{-1} B,
+// which takes O(n^2 k) operations instead of O(n^3) for new factorization.
+//   For the case when matrix is changed many times by rank 1 updates, LU
+// factors can be updated in place by Bennett's algorithm in O(n^2). It
+// keeps old permutation and does no pivoting, so pivots of updated matrix
+// can become small, and errors grow with number of updates. It's better
+// to make new factorization from time to time
+
+
+#ifndef LU_UPDATE_INCLUDE_GUARD
+#define LU_UPDATE_INCLUDE_GUARD
+
+#include <vector>     // vector
+#include <stdexcept>  // invalid_argument, domain_error
+#include "matrix.h"
+#include "gaussian_method.h"
+
+namespace GaussianJordanElimination
+{
+    //   Solver of SLE with left part A + U V^T, where LU factorization of A
+    // is known. Everything which doesn't depend on right part is computed
+    // in constructor (k solves with A), so each 'solve' takes O(n^2 m + n k m)
+    // for m right parts. Factorization F must live longer than solver
+    template <class T>
+    class WoodburySolver
+    {
+    private:
+        static const std::string exception_prefix;
+
+        const LUFactorization<T> &F;
+
+        //   Z = A^{-1} U and V
+        Matrix<T> Z, V;
+
+        //   Factorization of capacitance matrix I + V^T Z (k x k)
+        LUFactorization<T> C;
+
+    public:
+        //   Throws domain_error if A + U V^T is degenerate
+        WoodburySolver(const LUFactorization<T> &F_init, const Matrix<T> &U,
+                const Matrix<T> &V_init);
+
+        size_t get_rank() const { return V.get_cols(); }
+
+        //   Solves (A + U V^T) X = B. All columns of B are solved
+        Matrix<T> solve(const Matrix<T> &B) const;
+    };
+
+
+    template <class T>
+    const std::string WoodburySolver<T>::exception_prefix =
+            "class WoodburySolver: ";
+
+    template <class T>
+    WoodburySolver<T>::WoodburySolver(const LUFactorization<T> &F_init,
+            const Matrix<T> &U, const Matrix<T> &V_init)
+        : F(F_init), V(V_init)
+    {
+        size_t n = F.LU.get_rows(), k = U.get_cols();
+
+        if (U.get_rows() != n || V.get_rows() != n || V.get_cols() != k) {
+            throw std::invalid_argument(exception_prefix + "matrices of "
+                    "update must have sizes n x k");
+        }
+
+        Z = lu_solve(F, U);
+
+        //   I + V^T Z
+        Matrix<T> cap = Matrix<T>::get_I(k);
+        for (size_t i = 0; i < n; ++i) {
+            const std::vector<T> &v_row = V[i];
+            const std::vector<T> &z_row = Z[i];
+            for (size_t a = 0; a < k; ++a) {
+                std::vector<T> &cap_row = cap[a];
+                for (size_t b = 0; b < k; ++b) {
+                    cap_row[b] += v_row[a] * z_row[b];
+                }
+            }
+        }
+
+        try {
+            C = lu_factorize_max_element(cap);
+        } catch (std::domain_error &) {
+            throw std::domain_error(exception_prefix + "updated matrix is "
+                    "degenerate");
+        }
+    }
+
+    template <class T>
+    Matrix<T> WoodburySolver<T>::solve(const Matrix<T> &B) const
+    {
+        size_t n = F.LU.get_rows(), k = get_rank();
+        if (B.get_rows() != n) {
+            throw std::invalid_argument(
+                    exception_matrices_rows_size_do_not_match);
+        }
+
+        Matrix<T> X = lu_solve(F, B);
+        if (k == 0) {
+            return X;
+        }
+
+        //   W = (I + V^T Z)^{-1} V^T Y
+        Matrix<T> W(k, B.get_cols(), T(0));
+        for (size_t i = 0; i < n; ++i) {
+            const std::vector<T> &v_row = V[i];
+            const std::vector<T> &x_row = X[i];
+            for (size_t a = 0; a < k; ++a) {
+                std::vector<T> &w_row = W[a];
+                for (size_t c = 0; c < x_row.size(); ++c) {
+                    w_row[c] += v_row[a] * x_row[c];
+                }
+            }
+        }
+        W = lu_solve(C, W);
+
+        //   X = Y - Z W
+        for (size_t i = 0; i < n; ++i) {
+            const std::vector<T> &z_row = Z[i];
+            std::vector<T> &x_row = X[i];
+            for (size_t a = 0; a < k; ++a) {
+                const std::vector<T> &w_row = W[a];
+                for (size_t c = 0; c < x_row.size(); ++c) {
+                    x_row[c] -= z_row[a] * w_row[c];
+                }
+            }
+        }
+
+        return X;
+    }
+
+
+    //   Solves (A + U V^T) X = B, where F is LU factorization of A. Throws
+    // domain_error if A + U V^T is degenerate
+    template <class T>
+    Matrix<T> woodbury_solve(const LUFactorization<T> &F, const Matrix<T> &U,
+            const Matrix<T> &V, const Matrix<T> &B)
+    {
+        return WoodburySolver<T>(F, U, V).solve(B);
+    }
+
+    //   Updates LU factorization of A to factorization of A + u v^T in
+    // place (u, v - vectors of size n) by Bennett's algorithm. As
+    //     P (A + u v^T) = L U + (P u) v^T,
+    // it's rank 1 update of L U with x = P u, y = v. At step 'k' first row
+    // of U and first column of L of remaining part are updated, and rest
+    // of x y^T turns into new rank 1 update of the remaining part:
+    //     u_kk' = u_kk + x_k y_k,
+    //     U[k][j] += x_k y_j,   y_j -= (y_k / u_kk') U[k][j]    (j > k),
+    //     x_i -= x_k L[i][k],   L[i][k] += (y_k / u_kk') x_i    (i > k).
+    // Throws domain_error if some pivot becomes zero. Factorization is
+    // spoiled after that, and new one must be made
+    template <class T>
+    void lu_rank1_update(LUFactorization<T> &F, const Matrix<T> &u,
+            const Matrix<T> &v)
+    {
+        Matrix<T> &LU = F.LU;
+        size_t n = LU.get_rows();
+
+        if (u.get_rows() != n || v.get_rows() != n ||
+                u.get_cols() != 1 || v.get_cols() != 1) {
+            throw std::invalid_argument(exception_prefix + "vectors of rank "
+                    "1 update must have sizes n x 1");
+        }
+
+        std::vector<T> x(n), y(n);
+        for (size_t i = 0; i < n; ++i) {
+            x[i] = u[F.perm[i]][0];
+            y[i] = v[i][0];
+        }
+
+        for (size_t k = 0; k < n; ++k) {
+            std::vector<T> &row_k = LU[k];
+
+            row_k[k] += x[k] * y[k];
+            if (check_is_zero(row_k[k])) {
+                throw std::domain_error(exception_prefix + "pivot of "
+                        "updated LU factorization became zero");
+            }
+
+            const T x_k = x[k];
+            const T coef = y[k] / row_k[k];
+
+            for (size_t j = k + 1; j < n; ++j) {
+                row_k[j] += x_k * y[j];
+                y[j] -= coef * row_k[j];
+            }
+
+            for (size_t i = k + 1; i < n; ++i) {
+                T &l = LU[i][k];
+                x[i] -= x_k * l;
+                l += coef * x[i];
+            }
+        }
+    }
+}
+
+#endif // LU_UPDATE_INCLUDE_GUARD
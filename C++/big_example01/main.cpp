@@ -7,12 +7,18 @@
 //   A main file with code. Here I tesing SLE solvers, count 
 // determinants of some matrices, find inverse matrices, determine whether 
 // Gaussian elimination is stable and count the speed of convergence rate of
-// iterations
+// iterations.
+//   Usage: './main [--residual] [--trace]' or './main --benchmark [runs]'.
+// With '--trace' timeline of all phases is written to TRACE_FILE in Chrome
+// trace format
 
 
 #include <iostream>              // cin, cout
 #include <iomanip>               // setprecision
-#include <fstream>               // ofstream
+#include <sstream>               // ostringstream
+#include <string>                // string, stoul
+#include <vector>                // vector
+#include <functional>            // function
 #include <boost/filesystem.hpp>  // path, create_directory
 
 #include "matrix.h"
@@ -21,12 +27,23 @@
 #include "tests.h"
 #include "matrix_functions.h"
 #include "SLE_solvers.h"
+#include "exact_methods.h"
+#include "fixed_matrix.h"
+#include "fast_multiply.h"
+#include "lu_update.h"
+#include "randomized_svd.h"
+#include "matrix_exponential.h"
+#include "workload_generator.h"
+#include "result_sink.h"
+#include "tracing.h"
 
 using namespace std;
 
 using namespace GaussianJordanElimination;
 using namespace MatrixFunctions;
 using namespace SLESolvers;
+using namespace Results;
+using namespace Workloads;
 using SLESolvers::TesterT;
 using SLESolvers::TesterA;
 
@@ -39,8 +56,19 @@ enum
 {
     //   For random generator
     SEED = 0,
+
+    //   Set to 1 to check stability of Gaussian elimination also by
+    // solving SLE with randomly perturbed left and right parts
+    STABILITY_MONTE_CARLO = 0,
+
+    //   All results are written to one archive (RESULTS_ARCHIVE). Set to 1
+    // to expand it to separate files (tests/test01.txt, ...) at the end
+    EXPAND_RESULTS = 1,
 };
 
+const string RESULTS_ARCHIVE = "results.jsonl";
+const string TRACE_FILE = "trace.json";
+
 template <class T>
 ostream &operator << (ostream &out, const pair<T, T> &a)
 {
@@ -66,13 +94,12 @@ string get_fout_for_test(const string &pref, const string &name,
     return pref + name + to_string(make_zeros + number).substr(1) + type;
 }
 
-//   Write tests from Tester object to given folder
+//   Write tests from Tester object to given folder (in archive of sink)
 template <class T, class A>
-void write_tests_to_folder(const Tester<T, A> &tester, 
+void write_tests_to_folder(const Tester<T, A> &tester, ResultSink &sink,
         string path_to_tests = "tests/")
 {
-    //   Create folder for tests
-    new_folder(path_to_tests);
+    TRACE_SCOPE("write tests", "io");
 
     //   I use these variables to calculate number of digits for 
     // each test number
@@ -81,167 +108,930 @@ void write_tests_to_folder(const Tester<T, A> &tester,
 
     //   Writing tests
     for (int i = 0; i < tester.get_num_tests(); ++i) {
-        ofstream fout(path_to_tests + "/test" + 
-                to_string(make_zeros + i + 1).substr(1) + ".txt");
-        fout << tester.next_test() << endl;
-        fout.close();
+        ostringstream fout;
+        fout << tester.get_test(i) << endl;
+        sink.write(path_to_tests + "/test" + 
+                to_string(make_zeros + i + 1).substr(1) + ".txt", fout.str());
+    }
+}
+
+
+//   Solves SLE Bx = g, where B and g are slightly modified (randomly 
+// perturbed) matrices A and f from test, and finds standard deviation 
+// 'dif' of its solution from solution 'sol1' of Ax = f. Returns false if 
+// perturbed SLE can't be solved
+bool perturbed_deviation(const TesterT<element_type> &test, const Me &sol1,
+        element_type &dif)
+{
+    //   Creating generator of random numbers
+    std::mt19937 gen(SEED);
+    const element_type eps1 = 1e-3;
+    std::uniform_real_distribution<> urd(-eps1, eps1);
+
+    auto B = test.first;
+    for (int row = 0; row < B.get_rows(); ++row) {
+        for (int col = 0; col < B.get_cols(); ++col) {
+            B[row][col] += urd(gen);
+        }
+    }
+
+    auto g = test.second;
+    for (int row = 0; row < g.get_rows(); ++row) {
+        g[row][0] += urd(gen);
+    }
+
+    Me sol2;
+    try {
+        sol2 = SLEGM(B, g);
+    } catch (domain_error &e) {
+        cerr << e.what() << endl;
+        return false;
+    }
+
+    //   Counting standard deviation
+    dif = 0;
+    for (int row = 0; row < sol1.get_rows(); ++row) {
+        dif += pow(sol1[row][0] - sol2[row][0], 2);
+    }
+    dif = sqrt(dif / sol1.get_rows());
+
+    return true;
+}
+
+
+//   Checks of guards of solvers on small matrices which must be rejected.
+// Each check prints [OK] if matrix was rejected and [WA] otherwise
+void check_solver_guards(ostream &out)
+{
+    //   Matrix whose only element out of diagonal (1, 0) has no stored
+    // symmetric pair:
+    //     4 0 0
+    //     1 4 0
+    //     0 0 4
+    Me A(3, 3, 0);
+    A[0][0] = A[1][1] = A[2][2] = 4;
+    A[1][0] = 1;
+    Me f(3, 1, 1);
+
+    SparseMatrix<element_type> S(A);
+
+    //   Check returns true if matrix was rejected
+    vector<pair<string, function<bool()>>> checks = {
+        { "is_symmetric of matrix with one-sided element", [&]() {
+            return !S.is_symmetric();
+        } },
+        { "SLE_SSOR_Chebyshev with nonsymmetric matrix", [&]() {
+            try {
+                SLE_SSOR_Chebyshev(S, f);
+            } catch (domain_error &e) {
+                return true;
+            }
+            return false;
+        } },
+        { "LDL^T sparse direct solver with nonsymmetric matrix", [&]() {
+            try {
+                SLE_sparse_direct(S, f, SD_NATURAL, SD_LDLT);
+            } catch (domain_error &e) {
+                return true;
+            }
+            return false;
+        } },
+    };
+
+    for (size_t i = 0; i < checks.size(); ++i) {
+        out << (checks[i].second() ? "[OK] " : "[WA] ") << "Check #" << 
+                i + 1 << ": " << checks[i].first << endl;
+    }
+}
+
+
+//   Elements are equal with relative precision 'eps'
+bool are_close(element_type a, element_type b, element_type eps = 1e-9)
+{
+    return abs(a - b) <= eps * max<element_type>(1, max(abs(a), abs(b)));
+}
+
+bool are_close(const Me &A, const Me &B)
+{
+    if (A.get_rows() != B.get_rows() || A.get_cols() != B.get_cols()) {
+        return false;
+    }
+
+    for (size_t i = 0; i < A.get_rows(); ++i) {
+        for (size_t j = 0; j < A.get_cols(); ++j) {
+            if (!are_close(A[i][j], B[i][j])) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+//   Determinant, inverse matrix and solution of SLE with FixedMatrix
+// must be the same as with Matrix. Degenerate SLE must be rejected by
+// both solvers
+template <size_t N>
+bool check_fixed_test(const TesterT<element_type> &test)
+{
+    const Me &A = test.first, &f = test.second;
+    FixedMatrix<element_type, N, N> FA(A);
+    FixedMatrix<element_type, N, 1> Ff(f);
+
+    //   Determinant is found by LU factorization, because 'determinant'
+    // of Matrix doesn't count sign of row swaps
+    element_type det = 0;
+    try {
+        auto LU = lu_factorize_max_element(A);
+        det = (LU.cnt_swaps % 2 ? -1 : 1);
+        for (size_t i = 0; i < N; ++i) {
+            det *= LU.LU[i][i];
+        }
+    } catch (domain_error &e) {
+        det = 0;
+    }
+    if (!are_close(determinant(FA), det)) {
+        return false;
+    }
+
+    if (!check_is_zero(det) &&
+            !are_close(inverse_matrix(FA).to_matrix(), inverse_matrix(A))) {
+        return false;
+    }
+
+    Me x;
+    bool solved = true;
+    try {
+        x = SLEGM(A, f);
+    } catch (domain_error &e) {
+        solved = false;
+    }
+
+    try {
+        auto fixed_x = solve(FA, Ff);
+        return solved && are_close(fixed_x.to_matrix(), x);
+    } catch (domain_error &e) {
+        return !solved;
+    }
+}
+
+//   Checks FixedMatrix on all tests with square left part of size 2-8.
+// Bigger tests are checked on their leading 8x8 block. Sizes are
+// template arguments, so there is a check for each size
+void check_fixed_matrices(const Tester<TesterT<element_type>,
+        TesterA<element_type>> &tester, ostream &out)
+{
+    vector<function<bool(const TesterT<element_type> &)>> checks = {
+        nullptr, nullptr,
+        check_fixed_test<2>, check_fixed_test<3>, check_fixed_test<4>,
+        check_fixed_test<5>, check_fixed_test<6>, check_fixed_test<7>,
+        check_fixed_test<8>,
+    };
+    const size_t max_size = checks.size() - 1;
+
+    for (int i = 0; i < tester.get_num_tests(); ++i) {
+        const auto &test = tester.get_test(i);
+        size_t n = test.first.get_rows();
+        if (n != test.first.get_cols() || !checks[min(n, max_size)]) {
+            continue;
+        }
+
+        TesterT<element_type> block = test;
+        if (n > max_size) {
+            n = max_size;
+            block.first = Me(n, n);
+            block.second = Me(n, 1);
+            for (size_t row = 0; row < n; ++row) {
+                for (size_t col = 0; col < n; ++col) {
+                    block.first[row][col] = test.first[row][col];
+                }
+                block.second[row][0] = test.second[row][0];
+            }
+        }
+
+        out << (checks[n](block) ? "[OK] " : "[WA] ") << "Test #" <<
+                i + 1 << " (" << n << "x" << n << ")" << endl;
+    }
+}
+
+
+//   Matrix with random elements from [-1, 1]
+Me random_matrix(size_t rows, size_t cols, mt19937 &gen)
+{
+    uniform_real_distribution<element_type> urd(-1, 1);
+
+    Me A(rows, cols);
+    for (size_t i = 0; i < rows; ++i) {
+        for (size_t j = 0; j < cols; ++j) {
+            A[i][j] = urd(gen);
+        }
+    }
+    return A;
+}
+
+//   Checks multiply_fast against operator* on odd and non-square sizes
+// above crossover (with one small crossover for deeper recursion).
+// Strassen-Winograd has only normwise error bound, so error is compared
+// with k max|A| max|B| (k is inner size)
+void check_multiply_fast(ostream &out)
+{
+    struct Case
+    {
+        size_t n, k, m, crossover;
+    };
+    vector<Case> cases = {
+        { 301, 257, 199, FM_CROSSOVER },
+        { 257, 301, 129, FM_CROSSOVER },
+        { 193, 211, 227, 32 },
+    };
+
+    mt19937 gen(SEED);
+    for (size_t i = 0; i < cases.size(); ++i) {
+        const Case &c = cases[i];
+        Me A = random_matrix(c.n, c.k, gen), B = random_matrix(c.k, c.m, gen);
+        Me C = multiply_fast(A, B, c.crossover), D = A * B;
+
+        element_type error = 0;
+        for (size_t row = 0; row < c.n; ++row) {
+            for (size_t col = 0; col < c.m; ++col) {
+                error = max(error, abs(C[row][col] - D[row][col]));
+            }
+        }
+
+        out << (error <= c.k * 1e-12 ? "[OK] " : "[WA] ") << "Check #" <<
+                i + 1 << ": " << c.n << "x" << c.k << " by " << c.k << "x" <<
+                c.m << ", crossover " << c.crossover << endl;
+    }
+}
+
+
+//   Relative difference of solutions in max norm
+element_type relative_difference(const Me &x, const Me &y)
+{
+    element_type diff = 0, norm = 0;
+    for (size_t i = 0; i < x.get_rows(); ++i) {
+        for (size_t j = 0; j < x.get_cols(); ++j) {
+            diff = max(diff, abs(x[i][j] - y[i][j]));
+            norm = max(norm, abs(y[i][j]));
+        }
+    }
+    return diff / max<element_type>(norm, 1);
+}
+
+//   Checks solvers of SLE with updated left part on all tests with
+// nondegenerate A. Solutions of (A + U V^T) x = f by Woodbury formula
+// (rank 2) and by updated LU factorization (rank 1) are compared with
+// SLEGM. Update u e_1^T with u = -(first column of A) makes first column
+// zero, and both solvers must throw domain_error for it
+void check_low_rank_updates(const Tester<TesterT<element_type>,
+        TesterA<element_type>> &tester, ostream &out)
+{
+    const size_t k = 2;
+    const element_type eps = 1e-6;
+    mt19937 gen(SEED);
+
+    for (int i = 0; i < tester.get_num_tests(); ++i) {
+        const auto &test = tester.get_test(i);
+        const Me &A = test.first, &f = test.second;
+        size_t n = A.get_rows();
+        if (n != A.get_cols() || n < k) {
+            continue;
+        }
+
+        LUFactorization<element_type> LU;
+        try {
+            LU = lu_factorize_max_element(A);
+        } catch (domain_error &e) {
+            continue;
+        }
+
+        //   Update has elements of the same magnitude as A
+        element_type max_abs = 0;
+        for (size_t row = 0; row < n; ++row) {
+            for (size_t col = 0; col < n; ++col) {
+                max_abs = max(max_abs, abs(A[row][col]));
+            }
+        }
+        Me U = random_matrix(n, k, gen), V = random_matrix(n, k, gen);
+        for (size_t row = 0; row < n; ++row) {
+            for (size_t col = 0; col < k; ++col) {
+                U[row][col] *= max_abs;
+            }
+        }
+
+        //   Solution of updated SLE by SLEGM. Empty matrix if it's
+        // degenerate
+        auto reference = [&](const Me &UU, const Me &VV) {
+            Me B = A, update = UU * VV.get_transposed();
+            for (size_t row = 0; row < n; ++row) {
+                for (size_t col = 0; col < n; ++col) {
+                    B[row][col] += update[row][col];
+                }
+            }
+            try {
+                return SLEGM(B, f);
+            } catch (domain_error &e) {
+                return Me();
+            }
+        };
+
+        //   True if solver gives the same answer as SLEGM or both of them
+        // reject updated SLE
+        auto check = [&](const Me &UU, const Me &VV,
+                function<Me()> solver) {
+            Me x_ref = reference(UU, VV);
+            try {
+                Me x = solver();
+                return x_ref.get_rows() != 0 &&
+                        relative_difference(x, x_ref) <= eps;
+            } catch (domain_error &e) {
+                return x_ref.get_rows() == 0;
+            }
+        };
+
+        Me u(n, 1), v(n, 1, 0);
+        for (size_t row = 0; row < n; ++row) {
+            u[row][0] = U[row][0];
+            v[row][0] = V[row][0];
+        }
+
+        Me zero_u(n, 1), zero_v(n, 1, 0);
+        for (size_t row = 0; row < n; ++row) {
+            zero_u[row][0] = -A[row][0];
+        }
+        zero_v[0][0] = 1;
+
+        vector<pair<string, bool>> results = {
+            { "Woodbury", check(U, V, [&]() {
+                return woodbury_solve(LU, U, V, f);
+            }) },
+            { "rank 1 LU update", check(u, v, [&]() {
+                auto F = LU;
+                lu_rank1_update(F, u, v);
+                return lu_solve(F, f);
+            }) },
+            { "degenerate Woodbury", check(zero_u, zero_v, [&]() {
+                return woodbury_solve(LU, zero_u, zero_v, f);
+            }) },
+            { "degenerate rank 1 LU update", check(zero_u, zero_v, [&]() {
+                auto F = LU;
+                lu_rank1_update(F, zero_u, zero_v);
+                return lu_solve(F, f);
+            }) },
+        };
+
+        string failed;
+        for (const auto &res : results) {
+            if (!res.second) {
+                failed += (failed.empty() ? "" : ", ") + res.first;
+            }
+        }
+        out << (failed.empty() ? "[OK] " : "[WA] ") << "Test #" << i + 1 <<
+                (failed.empty() ? "" : ": " + failed) << endl;
+    }
+}
+
+
+//   Checks randomized SVD on matrices X Y^T of known rank (X, Y - random
+// m x r and n x r matrices). Estimated rank (by randomized_svd and by
+// rank_randomized) must be equal to r and to rank found by gauss method,
+// and U diag(S) V^T must restore matrix
+void check_randomized_svd(ostream &out)
+{
+    struct Case
+    {
+        size_t m, n, r;
+    };
+    vector<Case> cases = {
+        { 300, 200, 7 },
+        { 150, 257, 1 },
+        { 211, 211, 40 },
+    };
+
+    const size_t extra = 5;
+    const element_type eps = 1e-10;
+    mt19937 gen(SEED);
+
+    for (size_t i = 0; i < cases.size(); ++i) {
+        const Case &c = cases[i];
+        Me A = random_matrix(c.m, c.r, gen) *
+                random_matrix(c.n, c.r, gen).get_transposed();
+
+        auto svd = randomized_svd(A, c.r + extra);
+        size_t rank_gauss = rank_matrix(A);
+
+        element_type max_abs = 0, error = 0;
+        for (size_t row = 0; row < c.m; ++row) {
+            for (size_t col = 0; col < c.n; ++col) {
+                element_type val = 0;
+                for (size_t a = 0; a < svd.S.size(); ++a) {
+                    val += svd.U[row][a] * svd.S[a] * svd.V[col][a];
+                }
+                max_abs = max(max_abs, abs(A[row][col]));
+                error = max(error, abs(A[row][col] - val));
+            }
+        }
+
+        bool ok = svd.rank == c.r && rank_gauss == c.r &&
+                rank_randomized(A, c.r + extra) == c.r &&
+                error <= eps * max_abs;
+        out << (ok ? "[OK] " : "[WA] ") << "Check #" << i + 1 << ": " <<
+                c.m << "x" << c.n << " of rank " << c.r << ", randomized " <<
+                svd.rank << ", gauss " << rank_gauss << endl;
+    }
+}
+
+
+//   Checks exact methods on tests with integer square left part: rank
+// modulo primes must be equal to rank found by gauss method, and
+// determinant by Bareiss elimination (if it doesn't overflow) must be
+// equal to determinant by p-adic lifting
+void check_exact_methods(const Tester<TesterT<element_type>,
+        TesterA<element_type>> &tester, ostream &out)
+{
+    for (int i = 0; i < tester.get_num_tests(); ++i) {
+        const Me &A = tester.get_test(i).first;
+        if (A.get_rows() != A.get_cols() || !is_integer_matrix(A)) {
+            continue;
+        }
+
+        size_t rank = rank_matrix(A), rank_ex = rank_exact(A);
+        BigInteger det = determinant_exact(A);
+        bool ok = (rank == rank_ex);
+
+        string bareiss = "overflow";
+        try {
+            long long det_bareiss = determinant_bareiss(A);
+            ok = ok && BigInteger(det_bareiss) == det;
+            bareiss = to_string(det_bareiss);
+        } catch (overflow_error &e) {}
+
+        out << (ok ? "[OK] " : "[WA] ") << "Test #" << i + 1 << ": rank " <<
+                rank << " (exact " << rank_ex << "), determinant " << det <<
+                " (Bareiss " << bareiss << ")" << endl;
+    }
+}
+
+
+//   Checks matrix exponential on linear systems of ODE with known
+// solution: harmonic oscillator u' = v, v' = -u (u = cos t, v = -sin t
+// for u(0) = 1, v(0) = 0) and decay u' = -u, v' = -50 v. Action of
+// exponential on vectors is also compared with product by exponential
+void check_matrix_exponential(ostream &out)
+{
+    const element_type eps = 1e-12;
+
+    //   Max norm of difference
+    auto error = [](const Me &A, const Me &B) {
+        element_type res = 0;
+        for (size_t i = 0; i < A.get_rows(); ++i) {
+            for (size_t j = 0; j < A.get_cols(); ++j) {
+                res = max(res, abs(A[i][j] - B[i][j]));
+            }
+        }
+        return res;
+    };
+
+    Me rotation({ { 0, 1 }, { -1, 0 } });
+    Me decay({ { -1, 0 }, { 0, -50 } });
+    Me u0 = Me({ { 1, 0 } }).get_transposed();
+    Me v0 = Me({ { 1, 1 } }).get_transposed();
+
+    vector<element_type> times;
+    for (int j = 1; j <= 20; ++j) {
+        times.push_back(0.5 * j);
+    }
+    Me oscillator_exact(2, times.size()), decay_exact(2, times.size());
+    for (size_t j = 0; j < times.size(); ++j) {
+        oscillator_exact[0][j] = cos(times[j]);
+        oscillator_exact[1][j] = -sin(times[j]);
+        decay_exact[0][j] = exp(-times[j]);
+        decay_exact[1][j] = exp(-50 * times[j]);
+    }
+
+    //   exp(t A) for rotation is rotation by angle t. Big t needs many
+    // squarings
+    const element_type t = 30;
+    Me tA = rotation;
+    for (size_t i = 0; i < 2; ++i) {
+        for (size_t j = 0; j < 2; ++j) {
+            tA[i][j] *= t;
+        }
+    }
+    Me rotation_exact({ { cos(t), sin(t) }, { -sin(t), cos(t) } });
+
+    mt19937 gen(SEED);
+    Me M = random_matrix(60, 60, gen), B = random_matrix(60, 3, gen);
+
+    vector<pair<string, bool>> checks = {
+        { "harmonic oscillator by solve_linear_ODE",
+            error(solve_linear_ODE(rotation, u0, times),
+                    oscillator_exact) <= eps },
+        { "decay by solve_linear_ODE",
+            error(solve_linear_ODE(decay, v0, times), decay_exact) <= eps },
+        { "expm of rotation by angle 30",
+            error(expm(tA), rotation_exact) <= eps },
+        { "expm_multiply against expm on random 60x60 matrix",
+            error(expm_multiply(M, B), expm(M) * B) <=
+                    1e-10 * max<element_type>(1, norm_1(expm(M))) },
+    };
+
+    for (size_t i = 0; i < checks.size(); ++i) {
+        out << (checks[i].second ? "[OK] " : "[WA] ") << "Check #" <<
+                i + 1 << ": " << checks[i].first << endl;
     }
 }
 
 
-int main()
+//   Checks generator of synthetic SLE: SLE of each structure is solved by
+// 'solve' and answer is checked by relative residual and by distance to
+// exact solution (it's bounded by condition number), then SLE is written
+// in binary format and read back
+void check_workload_generator(ostream &out)
 {
-    write_tests_to_folder<TesterT<element_type>, TesterA<element_type>>(
-            Tests::create_tester_with_tests<element_type>());
+    const size_t n = 300;
+    const element_type eps = 1e-13;
+
+    vector<pair<string, WorkloadStructure>> structures = {
+        { "dense", WORKLOAD_DENSE },
+        { "diagonally dominant", WORKLOAD_DIAGONALLY_DOMINANT },
+        { "SPD", WORKLOAD_SPD },
+        { "banded", WORKLOAD_BANDED },
+        { "sparse", WORKLOAD_SPARSE },
+        { "ill-conditioned", WORKLOAD_ILL_CONDITIONED },
+    };
+
+    //   Matrices are equal exactly
+    auto equal = [](const Me &A, const Me &B) {
+        if (A.get_rows() != B.get_rows() || A.get_cols() != B.get_cols()) {
+            return false;
+        }
+        for (size_t i = 0; i < A.get_rows(); ++i) {
+            if (A[i] != B[i]) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    for (size_t i = 0; i < structures.size(); ++i) {
+        WorkloadParams params;
+        params.structure = structures[i].second;
+        params.n = n;
+        params.bandwidth = 3;
+        params.seed = SEED;
+
+        WorkloadGenerator<element_type> generator(params);
+        Workload<element_type> workload = generator.generate();
+
+        string failed;
+        auto fail = [&failed](const string &what) {
+            failed += (failed.empty() ? "" : ", ") + what;
+        };
+
+        try {
+            Me x = solve(workload.A, workload.f);
+            if (!(relative_residual(workload.A, x, workload.f) <= eps)) {
+                fail("residual");
+            }
+            if (!(solution_error(workload, x) <=
+                    eps * condition_number(workload.A))) {
+                fail("solution error");
+            }
+        } catch (domain_error &e) {
+            fail(e.what());
+        }
+
+        stringstream binary(ios::in | ios::out | ios::binary);
+        generator.write_binary(binary);
+        Workload<element_type> read = read_workload_binary<element_type>(
+                binary);
+        if (!equal(read.A, workload.A) || !equal(read.f, workload.f) ||
+                !equal(read.x, workload.x)) {
+            fail("binary round trip");
+        }
+
+        out << (failed.empty() ? "[OK] " : "[WA] ") << "Check #" << i + 1 <<
+                ": " << structures[i].first << " " << n << "x" << n <<
+                (failed.empty() ? "" : ": " + failed) << endl;
+    }
+}
+
+
+//   Benchmark mode: './main --benchmark [runs]'. Solvers are not tested,
+// only time of each of them is measured on all tests, and results are
+// written to folder 'benchmark/' in JSON and CSV
+void run_benchmarks(size_t runs)
+{
+    const string path = "benchmark/";
+    new_folder(path);
+
+    vector<pair<string, SLE_solver_type<element_type>>> solvers = {
+        { "SLEGU", SLEGU },
+        { "SLEGM", SLEGM },
+        { "SLE_SOR", SLE_SOR_standard },
+        { "SLE_SOR_multicolor", SLE_SOR_multicolor_standard },
+        { "SLE_SOR_block", SLE_SOR_block_standard },
+        { "SLE_SSOR_Chebyshev", SLE_SSOR_Chebyshev_standard },
+        { "SLE_multigrid", SLE_multigrid_standard },
+        { "SLE_sparse_direct", SLE_sparse_direct_standard },
+        { "solve", solve_standard },
+        { "SLE_mixed_precision", SLE_mixed_precision_standard },
+        { "SLE_batched", SLE_batched_standard },
+    };
+
+    for (const auto &solver : solvers) {
+        cout << "Benchmarking " << solver.first << endl;
+        auto results = benchmark_SLE_solver<element_type>(solver.second, 
+                solver.first, runs, path);
+
+        for (const auto &res : results) {
+            cout << "\tTest #" << res.test << ": ";
+            if (res.failed) {
+                cout << "failed" << endl;
+                continue;
+            }
+            cout << "median " << res.median_time << " s, p99 " << 
+                    res.p99_time << " s, " << res.flop_rate / 1e9 << 
+                    " GFLOP/s, " << res.allocations << " allocations";
+            if (res.perf_available) {
+                cout << ", IPC " << res.ipc << ", L1 MPKI " << res.l1_mpki <<
+                        ", LLC MPKI " << res.llc_mpki;
+            }
+            cout << endl;
+        }
+    }
+}
+
+
+int main(int argc, char **argv)
+{
+    if (argc > 1 && string(argv[1]) == "--benchmark") {
+        run_benchmarks(argc > 2 ? stoul(argv[2]) : TESTER_BENCHMARK_RUNS);
+        return 0;
+    }
+
+    //   With '--residual' answers of solvers are checked by residual, so
+    // tests without right answer are checked too
+    SLE_check_mode check_mode = SLE_CHECK_ANSWER;
+    bool trace = false;
+    for (int i = 1; i < argc; ++i) {
+        if (string(argv[i]) == "--residual") {
+            check_mode = SLE_CHECK_RESIDUAL;
+        } else if (string(argv[i]) == "--trace") {
+            trace = true;
+        }
+    }
+
+    if (trace) {
+        Tracing::start();
+    }
+
+    //   All phases share one set of tests. It's generated here, on first 
+    // use, and only read after that
+    auto tests = Tests::get_shared_tests<element_type>();
+    const auto &tester = *tests;
+
+    //   Results of all phases are written by background thread. Folders
+    // of results aren't touched until archive is expanded, then they are
+    // cleared all at once
+    ResultSink sink(RESULTS_ARCHIVE);
+    vector<string> output_folders;
+
+    const string path_to_tests = "tests/";
+    output_folders.push_back(path_to_tests);
+    write_tests_to_folder(tester, sink, path_to_tests);
+
+    auto test_solver = [&](SLE_solver_type<element_type> solver, 
+            const string &path_to_answers) {
+        TRACE_SCOPE(path_to_answers, "phase");
+        output_folders.push_back(path_to_answers);
+        test_SLE_solver<element_type>(solver, path_to_answers, cout, 
+                check_mode, 1e-8, &sink);
+    };
 
     //   Testing SLEGU
     cout << "Testing SLEGU\n";
-    test_SLE_solver<element_type>(SLEGU, "answer_SLEGU/");
+    test_solver(SLEGU, "answer_SLEGU/");
     cout << endl;
 
     //   Testing SLEGM
     cout << "Testing SLEGM\n";
-    test_SLE_solver<element_type>(SLEGM, "answer_SLEGM/");
+    test_solver(SLEGM, "answer_SLEGM/");
     cout << endl;
 
     //   Testing SLE_SOR
     cout << "Testing SLE_SOR\n";
-    test_SLE_solver<element_type>(SLE_SOR_standard, "answer_SLE_SOR/");
+    test_solver(SLE_SOR_standard, "answer_SLE_SOR/");
+    cout << endl;
+
+    //   Testing multicolor SOR
+    cout << "Testing SLE_SOR_multicolor\n";
+    test_solver(SLE_SOR_multicolor_standard, "answer_SLE_SOR_multicolor/");
+    cout << endl;
+
+    //   Testing block Jacobi-SOR
+    cout << "Testing SLE_SOR_block\n";
+    test_solver(SLE_SOR_block_standard, "answer_SLE_SOR_block/");
+    cout << endl;
+
+    //   Testing SSOR with Chebyshev acceleration
+    cout << "Testing SLE_SSOR_Chebyshev\n";
+    test_solver(SLE_SSOR_Chebyshev_standard, "answer_SLE_SSOR_Chebyshev/");
+    cout << endl;
+
+    //   Testing multigrid solver
+    cout << "Testing SLE_multigrid\n";
+    test_solver(SLE_multigrid_standard, "answer_SLE_multigrid/");
+    cout << endl;
+
+    //   Testing sparse direct solver
+    cout << "Testing SLE_sparse_direct\n";
+    test_solver(SLE_sparse_direct_standard, "answer_SLE_sparse_direct/");
+    cout << endl;
+
+    //   Testing automatic choice of solver
+    cout << "Testing solve\n";
+    test_solver(solve_standard, "answer_solve/");
+    cout << endl;
+
+    //   Testing mixed precision solver
+    cout << "Testing SLE_mixed_precision\n";
+    test_solver(SLE_mixed_precision_standard, "answer_SLE_mixed_precision/");
+    cout << endl;
+
+    //   Testing batched solver of small SLE
+    cout << "Testing SLE_batched\n";
+    test_solver(SLE_batched_standard, "answer_SLE_batched/");
+    cout << endl;
+
+    //   Checking that solvers reject matrices which they can't solve
+    cout << "Checking guards of solvers\n";
+    check_solver_guards(cout);
+    cout << endl;
+
+    //   Checking matrices with sizes known at compile time
+    cout << "Checking FixedMatrix\n";
+    check_fixed_matrices(tester, cout);
+    cout << endl;
+
+    //   Checking Strassen-Winograd multiplication
+    cout << "Checking multiply_fast\n";
+    check_multiply_fast(cout);
+    cout << endl;
+
+    //   Checking solvers of SLE with low rank update of left part
+    cout << "Checking low rank updates\n";
+    check_low_rank_updates(tester, cout);
+    cout << endl;
+
+    //   Checking rank and low rank approximation by randomized SVD
+    cout << "Checking randomized_svd\n";
+    check_randomized_svd(cout);
+    cout << endl;
+
+    //   Checking exact rank and determinant of integer matrices
+    cout << "Checking exact methods\n";
+    check_exact_methods(tester, cout);
+    cout << endl;
+
+    //   Checking exponential of matrix on linear systems of ODE
+    cout << "Checking matrix exponential\n";
+    check_matrix_exponential(cout);
+    cout << endl;
+
+    //   Checking generator of big SLE with known solution
+    cout << "Checking workload generator\n";
+    check_workload_generator(cout);
     cout << endl;
 
     //   Finding determinants
     cout << "Finding determinants" << endl;
 
     const string determinants = "determinants/";
-    new_folder(determinants);
+    output_folders.push_back(determinants);
 
     // Determinants are stored here
     vector<element_type> dets;
 
-    auto tester = Tests::create_tester_with_tests<element_type>();
     for (int i = 0; i < tester.get_num_tests(); ++i) {
-        auto det = determinant(tester.next_test().first);
+        TRACE_SCOPE("determinant", "phase", i + 1);
+
+        const auto &A = tester.get_test(i).first;
+        auto det = determinant(A);
         dets.push_back(det);
 
         // Print found determinant
-        ofstream fout(get_fout_for_test(determinants, "det", i + 1,
-                tester.get_num_tests()));
+        ostringstream fout;
         fout << det << endl;
-        fout.close();
+
+        //   Determinant of integer matrix is also found exactly
+        if (is_integer_matrix(A)) {
+            fout << determinant_exact(A) << endl;
+        }
+        sink.write(get_fout_for_test(determinants, "det", i + 1,
+                tester.get_num_tests()), fout.str());
     }
 
     //   Finding inverse matrices
     cout << "Finding inverse matrices" << endl;
 
     const string inverse_matrices = "inverse_matrices/";
-    new_folder(inverse_matrices);
+    output_folders.push_back(inverse_matrices);
 
-    tester = Tests::create_tester_with_tests<element_type>();
     for (int i = 0; i < tester.get_num_tests(); ++i) {
         if (check_is_zero(dets[i])) {
-            tester.next_test();
             continue;
         }
+        TRACE_SCOPE("inverse matrix", "phase", i + 1);
 
         // Print found inverse matrix
-        ofstream fout(get_fout_for_test(inverse_matrices, "inv", i + 1,
-                tester.get_num_tests()));
-        fout << inverse_matrix(tester.next_test().first) << endl;
-        fout.close();
+        ostringstream fout;
+        fout << inverse_matrix(tester.get_test(i).first) << endl;
+        sink.write(get_fout_for_test(inverse_matrices, "inv", i + 1,
+                tester.get_num_tests()), fout.str());
     }
 
-    //   Determine whether Gaussian elimination is stable
+    //   Determine whether Gaussian elimination is stable. Condition number
+    // of A bounds relative error of solution: 
+    //     ||dx|| / ||x|| <= cond(A) (||dA|| / ||A|| + ||df|| / ||f||),
+    // it's estimated in O(n^2) by LU factorization which is used for
+    // solving. If STABILITY_MONTE_CARLO is set, SLE is also solved with
+    // randomly perturbed A and f, and deviation of solution is printed
     cout << "Determining Gaussian elimination stability" << endl;
 
     const string stability = "gauss_stability/";
-    new_folder(stability);
+    output_folders.push_back(stability);
 
+    element_type max_cond = 0;
     element_type max_deviation = 0;
 
-    tester = Tests::create_tester_with_tests<element_type>();
     for (int i = 0; i < tester.get_num_tests(); ++i) {
-        //   Creating generator of random numbers
-        std::mt19937 gen(SEED);
-        const element_type eps1 = 1e-3;
-        std::uniform_real_distribution<> urd(-eps1, eps1);
+        TRACE_SCOPE("stability", "phase", i + 1);
 
-        auto test = tester.next_test();
-        auto A = test.first;
-        auto f = test.second;
+        const auto &test = tester.get_test(i);
+        const auto &A = test.first;
+        const auto &f = test.second;
 
         //   Solving SLE Ax = f
-        Me sol1;
+        LUFactorization<element_type> LU;
         try {
-            sol1 = SLEGM(A, f);
+            LU = lu_factorize_max_element(A);
         } catch (domain_error &e) {
             cerr << e.what() << endl;
             continue;
         }
+        Me sol1 = lu_solve(LU, f);
 
-        //   Solving SLE Bx = g, where B and g are slightly modified matrices 
-        // A and f
-        auto B = test.first;
-        for (int row = 0; row < A.get_rows(); ++row) {
-            for (int col = 0; col < A.get_cols(); ++col) {
-                B[row][col] += urd(gen);
-            }
-        }
-
-        auto g = test.second;
-        for (int row = 0; row < g.get_rows(); ++row) {
-            g[row][0] += urd(gen);
-        }
+        element_type cond = condition_number(A, LU);
+        max_cond = max(max_cond, cond);
 
-        Me sol2;
-        try {
-            sol2 = SLEGM(B, g);
-        } catch (domain_error &e) {
-            cerr << e.what() << endl;
-            continue;
-        }
+        //   Print it out
+        ostringstream fout;
+        fout << cond << endl;
 
-        //   Counting standard deviation
-        element_type dif = 0;
-        for (int row = 0; row < sol1.get_rows(); ++row) {
-            dif += pow(sol1[row][0] - sol2[row][0], 2);
+        element_type dif;
+        if (STABILITY_MONTE_CARLO && perturbed_deviation(test, sol1, dif)) {
+            max_deviation = max(max_deviation, dif);
+            fout << dif << endl;
         }
-        dif = sqrt(dif / sol1.get_rows());
 
-        max_deviation = max(max_deviation, dif);
-
-        //   Print it out
-        ofstream fout(get_fout_for_test(stability, "stab", i + 1,
-                tester.get_num_tests()));
-        fout << dif << endl;
-        fout.close();
+        sink.write(get_fout_for_test(stability, "stab", i + 1,
+                tester.get_num_tests()), fout.str());
+    }
+    cout << "\tMaximum condition number: " << max_cond << endl;
+    if (STABILITY_MONTE_CARLO) {
+        cout << "\tMaximum standard deviation: " << max_deviation << endl;
     }
-    cout << "\tMaximum standard deviation: " << max_deviation << endl;
     
     
     //   Counting speed of convergence rate of iterations
     cout << "Counting speed of convergence rate of iterations" << endl;
 
     const string iter_cov = "iter_convergance/";
-    new_folder(iter_cov);
+    output_folders.push_back(iter_cov);
 
-    tester = Tests::create_tester_with_tests<element_type>();
     for (int i = 0; i < tester.get_num_tests(); ++i) {
-        auto test = tester.next_test();
-        auto A = test.first;
-        auto f = test.second;
+        TRACE_SCOPE("convergence", "phase", i + 1);
+
+        const auto &test = tester.get_test(i);
+        const auto &A = test.first;
+        const auto &f = test.second;
 
         const double eps2 = 1e-3;
 
         int min_iters = -1;
         double wmin = -1;
 
+        //   One SOR engine is used for all w, so memory is allocated once
+        SOREngine<element_type> engine(A.get_rows(), f.get_cols());
+
         //   Looking for minimum number of iterations for every w with 
         // step eps2
         for (double w = eps2; w <= 2 - eps2; w += eps2) {
             //   Run SOR solver with w and count number of iterations
             int iters = -1;
             try {
-                SLE_SOR(A, f, w, &iters);
+                iters = engine.solve(A, f, w);
             } catch (domain_error &e) {
                 cerr << e.what() << endl;
                 continue;
@@ -259,10 +1049,23 @@ int main()
         }
 
         // Print minimum number of iterations and coresponding w
-        ofstream fout(get_fout_for_test(iter_cov, "cov", i + 1,
-                tester.get_num_tests()));
+        ostringstream fout;
         fout << min_iters << " (" << wmin << ")" << endl;
-        fout.close();
+        sink.write(get_fout_for_test(iter_cov, "cov", i + 1,
+                tester.get_num_tests()), fout.str());
+    }
+
+    sink.close();
+    if (EXPAND_RESULTS) {
+        for (const string &folder : output_folders) {
+            new_folder(folder);
+        }
+        expand_archive(RESULTS_ARCHIVE);
+    }
+
+    if (trace) {
+        Tracing::stop();
+        Tracing::write_trace(TRACE_FILE);
     }
 
     return 0;
@@ -14,6 +14,7 @@
 #include <cmath>     // abs
 #include <sstream>   // stringstream
 #include <random>    // mt19937, uniform_real_distribution
+#include <algorithm> // min
 
 
 //   Matrix class. I use it to store matrices and to operate with them
@@ -43,6 +44,13 @@ private:
         OUTPUT_PREC = 2,
     };
 
+    //   Sizes of blocks in matrix multiplication
+    enum matrix_multiply_blocks
+    {
+        MULT_BLOCK_ROWS = 128,
+        MULT_BLOCK_COLS = 512,
+    };
+
     //   Exception's messages
     static const std::string exception_prefix;
     static const std::string exception_out_of_range;
@@ -398,12 +406,33 @@ Matrix<T> operator * (const Matrix<T> &A, const Matrix<T> &B)
                 exception_matrices_sizes_do_not_match);
     }
 
-    Matrix<T> C(A.get_rows(), B.get_cols(), 0);
-
-    for (int i = 0; i < A.get_rows(); ++i) {
-        for (int j = 0; j < B.get_cols(); ++j) {
-            for (int k = 0; k < B.get_rows(); ++k) {
-                C[i][j] += A[i][k] * B[k][j];
+    size_t n = A.get_rows(), m = B.get_rows(), p = B.get_cols();
+    Matrix<T> C(n, p, 0);
+
+    //   Loops are in order i-k-j, so the inner loop goes along rows of B
+    // and C (it's vectorized). Columns of C and B are processed by blocks
+    // of MULT_BLOCK_COLS and rows of B by blocks of MULT_BLOCK_ROWS, so
+    // block of B stays in cache while it's used for all rows of A. Each
+    // C[i][j] still gets its summands in order of increasing k
+    for (size_t jj = 0; jj < p; jj += Matrix<T>::MULT_BLOCK_COLS) {
+        size_t j_end = std::min<size_t>(p, jj + Matrix<T>::MULT_BLOCK_COLS);
+
+        for (size_t kk = 0; kk < m; kk += Matrix<T>::MULT_BLOCK_ROWS) {
+            size_t k_end = std::min<size_t>(m, kk + 
+                    Matrix<T>::MULT_BLOCK_ROWS);
+
+            for (size_t i = 0; i < n; ++i) {
+                const std::vector<T> &a_row = A[i];
+                T *c_row = C[i].data();
+
+                for (size_t k = kk; k < k_end; ++k) {
+                    const T a = a_row[k];
+                    const T *b_row = B[k].data();
+
+                    for (size_t j = jj; j < j_end; ++j) {
+                        c_row[j] += a * b_row[j];
+                    }
+                }
             }
         }
     }
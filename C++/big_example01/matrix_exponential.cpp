@@ -0,0 +1,3 @@
+// matrix_exponential.cpp
+
+#include "matrix_exponential.h"
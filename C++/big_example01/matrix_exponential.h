@@ -0,0 +1,313 @@
+// matrix_exponential.h
+
+//   Exponential of matrix and its action on vectors. They give solution
+// of linear system of ODE with constant coefficients
+//     u' = A u,  u(0) = u0   =>   u(t) = exp(t A) u0
+// at any point t without steps of Runge-Kutta methods.
+//   'expm' - scaling and squaring method with Pade approximants (Higham,
+// 2005): A is divided by 2^s so that ||A / 2^s||_1 <= theta_m, exp of it
+// is approximated by Pade approximant r_m = q_m^{-1} p_m of degree m
+// (3, 5, 7, 9 or 13), then result is squared s times. Degree and s are
+// chosen by ||A||_1 so that backward error is not bigger than unit
+// roundoff of double. It takes 6 + s products of n x n matrices (by
+// blocked multiplication) and one LU solve.
+//   'expm_multiply' - exp(t A) B for n x k matrix B without computing
+// exp(t A) (Al-Mohy, Higham, 2011, simplified): A is shifted by
+// trace(A) / n I, interval is split into s steps with ||h A||_1 <=
+// EXPM_STEP_NORM, and on each step Taylor series is summed until its
+// terms become negligible. It takes O(n^2 k) operations per term, which
+// is much less than O(n^3) of 'expm' when k << n
+
+
+#ifndef MATRIX_EXPONENTIAL_INCLUDE_GUARD
+#define MATRIX_EXPONENTIAL_INCLUDE_GUARD
+
+#include <vector>     // vector
+#include <limits>     // numeric_limits
+#include <stdexcept>  // invalid_argument
+#include <algorithm>  // max
+#include <cmath>      // abs, exp, log2, ceil, ldexp
+#include "matrix.h"
+#include "gaussian_method.h"
+#include "matrix_functions.h"
+
+namespace MatrixFunctions
+{
+    //   Maximum norm of h A on one step of 'expm_multiply' and maximum
+    // number of terms of Taylor series on one step
+    enum Expm_constants
+    {
+        EXPM_STEP_NORM = 2,
+        EXPM_MAX_TERMS = 60,
+    };
+
+    namespace ExpmDetail
+    {
+        //   Coefficients of Pade approximants of degrees 3, 5, 7, 9, 13
+        // and maximum norms of A for them
+        const double b3[] = { 120, 60, 12, 1 };
+        const double b5[] = { 30240, 15120, 3360, 420, 30, 1 };
+        const double b7[] = { 17297280, 8648640, 1995840, 277200, 25200,
+                1512, 56, 1 };
+        const double b9[] = { 17643225600., 8821612800., 2075673600.,
+                302702400, 30270240, 2162160, 110880, 3960, 90, 1 };
+        const double b13[] = { 64764752532480000., 32382376266240000.,
+                7771770303897600., 1187353796428800., 129060195264000.,
+                10559470521600., 670442572800., 33522128640., 1323241920.,
+                40840800, 960960, 16380, 182, 1 };
+
+        const double theta3 = 1.495585217958292e-2;
+        const double theta5 = 2.539398330063230e-1;
+        const double theta7 = 9.504178996162932e-1;
+        const double theta9 = 2.097847961257068e0;
+        const double theta13 = 5.371920351148152e0;
+
+        //   R = R + c X
+        template <class T>
+        void add_scaled(Matrix<T> &R, const Matrix<T> &X, T c)
+        {
+            for (size_t i = 0; i < R.get_rows(); ++i) {
+                std::vector<T> &r_row = R[i];
+                const std::vector<T> &x_row = X[i];
+                for (size_t j = 0; j < r_row.size(); ++j) {
+                    r_row[j] += c * x_row[j];
+                }
+            }
+        }
+
+        //   R = R + c I
+        template <class T>
+        void add_identity(Matrix<T> &R, T c)
+        {
+            for (size_t i = 0; i < R.get_rows(); ++i) {
+                R[i][i] += c;
+            }
+        }
+
+        //   Maximum absolute value of elements
+        template <class T>
+        T max_norm(const Matrix<T> &A)
+        {
+            T res = 0;
+            for (size_t i = 0; i < A.get_rows(); ++i) {
+                for (const T &val : A[i]) {
+                    res = std::max(res, std::abs(val));
+                }
+            }
+            return res;
+        }
+
+        //   Pade approximant r_m(A) = (V - U)^{-1} (V + U) of degree m
+        // (3, 5, 7 or 9), U - odd part, V - even part
+        template <class T>
+        Matrix<T> pade(const Matrix<T> &A, const double *b, size_t m)
+        {
+            size_t n = A.get_rows();
+
+            //   Even powers of A
+            std::vector<Matrix<T>> powers(1, A * A);
+            for (size_t k = 4; k < m; k += 2) {
+                powers.push_back(powers.back() * powers[0]);
+            }
+
+            Matrix<T> U = Matrix<T>::get_I(n), V = Matrix<T>::get_I(n);
+            for (size_t i = 0; i < n; ++i) {
+                U[i][i] = T(b[1]);
+                V[i][i] = T(b[0]);
+            }
+            for (size_t k = 2; k < m; k += 2) {
+                add_scaled(U, powers[k / 2 - 1], T(b[k + 1]));
+                add_scaled(V, powers[k / 2 - 1], T(b[k]));
+            }
+            U = A * U;
+
+            Matrix<T> P = V, Q = V;
+            add_scaled(P, U, T(1));
+            add_scaled(Q, U, T(-1));
+
+            return GaussianJordanElimination::lu_solve(
+                    GaussianJordanElimination::lu_factorize_max_element(Q), P);
+        }
+
+        //   Pade approximant of degree 13. Powers A^8, A^10, A^12 are not
+        // computed: U and V are evaluated by Horner's scheme in A^6
+        template <class T>
+        Matrix<T> pade13(const Matrix<T> &A)
+        {
+            const double *b = b13;
+            size_t n = A.get_rows();
+
+            Matrix<T> A2 = A * A, A4 = A2 * A2, A6 = A4 * A2;
+
+            Matrix<T> W(n, n, T(0));
+            add_scaled(W, A6, T(b[13]));
+            add_scaled(W, A4, T(b[11]));
+            add_scaled(W, A2, T(b[9]));
+            Matrix<T> U = A6 * W;
+            add_scaled(U, A6, T(b[7]));
+            add_scaled(U, A4, T(b[5]));
+            add_scaled(U, A2, T(b[3]));
+            add_identity(U, T(b[1]));
+            U = A * U;
+
+            Matrix<T> Z(n, n, T(0));
+            add_scaled(Z, A6, T(b[12]));
+            add_scaled(Z, A4, T(b[10]));
+            add_scaled(Z, A2, T(b[8]));
+            Matrix<T> V = A6 * Z;
+            add_scaled(V, A6, T(b[6]));
+            add_scaled(V, A4, T(b[4]));
+            add_scaled(V, A2, T(b[2]));
+            add_identity(V, T(b[0]));
+
+            Matrix<T> P = V, Q = V;
+            add_scaled(P, U, T(1));
+            add_scaled(Q, U, T(-1));
+
+            return GaussianJordanElimination::lu_solve(
+                    GaussianJordanElimination::lu_factorize_max_element(Q), P);
+        }
+    }
+
+    //   Exponential of square matrix
+    template <class T>
+    Matrix<T> expm(const Matrix<T> &A)
+    {
+        using namespace ExpmDetail;
+
+        if (A.get_rows() != A.get_cols()) {
+            throw std::invalid_argument("expm: matrix must be square");
+        }
+
+        T norm = norm_1(A);
+        if (norm <= T(theta3)) {
+            return pade(A, b3, 3);
+        }
+        if (norm <= T(theta5)) {
+            return pade(A, b5, 5);
+        }
+        if (norm <= T(theta7)) {
+            return pade(A, b7, 7);
+        }
+        if (norm <= T(theta9)) {
+            return pade(A, b9, 9);
+        }
+
+        //   Scaling by 2^s
+        int s = std::max(0, (int) std::ceil(std::log2(norm / T(theta13))));
+        Matrix<T> X = A;
+        T scale = std::ldexp(T(1), -s);
+        for (size_t i = 0; i < X.get_rows(); ++i) {
+            for (T &val : X[i]) {
+                val *= scale;
+            }
+        }
+
+        X = pade13(X);
+        for (int i = 0; i < s; ++i) {
+            X = X * X;
+        }
+        return X;
+    }
+
+    //   exp(t A) B. All columns of B are processed
+    template <class T>
+    Matrix<T> expm_multiply(const Matrix<T> &A, const Matrix<T> &B, T t = 1)
+    {
+        using namespace ExpmDetail;
+
+        if (A.get_rows() != A.get_cols()) {
+            throw std::invalid_argument("expm_multiply: matrix must be "
+                    "square");
+        }
+        if (A.get_rows() != B.get_rows()) {
+            throw std::invalid_argument("expm_multiply: matrices must have "
+                    "the same number of rows");
+        }
+
+        size_t n = A.get_rows();
+        if (n == 0) {
+            return B;
+        }
+
+        //   Shift: exp(t A) = exp(t mu) exp(t (A - mu I))
+        T mu = 0;
+        for (size_t i = 0; i < n; ++i) {
+            mu += A[i][i];
+        }
+        mu /= T(n);
+
+        Matrix<T> S = A;
+        add_identity(S, -mu);
+
+        T norm = std::abs(t) * norm_1(S);
+        size_t steps = std::max<size_t>(1,
+                (size_t) std::ceil(norm / T(EXPM_STEP_NORM)));
+        T h = t / T(steps);
+        T eta = std::exp(mu * h);
+        const T tol = std::numeric_limits<T>::epsilon();
+
+        Matrix<T> F = B;
+        for (size_t step = 0; step < steps; ++step) {
+            Matrix<T> term = F;
+            T prev_norm = max_norm(term);
+
+            //   Series stops when two consecutive terms are negligible
+            for (size_t k = 1; k <= EXPM_MAX_TERMS; ++k) {
+                term = S * term;
+                T coef = h / T(k);
+                for (size_t i = 0; i < n; ++i) {
+                    for (T &val : term[i]) {
+                        val *= coef;
+                    }
+                }
+                add_scaled(F, term, T(1));
+
+                T cur_norm = max_norm(term);
+                if (prev_norm + cur_norm <= tol * max_norm(F)) {
+                    break;
+                }
+                prev_norm = cur_norm;
+            }
+
+            for (size_t i = 0; i < n; ++i) {
+                for (T &val : F[i]) {
+                    val *= eta;
+                }
+            }
+        }
+
+        return F;
+    }
+
+    //   Solution of linear system of ODE u' = A u, u(0) = u0 at given
+    // points. Column 'j' of result is u(times[j]). Solution is moved from
+    // one point to the next one, so points should go in order
+    template <class T>
+    Matrix<T> solve_linear_ODE(const Matrix<T> &A, const Matrix<T> &u0,
+            const std::vector<T> &times)
+    {
+        if (u0.get_cols() != 1) {
+            throw std::invalid_argument("solve_linear_ODE: initial value "
+                    "must be a column");
+        }
+
+        size_t n = u0.get_rows();
+        Matrix<T> res(n, times.size());
+
+        Matrix<T> u = u0;
+        T cur_time = 0;
+        for (size_t j = 0; j < times.size(); ++j) {
+            u = expm_multiply(A, u, times[j] - cur_time);
+            cur_time = times[j];
+
+            for (size_t i = 0; i < n; ++i) {
+                res[i][j] = u[i][0];
+            }
+        }
+
+        return res;
+    }
+}
+
+#endif // MATRIX_EXPONENTIAL_INCLUDE_GUARD
@@ -8,8 +8,12 @@
 #define EXTRA_MATRIX_INCLUDE_GUARD
 
 #include <vector>              // vector
+#include <algorithm>           // sort, max
+#include <cmath>               // abs
+#include <stdexcept>           // invalid_argument
 #include "matrix.h"
 #include "gaussian_method.h"
+#include "parallel.h"
 
 namespace MatrixFunctions
 {
@@ -93,6 +97,212 @@ namespace MatrixFunctions
 
         return TMP.get_rows();
     }
+
+
+    //   'norm_1' function - 1-norm of matrix (maximum sum of absolute
+    // values of elements of column)
+    template <class T>
+    T norm_1(const Matrix<T> &A)
+    {
+        std::vector<T> sums(A.get_cols(), T(0));
+        for (size_t i = 0; i < A.get_rows(); ++i) {
+            const std::vector<T> &row = A[i];
+            for (size_t j = 0; j < row.size(); ++j) {
+                sums[j] += std::abs(row[j]);
+            }
+        }
+
+        T res = 0;
+        for (T val : sums) {
+            res = std::max(res, val);
+        }
+        return res;
+    }
+
+    //   'inverse_norm_1_estimate' function - estimate of ||A^{-1}||_1 by
+    // Hager's method with Higham's improvements. A is given by its LU
+    // factorization. Method maximizes ||A^{-1} x||_1 over ||x||_1 = 1 by
+    // gradient steps; each step is one solve with A and one with A^T, so
+    // it costs O(n^2) (at most 5 steps). Estimate is never bigger than
+    // real norm and almost always is within factor 3 of it
+    template <class T>
+    T inverse_norm_1_estimate(
+            const GaussianJordanElimination::LUFactorization<T> &F)
+    {
+        using GaussianJordanElimination::lu_solve;
+        using GaussianJordanElimination::lu_solve_transposed;
+
+        const int MAX_STEPS = 5;
+        size_t n = F.LU.get_rows();
+        if (n == 0) {
+            return 0;
+        }
+
+        auto norm = [n](const Matrix<T> &x) {
+            T res = 0;
+            for (size_t i = 0; i < n; ++i) {
+                res += std::abs(x[i][0]);
+            }
+            return res;
+        };
+
+        auto sign = [n](const Matrix<T> &x) {
+            Matrix<T> res(n, 1);
+            for (size_t i = 0; i < n; ++i) {
+                res[i][0] = (x[i][0] >= 0 ? T(1) : T(-1));
+            }
+            return res;
+        };
+
+        auto arg_max = [n](const Matrix<T> &x) {
+            size_t res = 0;
+            for (size_t i = 1; i < n; ++i) {
+                if (std::abs(x[i][0]) > std::abs(x[res][0])) {
+                    res = i;
+                }
+            }
+            return res;
+        };
+
+        //   Start from x = (1/n, ..., 1/n)
+        Matrix<T> x(n, 1, T(1) / T(n));
+        Matrix<T> y = lu_solve(F, x);
+        T est = norm(y);
+
+        if (n == 1) {
+            return est;
+        }
+
+        Matrix<T> xi = sign(y);
+        Matrix<T> z = lu_solve_transposed(F, xi);
+        size_t j = arg_max(z);
+
+        for (int step = 1; step < MAX_STEPS; ++step) {
+            //   x = e_j
+            x = Matrix<T>(n, 1, T(0));
+            x[j][0] = 1;
+            y = lu_solve(F, x);
+
+            T prev_est = est;
+            est = norm(y);
+
+            Matrix<T> new_xi = sign(y);
+            if (new_xi == xi || est <= prev_est) {
+                est = std::max(est, prev_est);
+                break;
+            }
+            xi = new_xi;
+
+            //   Local maximum is reached if ||z||_inf <= z^T x = z_j
+            z = lu_solve_transposed(F, xi);
+            size_t new_j = arg_max(z);
+            if (std::abs(z[new_j][0]) <= std::abs(z[j][0])) {
+                break;
+            }
+            j = new_j;
+        }
+
+        //   Higham's extra vector with alternating signs: it catches
+        // matrices on which gradient steps fail
+        for (size_t i = 0; i < n; ++i) {
+            x[i][0] = (i % 2 ? T(-1) : T(1)) * 
+                    (T(1) + T(i) / T(n - 1));
+        }
+        T alt_est = 2 * norm(lu_solve(F, x)) / (3 * T(n));
+
+        return std::max(est, alt_est);
+    }
+
+    //   'condition_number' function - estimate of condition number of
+    // matrix in 1-norm: ||A||_1 ||A^{-1}||_1. LU factorization of A is
+    // reused, so it takes only O(n^2) operations
+    template <class T>
+    T condition_number(const Matrix<T> &A,
+            const GaussianJordanElimination::LUFactorization<T> &F)
+    {
+        return norm_1(A) * inverse_norm_1_estimate(F);
+    }
+
+    //   'condition_number' function for case when there is no LU
+    // factorization of A. Throws domain_error if A is degenerate
+    template <class T>
+    T condition_number(const Matrix<T> &A)
+    {
+        return condition_number(A, 
+                GaussianJordanElimination::lu_factorize_max_element(A));
+    }
+
+    //   Grain of parallel loop over rows in 'relative_residual'
+    enum Residual_constants
+    {
+        RESIDUAL_GRAIN = 64,
+    };
+
+    //   Relative residual of solution X of SLE A X = F in maximum norms:
+    //     ||A X - F|| / (||A|| ||X||).
+    // It's small (about machine epsilon times n) for solution found by
+    // backward stable method whatever condition number of A is, so answer
+    // can be checked in O(n^2) without right answer. Product A X, residual
+    // and norm of A are computed in one pass over each row of A, rows are
+    // processed in parallel
+    template <class T>
+    T relative_residual(const Matrix<T> &A, const Matrix<T> &X,
+            const Matrix<T> &F)
+    {
+        if (A.get_cols() != X.get_rows() || A.get_rows() != F.get_rows() ||
+                X.get_cols() != F.get_cols()) {
+            throw std::invalid_argument("'relative_residual': sizes of "
+                    "matrices don't match");
+        }
+
+        size_t n = A.get_rows(), m = X.get_cols();
+
+        //   Columns of X are copied to contiguous vectors
+        std::vector<std::vector<T>> cols(m, std::vector<T>(X.get_rows()));
+        T norm_X = 0;
+        for (size_t j = 0; j < X.get_rows(); ++j) {
+            for (size_t k = 0; k < m; ++k) {
+                cols[k][j] = X[j][k];
+                norm_X = std::max(norm_X, std::abs(X[j][k]));
+            }
+        }
+
+        //   Residual and sum of absolute values of each row
+        std::vector<T> row_residual(n, T(0)), row_norm(n, T(0));
+
+        Parallel::parallel_for(0, n, [&](size_t i) {
+            const T *a_row = A[i].data();
+            size_t len = A[i].size();
+
+            T norm = 0;
+            for (size_t k = 0; k < m; ++k) {
+                const T *x = cols[k].data();
+                T dot = 0;
+                if (k == 0) {
+                    for (size_t j = 0; j < len; ++j) {
+                        dot += a_row[j] * x[j];
+                        norm += std::abs(a_row[j]);
+                    }
+                } else {
+                    for (size_t j = 0; j < len; ++j) {
+                        dot += a_row[j] * x[j];
+                    }
+                }
+                row_residual[i] = std::max(row_residual[i], 
+                        std::abs(dot - F[i][k]));
+            }
+            row_norm[i] = norm;
+        }, RESIDUAL_GRAIN);
+
+        T residual = 0, norm_A = 0;
+        for (size_t i = 0; i < n; ++i) {
+            residual = std::max(residual, row_residual[i]);
+            norm_A = std::max(norm_A, row_norm[i]);
+        }
+
+        T denom = norm_A * norm_X;
+        return (denom == T(0) ? residual : residual / denom);
+    }
 }
 
 #endif // EXTRA_MATRIX_INCLUDE_GUARD
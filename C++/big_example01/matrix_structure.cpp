@@ -0,0 +1,3 @@
+// matrix_structure.cpp
+
+#include "matrix_structure.h"
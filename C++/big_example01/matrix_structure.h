@@ -0,0 +1,290 @@
+// matrix_structure.h
+
+//   Here I detect structure of left part of SLE (diagonal, triangular,
+// banded, symmetric, diagonally dominant, sparse) and there are solvers
+// for special structures which are much faster than gauss method
+
+
+#ifndef MATRIX_STRUCTURE_INCLUDE_GUARD
+#define MATRIX_STRUCTURE_INCLUDE_GUARD
+
+#include <vector>     // vector
+#include <string>     // string
+#include <limits>     // numeric_limits
+#include <stdexcept>  // invalid_argument, domain_error
+#include <algorithm>  // min, max, swap
+#include <cmath>      // abs, isfinite
+#include "matrix.h"
+#include "gaussian_method.h"
+
+namespace SLESolvers
+{
+    //   Information about structure of matrix. Everything is found in one
+    // pass over matrix
+    struct MatrixStructure
+    {
+        size_t rows = 0, cols = 0;
+
+        //   Number of nonzero elements and their fraction
+        size_t nnz = 0;
+        double density = 0;
+
+        //   Maximum distance from nonzero element to diagonal under and
+        // above diagonal
+        size_t lower_bandwidth = 0, upper_bandwidth = 0;
+
+        bool square = false;
+        bool diagonal = false;
+        bool lower_triangular = false;
+        bool upper_triangular = false;
+        bool symmetric = false;
+
+        //   All elements of diagonal are not zero / positive
+        bool nonzero_diagonal = false;
+        bool positive_diagonal = false;
+
+        //   |a_ii| > sum of |a_ij| (j != i) for each row
+        bool diagonally_dominant = false;
+    };
+
+    //   Finds structure of matrix A. Symmetry is checked with relative
+    // tolerance 'symmetry_tol'
+    template <class T>
+    MatrixStructure analyze_structure(const Matrix<T> &A,
+            const T &symmetry_tol = std::numeric_limits<T>::epsilon() * 100)
+    {
+        MatrixStructure s;
+        s.rows = A.get_rows();
+        s.cols = A.get_cols();
+        s.square = (s.rows == s.cols);
+
+        s.nonzero_diagonal = s.positive_diagonal = s.square;
+        s.diagonally_dominant = s.symmetric = s.square;
+
+        for (size_t i = 0; i < s.rows; ++i) {
+            const std::vector<T> &row = A[i];
+            T off_diagonal = 0;
+
+            for (size_t j = 0; j < s.cols; ++j) {
+                if (row[j] == T(0)) {
+                    continue;
+                }
+
+                ++s.nnz;
+                if (j < i) {
+                    s.lower_bandwidth = std::max(s.lower_bandwidth, i - j);
+                } else if (j > i) {
+                    s.upper_bandwidth = std::max(s.upper_bandwidth, j - i);
+                }
+
+                if (j != i) {
+                    off_diagonal += std::abs(row[j]);
+                }
+
+                //   Elements under diagonal are compared with elements
+                // above it
+                if (s.symmetric && j < i) {
+                    T a = row[j], b = A[j][i];
+                    if (std::abs(a - b) > symmetry_tol *
+                            std::max(std::abs(a), std::abs(b))) {
+                        s.symmetric = false;
+                    }
+                }
+            }
+
+            //   Element above diagonal with zero pair under diagonal
+            if (s.symmetric) {
+                for (size_t j = i + 1; j < s.cols; ++j) {
+                    if (row[j] != T(0) && A[j][i] == T(0)) {
+                        s.symmetric = false;
+                        break;
+                    }
+                }
+            }
+
+            if (s.square) {
+                if (row[i] == T(0)) {
+                    s.nonzero_diagonal = false;
+                }
+                if (!(row[i] > T(0))) {
+                    s.positive_diagonal = false;
+                }
+                if (!(std::abs(row[i]) > off_diagonal)) {
+                    s.diagonally_dominant = false;
+                }
+            }
+        }
+
+        if (s.rows > 0 && s.cols > 0) {
+            s.density = double(s.nnz) / s.rows / s.cols;
+        }
+
+        s.lower_triangular = s.square && s.upper_bandwidth == 0;
+        s.upper_triangular = s.square && s.lower_bandwidth == 0;
+        s.diagonal = s.lower_triangular && s.upper_triangular;
+
+        return s;
+    }
+
+
+    //   Checks that left and right parts of SLE suit special solvers
+    template <class T>
+    void check_special_SLE(const Matrix<T> &A, const Matrix<T> &f,
+            const std::string &name)
+    {
+        if (A.get_rows() != A.get_cols()) {
+            throw std::invalid_argument(name + ": left part of SLE must be "
+                    "square");
+        }
+
+        if (A.get_rows() != f.get_rows()) {
+            throw std::invalid_argument(name + ": left and right parts of "
+                    "SLE must have the same number of rows");
+        }
+    }
+
+    //   Solver of SLE with diagonal left part. Elements out of diagonal
+    // are ignored
+    template <class T>
+    Matrix<T> SLE_diagonal(const Matrix<T> &A, const Matrix<T> &f)
+    {
+        check_special_SLE(A, f, "SLE_diagonal");
+
+        Matrix<T> x(f);
+        for (size_t i = 0; i < A.get_rows(); ++i) {
+            if (GaussianJordanElimination::check_is_zero(A[i][i])) {
+                throw std::domain_error("SLE_diagonal: there is zero on "
+                        "diagonal of left part of SLE");
+            }
+
+            std::vector<T> &row = x[i];
+            for (T &elem : row) {
+                elem /= A[i][i];
+            }
+        }
+
+        return x;
+    }
+
+    //   Solver of SLE with triangular left part. If 'lower' is true,
+    // elements above diagonal are ignored, else elements under diagonal
+    // are ignored
+    template <class T>
+    Matrix<T> SLE_triangular(const Matrix<T> &A, const Matrix<T> &f,
+            bool lower)
+    {
+        check_special_SLE(A, f, "SLE_triangular");
+
+        size_t n = A.get_rows(), m = f.get_cols();
+        Matrix<T> x(f);
+
+        for (size_t step = 0; step < n; ++step) {
+            size_t i = lower ? step : n - 1 - step;
+            const std::vector<T> &row = A[i];
+            std::vector<T> &xi = x[i];
+
+            if (GaussianJordanElimination::check_is_zero(row[i])) {
+                throw std::domain_error("SLE_triangular: there is zero on "
+                        "diagonal of left part of SLE");
+            }
+
+            size_t from = lower ? 0 : i + 1, to = lower ? i : n;
+            for (size_t j = from; j < to; ++j) {
+                if (row[j] == T(0)) {
+                    continue;
+                }
+                const std::vector<T> &xj = x[j];
+                for (size_t c = 0; c < m; ++c) {
+                    xi[c] -= row[j] * xj[c];
+                }
+            }
+
+            for (size_t c = 0; c < m; ++c) {
+                xi[c] /= row[i];
+            }
+        }
+
+        return x;
+    }
+
+    //   Solver of SLE with banded left part: 'kl' diagonals under main
+    // diagonal and 'ku' diagonals above it. It's gauss method with
+    // partial pivoting which touches only elements of band, so it works
+    // O(n kl (kl + ku)) instead of O(n^3). After row swaps upper
+    // bandwidth of U grows up to kl + ku
+    template <class T>
+    Matrix<T> SLE_banded(const Matrix<T> &A, const Matrix<T> &f,
+            size_t kl, size_t ku)
+    {
+        check_special_SLE(A, f, "SLE_banded");
+
+        size_t n = A.get_rows(), m = f.get_cols();
+        Matrix<T> U(A), x(f);
+
+        for (size_t k = 0; k < n; ++k) {
+            size_t last_row = std::min(n - 1, k + kl);
+            size_t last_col = std::min(n - 1, k + kl + ku);
+
+            //   Pivot is maximum element of column in band
+            size_t pivot = k;
+            for (size_t i = k + 1; i <= last_row; ++i) {
+                if (std::abs(U[i][k]) > std::abs(U[pivot][k])) {
+                    pivot = i;
+                }
+            }
+
+            if (GaussianJordanElimination::check_is_zero(U[pivot][k]) ||
+                    !std::isfinite(U[pivot][k])) {
+                throw std::domain_error("SLE_banded: left part of SLE is "
+                        "degenerate");
+            }
+
+            if (pivot != k) {
+                std::swap(U[pivot], U[k]);
+                std::swap(x[pivot], x[k]);
+            }
+
+            const std::vector<T> &row_k = U[k];
+            const std::vector<T> &x_k = x[k];
+            for (size_t i = k + 1; i <= last_row; ++i) {
+                std::vector<T> &row_i = U[i];
+                if (row_i[k] == T(0)) {
+                    continue;
+                }
+
+                T coef = row_i[k] / row_k[k];
+                row_i[k] = 0;
+                for (size_t j = k + 1; j <= last_col; ++j) {
+                    row_i[j] -= coef * row_k[j];
+                }
+
+                std::vector<T> &x_i = x[i];
+                for (size_t c = 0; c < m; ++c) {
+                    x_i[c] -= coef * x_k[c];
+                }
+            }
+        }
+
+        //   Back substitution in band of width kl + ku
+        for (size_t i = n; i-- > 0; ) {
+            const std::vector<T> &row = U[i];
+            std::vector<T> &xi = x[i];
+            size_t last_col = std::min(n - 1, i + kl + ku);
+
+            for (size_t j = i + 1; j <= last_col; ++j) {
+                const std::vector<T> &xj = x[j];
+                for (size_t c = 0; c < m; ++c) {
+                    xi[c] -= row[j] * xj[c];
+                }
+            }
+
+            for (size_t c = 0; c < m; ++c) {
+                xi[c] /= row[i];
+            }
+        }
+
+        return x;
+    }
+}
+
+#endif // MATRIX_STRUCTURE_INCLUDE_GUARD
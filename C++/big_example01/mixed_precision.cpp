@@ -0,0 +1,3 @@
+// mixed_precision.cpp
+
+#include "mixed_precision.h"
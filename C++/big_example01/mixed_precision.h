@@ -0,0 +1,217 @@
+// mixed_precision.h
+
+//   Mixed precision solver of SLE. LU factorization (the O(n^3) part) is
+// done in low precision (float): there is twice less memory traffic and
+// twice more elements in one SIMD register. Then accuracy of high
+// precision (double) is recovered by iterative refinement:
+//     r = f - A x (in double),  L U d = P r (in float),  x = x + d.
+// Refinement converges if A is not too badly conditioned for float
+// (cond(A) * eps_float < 1). If it stalls or some pivot of float LU is
+// at the level of rounding errors, SLE is solved again in double (and
+// degenerate A is rejected there like in other solvers)
+
+
+#ifndef MIXED_PRECISION_INCLUDE_GUARD
+#define MIXED_PRECISION_INCLUDE_GUARD
+
+#include <vector>     // vector
+#include <limits>     // numeric_limits
+#include <stdexcept>  // invalid_argument, domain_error
+#include <algorithm>  // max
+#include <cmath>      // abs, sqrt, isfinite
+#include "matrix.h"
+#include "gaussian_method.h"
+#include "parallel.h"
+
+namespace SLESolvers
+{
+    //   Rows of residual are computed in parallel by blocks of this size
+    enum MP_parallel_constants { MP_RESIDUAL_GRAIN = 64 };
+
+    //   What mixed precision solver has done
+    struct RefinementInfo
+    {
+        //   Number of refinement steps
+        int steps = 0;
+
+        //   True if refinement stalled and SLE was solved in high
+        // precision
+        bool fallback = false;
+
+        //   Max norm of final residual
+        double residual = 0;
+    };
+
+    //   Converts matrix to matrix with other type of elements
+    template <class U, class T>
+    Matrix<U> convert_matrix(const Matrix<T> &A)
+    {
+        Matrix<U> res(A.get_rows(), A.get_cols());
+        for (size_t i = 0; i < A.get_rows(); ++i) {
+            const std::vector<T> &row = A[i];
+            std::vector<U> &res_row = res[i];
+            for (size_t j = 0; j < row.size(); ++j) {
+                res_row[j] = U(row[j]);
+            }
+        }
+        return res;
+    }
+
+    //   R = F - A X. Returns max norm of R
+    template <class T>
+    T residual(const Matrix<T> &A, const Matrix<T> &X, const Matrix<T> &F,
+            Matrix<T> &R)
+    {
+        size_t n = A.get_rows(), m = F.get_cols();
+        std::vector<T> row_norm(n, T(0));
+
+        Parallel::parallel_for(0, n, [&](size_t i) {
+            const std::vector<T> &row = A[i];
+            std::vector<T> &r = R[i];
+            r = F[i];
+
+            for (size_t j = 0; j < row.size(); ++j) {
+                const std::vector<T> &x = X[j];
+                for (size_t c = 0; c < m; ++c) {
+                    r[c] -= row[j] * x[c];
+                }
+            }
+
+            for (size_t c = 0; c < m; ++c) {
+                row_norm[i] = std::max(row_norm[i], std::abs(r[c]));
+            }
+        }, MP_RESIDUAL_GRAIN);
+
+        T norm = 0;
+        for (T val : row_norm) {
+            norm = std::max(norm, val);
+        }
+        return norm;
+    }
+
+    //   Solves SLE A X = F with factorization in precision L and
+    // refinement in precision T. Refinement stops when
+    //     ||r|| <= ||x|| ||A|| eps_T sqrt(n)
+    // (all norms are max norms). If residual doesn't become at least
+    // twice smaller on some step or after 'max_steps' steps, or if some
+    // pivot of LU in precision L is not greater than n ||A|| eps_L, SLE is
+    // solved by LU factorization in precision T (it throws domain_error
+    // if A is degenerate). All columns of F are solved
+    template <class T, class L = float>
+    Matrix<T> SLE_mixed_precision(const Matrix<T> &A, const Matrix<T> &F,
+            RefinementInfo *info = NULL, size_t max_steps = 30)
+    {
+        if (A.get_rows() != A.get_cols()) {
+            throw std::invalid_argument("SLE_mixed_precision: left part of "
+                    "SLE must be square");
+        }
+
+        if (A.get_rows() != F.get_rows()) {
+            throw std::invalid_argument("SLE_mixed_precision: left and "
+                    "right parts of SLE must have the same number of rows");
+        }
+
+        RefinementInfo tmp_info;
+        if (!info) {
+            info = &tmp_info;
+        }
+        *info = RefinementInfo();
+
+        size_t n = A.get_rows();
+        Matrix<T> R(n, F.get_cols());
+
+        //   Solving in high precision, it's used if refinement fails
+        auto fallback = [&]() {
+            info->fallback = true;
+            auto X = GaussianJordanElimination::lu_solve(
+                    GaussianJordanElimination::lu_factorize_max_element(A), F);
+            info->residual = residual(A, X, F, R);
+            return X;
+        };
+
+        //   Max norm of A for test of pivots and stop criterion
+        T A_norm = 0;
+        for (size_t i = 0; i < n; ++i) {
+            T sum = 0;
+            for (const T &val : A[i]) {
+                sum += std::abs(val);
+            }
+            A_norm = std::max(A_norm, sum);
+        }
+
+        //   Matrix which is degenerate in low precision can be good in
+        // high one
+        GaussianJordanElimination::LUFactorization<L> LU;
+        try {
+            LU = GaussianJordanElimination::lu_factorize_max_element(
+                    convert_matrix<L>(A));
+        } catch (std::domain_error &) {
+            return fallback();
+        }
+
+        //   Absolute EPS of 'check_is_zero' means nothing in precision L,
+        // so pivots are compared with rounding error of elimination
+        // n ||A|| eps_L. Smaller pivot means that A is degenerate or too
+        // badly conditioned for L, and it's decided in precision T
+        L pivot_tol = L(n) * L(A_norm) * std::numeric_limits<L>::epsilon();
+        for (size_t i = 0; i < n; ++i) {
+            if (!(std::abs(LU.LU[i][i]) > pivot_tol)) {
+                return fallback();
+            }
+        }
+
+        T tol = A_norm * std::numeric_limits<T>::epsilon() * std::sqrt(T(n));
+
+        Matrix<T> X = convert_matrix<T>(GaussianJordanElimination::
+                lu_solve(LU, convert_matrix<L>(F)));
+
+        T prev_norm = std::numeric_limits<T>::infinity();
+        for (;;) {
+            T r_norm = residual(A, X, F, R);
+
+            T x_norm = 0;
+            for (size_t i = 0; i < n; ++i) {
+                for (const T &val : X[i]) {
+                    x_norm = std::max(x_norm, std::abs(val));
+                }
+            }
+
+            if (!std::isfinite(r_norm)) {
+                return fallback();
+            }
+
+            if (r_norm <= x_norm * tol) {
+                info->residual = r_norm;
+                return X;
+            }
+
+            if (r_norm > prev_norm / 2 || info->steps == (int) max_steps) {
+                return fallback();
+            }
+            prev_norm = r_norm;
+
+            //   Correction
+            Matrix<T> D = convert_matrix<T>(GaussianJordanElimination::
+                    lu_solve(LU, convert_matrix<L>(R)));
+            for (size_t i = 0; i < n; ++i) {
+                std::vector<T> &x = X[i];
+                const std::vector<T> &d = D[i];
+                for (size_t c = 0; c < x.size(); ++c) {
+                    x[c] += d[c];
+                }
+            }
+
+            ++info->steps;
+        }
+    }
+
+    //   Mixed precision solver with some standard constants
+    template <class T>
+    Matrix<T> SLE_mixed_precision_standard(const Matrix<T> &A,
+            const Matrix<T> &f)
+    {
+        return SLE_mixed_precision(A, f);
+    }
+}
+
+#endif // MIXED_PRECISION_INCLUDE_GUARD
@@ -0,0 +1,3 @@
+// multigrid.cpp
+
+#include "multigrid.h"
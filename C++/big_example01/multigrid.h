@@ -0,0 +1,536 @@
+// multigrid.h
+
+//   Multigrid solver of SLE. Smoothing is done by SOR sweeps (as in
+// SLE_SOR), error which smoothing can't remove is computed on coarser
+// grid. Coarse grids are built geometrically (for matrices of 1D and 2D
+// grids) or by smoothed aggregation (algebraic multigrid, AMG) for any
+// sparse matrix. Work of one cycle is O(number of nonzero elements)
+
+
+#ifndef MULTIGRID_INCLUDE_GUARD
+#define MULTIGRID_INCLUDE_GUARD
+
+#include <vector>     // vector
+#include <stdexcept>  // invalid_argument, domain_error
+#include <algorithm>  // max, min, fill
+#include <cmath>      // abs, sqrt, isfinite
+#include <utility>    // pair
+#include "matrix.h"
+#include "sparse_matrix.h"
+#include "gaussian_method.h"
+
+namespace SLESolvers
+{
+    //   Ways to build coarse grids
+    enum MG_coarsening
+    {
+        //   Every second node of 1D or 2D grid is taken, interpolation
+        // is linear (bilinear in 2D)
+        MG_GEOMETRIC,
+
+        //   Nodes are grouped into aggregates of strongly connected nodes,
+        // then piecewise constant interpolation is smoothed by one step
+        // of Jacobi method
+        MG_AGGREGATION,
+    };
+
+    //   Types of cycles: number is number of recursive calls on each level
+    enum MG_cycle
+    {
+        MG_V_CYCLE = 1,
+        MG_W_CYCLE = 2,
+    };
+
+    //   Parameters of multigrid method
+    struct MultigridParameters
+    {
+        MG_cycle cycle = MG_V_CYCLE;
+        MG_coarsening coarsening = MG_AGGREGATION;
+
+        //   Number of nodes in one line of grid for geometric coarsening
+        // (0 means 1D grid)
+        size_t grid_nx = 0;
+
+        //   SOR parameter and number of sweeps before and after coarse
+        // grid correction
+        double w = 1;
+        size_t pre_sweeps = 1, post_sweeps = 1;
+
+        //   Coarsest grid is solved directly when it has not more than
+        // 'coarse_size' nodes
+        size_t coarse_size = 50;
+        size_t max_levels = 25;
+
+        //   Threshold of strong connection for aggregation:
+        // |a_ij| >= theta * sqrt(|a_ii a_jj|)
+        double strength_theta = 0.08;
+    };
+
+    //   Hierarchy of grids and cycle on it
+    template <class T>
+    class Multigrid
+    {
+    private:
+        //   One level of hierarchy. P - interpolation from next (coarser)
+        // level, R - restriction to next level. x, b, r - solution, right
+        // part and residual on level, tmp - buffer
+        struct Level
+        {
+            SparseMatrix<T> A, P, R;
+            std::vector<T> diag;
+            std::vector<T> x, b, r, tmp;
+
+            //   Grid sizes for geometric coarsening
+            size_t nx, ny;
+        };
+
+        MultigridParameters params;
+        std::vector<Level> levels;
+
+        //   Inverse matrix of coarsest level
+        Matrix<T> coarse_inverse;
+
+        //   Interpolation for geometric coarsening. Coarse node J of 1D
+        // grid is fine node 2J + 1, fine node 2J gets half of values of
+        // both neighbours
+        static SparseMatrix<T> build_geometric_P(size_t nx, size_t ny,
+                size_t &cnx, size_t &cny)
+        {
+            using Triplet = typename SparseMatrix<T>::Triplet;
+
+            //   1D interpolation weights: list of (coarse node, weight)
+            // for each fine node
+            auto interpolation_1d = [](size_t n, size_t &cn) {
+                std::vector<std::vector<std::pair<size_t, T>>> res(n);
+
+                //   Grid with one node can't be coarsened
+                if (n < 2) {
+                    cn = n;
+                    for (size_t i = 0; i < n; ++i) {
+                        res[i].push_back({ i, T(1) });
+                    }
+                    return res;
+                }
+
+                cn = n / 2;
+                for (size_t J = 0; J < cn; ++J) {
+                    res[2 * J + 1].push_back({ J, T(1) });
+                    res[2 * J].push_back({ J, T(0.5) });
+                    if (2 * J + 2 < n) {
+                        res[2 * J + 2].push_back({ J, T(0.5) });
+                    }
+                }
+                return res;
+            };
+
+            auto px = interpolation_1d(nx, cnx);
+            std::vector<std::vector<std::pair<size_t, T>>> py(1,
+                    std::vector<std::pair<size_t, T>>(1, { 0, T(1) }));
+            cny = 1;
+            if (ny > 1) {
+                py = interpolation_1d(ny, cny);
+            }
+
+            //   2D interpolation is tensor product of 1D ones
+            std::vector<Triplet> triplets;
+            for (size_t iy = 0; iy < ny; ++iy) {
+                for (size_t ix = 0; ix < nx; ++ix) {
+                    for (const auto &wy : py[iy]) {
+                        for (const auto &wx : px[ix]) {
+                            triplets.push_back({ iy * nx + ix,
+                                    wy.first * cnx + wx.first,
+                                    wy.second * wx.second });
+                        }
+                    }
+                }
+            }
+
+            return SparseMatrix<T>(nx * ny, cnx * cny, triplets);
+        }
+
+        //   Interpolation for smoothed aggregation
+        SparseMatrix<T> build_aggregation_P(const SparseMatrix<T> &A,
+                const std::vector<T> &diag) const
+        {
+            using Triplet = typename SparseMatrix<T>::Triplet;
+
+            size_t n = A.get_rows();
+            const auto &row_ptr = A.get_row_ptr();
+            const auto &col_ind = A.get_col_ind();
+            const auto &values = A.get_values();
+
+            auto strong = [&](size_t i, size_t p) {
+                size_t j = col_ind[p];
+                return j != i && std::abs(values[p]) >= params.strength_theta *
+                        std::sqrt(std::abs(diag[i] * diag[j]));
+            };
+
+            //   Aggregation. 'agg[i]' - number of aggregate of node 'i'
+            const size_t NONE = n;
+            std::vector<size_t> agg(n, NONE);
+            size_t num_aggs = 0;
+
+            //   Phase 1: node and all its strong neighbours make new
+            // aggregate if all of them are free
+            for (size_t i = 0; i < n; ++i) {
+                bool free = agg[i] == NONE;
+                for (size_t p = row_ptr[i]; free && p < row_ptr[i + 1]; ++p) {
+                    if (strong(i, p) && agg[col_ind[p]] != NONE) {
+                        free = false;
+                    }
+                }
+
+                if (free) {
+                    agg[i] = num_aggs;
+                    for (size_t p = row_ptr[i]; p < row_ptr[i + 1]; ++p) {
+                        if (strong(i, p)) {
+                            agg[col_ind[p]] = num_aggs;
+                        }
+                    }
+                    ++num_aggs;
+                }
+            }
+
+            //   Phase 2: free nodes join aggregate of strong neighbour
+            std::vector<size_t> agg_phase1 = agg;
+            for (size_t i = 0; i < n; ++i) {
+                if (agg[i] != NONE) {
+                    continue;
+                }
+
+                for (size_t p = row_ptr[i]; p < row_ptr[i + 1]; ++p) {
+                    if (strong(i, p) && agg_phase1[col_ind[p]] != NONE) {
+                        agg[i] = agg_phase1[col_ind[p]];
+                        break;
+                    }
+                }
+            }
+
+            //   Phase 3: remaining nodes make new aggregates with their
+            // free strong neighbours
+            for (size_t i = 0; i < n; ++i) {
+                if (agg[i] != NONE) {
+                    continue;
+                }
+
+                agg[i] = num_aggs;
+                for (size_t p = row_ptr[i]; p < row_ptr[i + 1]; ++p) {
+                    if (strong(i, p) && agg[col_ind[p]] == NONE) {
+                        agg[col_ind[p]] = num_aggs;
+                    }
+                }
+                ++num_aggs;
+            }
+
+            //   Piecewise constant interpolation
+            std::vector<Triplet> triplets;
+            for (size_t i = 0; i < n; ++i) {
+                triplets.push_back({ i, agg[i], T(1) });
+            }
+            SparseMatrix<T> P_tent(n, num_aggs, triplets);
+
+            //   Smoothing: P = (I - omega D^(-1) A) P_tent, where
+            // omega = 4 / (3 rho) and rho is spectral radius of D^(-1) A.
+            // I take Gershgorin estimate of rho (it's upper bound)
+            T rho = 0;
+            for (size_t i = 0; i < n; ++i) {
+                T sum = 0;
+                for (size_t p = row_ptr[i]; p < row_ptr[i + 1]; ++p) {
+                    sum += std::abs(values[p]);
+                }
+                rho = std::max(rho, sum / std::abs(diag[i]));
+            }
+            T omega = T(4) / (3 * rho);
+
+            triplets.clear();
+            for (size_t i = 0; i < n; ++i) {
+                triplets.push_back({ i, i, T(1) });
+                for (size_t p = row_ptr[i]; p < row_ptr[i + 1]; ++p) {
+                    triplets.push_back({ i, col_ind[p],
+                            -omega * values[p] / diag[i] });
+                }
+            }
+            SparseMatrix<T> S(n, n, triplets);
+
+            return S * P_tent;
+        }
+
+        //   One SOR sweep on level (forward or backward)
+        static void smooth(Level &level, double w, bool forward)
+        {
+            const auto &row_ptr = level.A.get_row_ptr();
+            const auto &col_ind = level.A.get_col_ind();
+            const auto &values = level.A.get_values();
+            size_t n = level.A.get_rows();
+
+            for (size_t r = 0; r < n; ++r) {
+                size_t i = forward ? r : n - 1 - r;
+
+                T sum = level.b[i];
+                for (size_t p = row_ptr[i]; p < row_ptr[i + 1]; ++p) {
+                    sum -= values[p] * level.x[col_ind[p]];
+                }
+                level.x[i] += w / level.diag[i] * sum;
+            }
+        }
+
+        //   r = b - A x on level
+        static void compute_residual(Level &level)
+        {
+            level.A.multiply(level.x, level.r);
+            for (size_t i = 0; i < level.r.size(); ++i) {
+                level.r[i] = level.b[i] - level.r[i];
+            }
+        }
+
+        //   One cycle on level 'l' for current x and b of this level
+        void run_cycle(size_t l)
+        {
+            Level &level = levels[l];
+
+            //   Coarsest level is solved directly
+            if (l + 1 == levels.size()) {
+                size_t n = level.b.size();
+                for (size_t i = 0; i < n; ++i) {
+                    const std::vector<T> &row = coarse_inverse[i];
+
+                    T sum = 0;
+                    for (size_t j = 0; j < n; ++j) {
+                        sum += row[j] * level.b[j];
+                    }
+                    level.x[i] = sum;
+                }
+                return;
+            }
+
+            for (size_t s = 0; s < params.pre_sweeps; ++s) {
+                smooth(level, params.w, true);
+            }
+
+            //   Coarse grid correction
+            compute_residual(level);
+
+            Level &coarse = levels[l + 1];
+            level.R.multiply(level.r, coarse.b);
+            std::fill(coarse.x.begin(), coarse.x.end(), T(0));
+
+            for (int c = 0; c < params.cycle; ++c) {
+                run_cycle(l + 1);
+            }
+
+            level.P.multiply(coarse.x, level.tmp);
+            for (size_t i = 0; i < level.x.size(); ++i) {
+                level.x[i] += level.tmp[i];
+            }
+
+            for (size_t s = 0; s < params.post_sweeps; ++s) {
+                smooth(level, params.w, false);
+            }
+        }
+
+    public:
+        //   Builds hierarchy of grids for matrix A
+        Multigrid(const SparseMatrix<T> &A,
+                const MultigridParameters &params_init = MultigridParameters())
+            : params(params_init)
+        {
+            if (A.get_rows() != A.get_cols()) {
+                throw std::invalid_argument("Multigrid: matrix must be "
+                        "square");
+            }
+
+            Level fine;
+            fine.A = A;
+            fine.nx = params.grid_nx == 0 ? A.get_rows() : params.grid_nx;
+            fine.ny = A.get_rows() / std::max<size_t>(fine.nx, 1);
+            levels.push_back(fine);
+
+            if (params.coarsening == MG_GEOMETRIC &&
+                    fine.nx * fine.ny != A.get_rows()) {
+                throw std::invalid_argument("Multigrid: size of matrix "
+                        "doesn't match size of grid");
+            }
+
+            while (true) {
+                Level &level = levels.back();
+                level.diag = level.A.get_diagonal();
+
+                size_t n = level.A.get_rows();
+                for (size_t i = 0; i < n; ++i) {
+                    if (level.diag[i] == T(0)) {
+                        throw std::domain_error("Multigrid: there is zero "
+                                "on diagonal of matrix");
+                    }
+                }
+
+                level.x.assign(n, T(0));
+                level.b.assign(n, T(0));
+                level.r.assign(n, T(0));
+                level.tmp.assign(n, T(0));
+
+                if (n <= params.coarse_size ||
+                        levels.size() >= params.max_levels) {
+                    break;
+                }
+
+                Level next;
+                if (params.coarsening == MG_GEOMETRIC) {
+                    level.P = build_geometric_P(level.nx, level.ny,
+                            next.nx, next.ny);
+                } else {
+                    level.P = build_aggregation_P(level.A, level.diag);
+                }
+
+                //   If grid doesn't become smaller, stop coarsening
+                if (level.P.get_cols() * 10 > n * 9) {
+                    level.P = SparseMatrix<T>();
+                    break;
+                }
+
+                //   Galerkin coarse matrix: A_coarse = R A P, R = P^T
+                level.R = level.P.get_transposed();
+                next.A = level.R * (level.A * level.P);
+                levels.push_back(next);
+            }
+
+            //   Inverse of coarsest matrix by Gauss-Jordan elimination
+            Matrix<T> C = levels.back().A.to_matrix();
+            Matrix<T> I = Matrix<T>::get_I(C.get_rows());
+            auto TMP = GaussianJordanElimination::
+                    get_direct_motion_max_element<T>(C, I);
+            GaussianJordanElimination::counter_motion(TMP.first, TMP.second);
+
+            for (size_t i = 0; i < C.get_rows(); ++i) {
+                if (GaussianJordanElimination::check_is_zero(
+                        TMP.first[i][i])) {
+                    throw std::domain_error("Multigrid: matrix of coarsest "
+                            "grid is degenerate");
+                }
+            }
+            coarse_inverse = TMP.second;
+        }
+
+        //   Returns number of levels in hierarchy
+        size_t get_num_levels() const
+        {
+            return levels.size();
+        }
+
+        //   Returns number of unknowns on level 'l'
+        size_t get_level_size(size_t l) const
+        {
+            return levels.at(l).A.get_rows();
+        }
+
+        //   Solves A x = b by cycles starting from x = 0 until
+        // ||b - Ax|| / ||b|| < eps (maximum norm). Returns number of cycles
+        int solve(const std::vector<T> &b, std::vector<T> &x,
+                const T &eps = 1e-10, size_t max_iters = 100)
+        {
+            Level &fine = levels[0];
+            if (b.size() != fine.b.size()) {
+                throw std::invalid_argument("Multigrid: right part of SLE "
+                        "has wrong size");
+            }
+
+            fine.b = b;
+            std::fill(fine.x.begin(), fine.x.end(), T(0));
+
+            T b_norm = 0;
+            for (const T &val : b) {
+                b_norm = std::max(b_norm, std::abs(val));
+            }
+            if (b_norm == T(0)) {
+                b_norm = 1;
+            }
+
+            int iter;
+            for (iter = 0; iter < max_iters; ++iter) {
+                compute_residual(fine);
+
+                T r_norm = 0;
+                for (const T &val : fine.r) {
+                    r_norm = std::max(r_norm, std::abs(val));
+                }
+
+                if (!std::isfinite(r_norm)) {
+                    throw std::domain_error("Multigrid: such both parts of "
+                            "SLE caused discrepancy of method");
+                }
+                if (r_norm / b_norm < eps) {
+                    break;
+                }
+
+                run_cycle(0);
+            }
+
+            x = fine.x;
+            return iter;
+        }
+    };
+
+
+    //   Multigrid solver of SLE. All columns of f are solved, cnt_iter --
+    // pointer to variable where maximum number of cycles is stored
+    template <class T>
+    Matrix<T> SLE_multigrid(const SparseMatrix<T> &A, const Matrix<T> &f,
+            const MultigridParameters &params = MultigridParameters(),
+            int *cnt_iter = NULL, const T &eps = 1e-10,
+            size_t max_iters = 100)
+    {
+        //   If number of rows of A and f are not equal we leave
+        if (A.get_rows() != f.get_rows()) {
+            throw std::invalid_argument("SLE_multigrid: left and right "
+                    "parts of SLE must have the same number of rows");
+        }
+
+        if (cnt_iter) {
+            *cnt_iter = -1;
+        }
+
+        Multigrid<T> mg(A, params);
+
+        size_t n = A.get_rows();
+        Matrix<T> ans(n, f.get_cols());
+        std::vector<T> b(n), x;
+        int max_cycles = 0;
+
+        for (size_t c = 0; c < f.get_cols(); ++c) {
+            for (size_t i = 0; i < n; ++i) {
+                b[i] = f[i][c];
+            }
+
+            max_cycles = std::max(max_cycles, mg.solve(b, x, eps, max_iters));
+
+            for (size_t i = 0; i < n; ++i) {
+                ans[i][c] = x[i];
+            }
+        }
+
+        if (cnt_iter) {
+            *cnt_iter = max_cycles;
+        }
+        return ans;
+    }
+
+    //   Multigrid solver for dense left part. Zeros are dropped first
+    template <class T>
+    Matrix<T> SLE_multigrid(const Matrix<T> &A, const Matrix<T> &f,
+            const MultigridParameters &params = MultigridParameters(),
+            int *cnt_iter = NULL, const T &eps = 1e-10,
+            size_t max_iters = 100)
+    {
+        return SLE_multigrid(SparseMatrix<T>(A), f, params, cnt_iter, eps,
+                max_iters);
+    }
+
+    //   Multigrid solver (V-cycle, smoothed aggregation) with some standard
+    // constants
+    template <class T>
+    Matrix<T> SLE_multigrid_standard(const Matrix<T> &A, const Matrix<T> &f)
+    {
+        return SLE_multigrid(A, f);
+    }
+}
+
+#endif // MULTIGRID_INCLUDE_GUARD
@@ -0,0 +1,121 @@
+// parallel.cpp
+
+#include "parallel.h"
+
+#ifdef __linux__
+#include <sys/syscall.h>  // SYS_gettid
+#include <unistd.h>       // syscall
+#endif
+
+namespace
+{
+    //   This flag is true only in worker threads of pool
+    thread_local bool is_worker_thread = false;
+
+    //   System id of calling thread
+    long get_tid()
+    {
+#ifdef __linux__
+        return syscall(SYS_gettid);
+#else
+        return -1;
+#endif
+    }
+}
+
+Parallel::ThreadPool::ThreadPool(size_t num_threads)
+    : worker_tids(num_threads, -1)
+{
+    for (size_t i = 0; i < num_threads; ++i) {
+        workers.emplace_back([this, i]() {
+            {
+                std::unique_lock<std::mutex> lock(mtx);
+                worker_tids[i] = get_tid();
+                ++num_started;
+            }
+            cv.notify_all();
+
+            worker_loop();
+        });
+    }
+
+    //   Ids of all workers are known after constructor
+    std::unique_lock<std::mutex> lock(mtx);
+    cv.wait(lock, [this, num_threads]() {
+        return num_started == num_threads;
+    });
+}
+
+Parallel::ThreadPool::~ThreadPool()
+{
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        stop = true;
+    }
+    cv.notify_all();
+
+    for (auto &worker : workers) {
+        worker.join();
+    }
+}
+
+size_t Parallel::ThreadPool::get_num_threads() const
+{
+    return workers.size();
+}
+
+std::vector<long> Parallel::ThreadPool::get_worker_tids() const
+{
+    return worker_tids;
+}
+
+void Parallel::ThreadPool::submit(std::function<void()> task)
+{
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        tasks.push(std::move(task));
+    }
+    cv.notify_one();
+}
+
+bool Parallel::ThreadPool::in_worker_thread()
+{
+    return is_worker_thread;
+}
+
+void Parallel::ThreadPool::worker_loop()
+{
+    is_worker_thread = true;
+
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            cv.wait(lock, [this]() { return stop || !tasks.empty(); });
+
+            if (stop && tasks.empty()) {
+                return;
+            }
+
+            task = std::move(tasks.front());
+            tasks.pop();
+        }
+
+        task();
+    }
+}
+
+Parallel::ThreadPool &Parallel::get_thread_pool()
+{
+    //   Calling thread also works in 'parallel_for', so pool has one
+    // thread less than hardware can run
+    static ThreadPool pool(std::max<size_t>(
+            std::thread::hardware_concurrency(), 1) - 1);
+
+    return pool;
+}
+
+size_t Parallel::get_num_threads()
+{
+    return get_thread_pool().get_num_threads() + 1;
+}
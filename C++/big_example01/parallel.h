@@ -0,0 +1,149 @@
+// parallel.h
+
+//   Here I define a small thread pool and 'parallel_for' function. I use
+// them to run independent parts of algorithms (rows of one color in SOR,
+// blocks of matrix, etc.) on all cores
+
+
+#ifndef PARALLEL_INCLUDE_GUARD
+#define PARALLEL_INCLUDE_GUARD
+
+#include <vector>              // vector
+#include <queue>               // queue
+#include <thread>              // thread
+#include <mutex>               // mutex, unique_lock
+#include <condition_variable>  // condition_variable
+#include <functional>          // function
+#include <atomic>              // atomic
+#include <exception>           // exception_ptr
+#include <algorithm>           // min, max
+
+namespace Parallel
+{
+    //   Pool of worker threads. Threads are created once and then wait
+    // for tasks, so we don't pay for thread creation on each parallel
+    // loop (SOR makes such loop for every color on every iteration)
+    class ThreadPool
+    {
+    private:
+        std::vector<std::thread> workers;
+        std::queue<std::function<void()>> tasks;
+
+        //   Thread ids of workers given by system (they are set by
+        // workers themselves, constructor waits for it)
+        std::vector<long> worker_tids;
+        size_t num_started = 0;
+
+        std::mutex mtx;
+        std::condition_variable cv;
+        bool stop = false;
+
+        //   Main loop of each worker thread
+        void worker_loop();
+
+    public:
+        //   Creates pool with given number of threads
+        explicit ThreadPool(size_t num_threads);
+
+        //   Waits for all workers to finish
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool &) = delete;
+        ThreadPool &operator = (const ThreadPool &) = delete;
+
+        //   Returns number of worker threads in pool
+        size_t get_num_threads() const;
+
+        //   Returns system ids of worker threads (Linux thread ids which
+        // can be given to perf_event_open, -1 on other systems)
+        std::vector<long> get_worker_tids() const;
+
+        //   Add new task to queue
+        void submit(std::function<void()> task);
+
+        //   Returns true if function is called from one of worker threads
+        static bool in_worker_thread();
+    };
+
+    //   Returns pool which is shared by all algorithms. Pool is created
+    // on first call
+    ThreadPool &get_thread_pool();
+
+    //   Number of threads which 'parallel_for' uses (worker threads plus
+    // calling thread)
+    size_t get_num_threads();
+
+    //   'parallel_for' calls func(i) for each i from [begin, end).
+    // Indices are given to threads by chunks of 'grain' size. If it's
+    // called from worker thread (nested parallelism) or range is small,
+    // loop runs in calling thread. Exception thrown by 'func' is
+    // rethrown in calling thread
+    template <class F>
+    void parallel_for(size_t begin, size_t end, F func, size_t grain = 1)
+    {
+        if (begin >= end) {
+            return;
+        }
+
+        grain = std::max<size_t>(grain, 1);
+        size_t num_chunks = (end - begin + grain - 1) / grain;
+        size_t num_threads = std::min(get_num_threads(), num_chunks);
+
+        if (num_threads <= 1 || ThreadPool::in_worker_thread()) {
+            for (size_t i = begin; i < end; ++i) {
+                func(i);
+            }
+            return;
+        }
+
+        //   Shared state of loop. Threads take chunks using atomic
+        // counter 'next'
+        std::atomic<size_t> next(begin);
+        std::mutex mtx;
+        std::condition_variable cv;
+        size_t helpers_left = num_threads - 1;
+        std::exception_ptr error = nullptr;
+
+        auto body = [&]() {
+            try {
+                for (size_t from = next.fetch_add(grain); from < end;
+                        from = next.fetch_add(grain)) {
+                    size_t to = std::min(end, from + grain);
+                    for (size_t i = from; i < to; ++i) {
+                        func(i);
+                    }
+                }
+            } catch (...) {
+                std::unique_lock<std::mutex> lock(mtx);
+                if (!error) {
+                    error = std::current_exception();
+                }
+                next = end;
+            }
+        };
+
+        for (size_t t = 0; t + 1 < num_threads; ++t) {
+            get_thread_pool().submit([&]() {
+                body();
+
+                std::unique_lock<std::mutex> lock(mtx);
+                if (--helpers_left == 0) {
+                    cv.notify_one();
+                }
+            });
+        }
+
+        //   Calling thread works too, then waits for helpers
+        body();
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            cv.wait(lock, [&]() { return helpers_left == 0; });
+        }
+
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+}
+
+#endif // PARALLEL_INCLUDE_GUARD
@@ -0,0 +1,209 @@
+// perf_counters.cpp
+
+#include "perf_counters.h"
+#include "parallel.h"          // get_thread_pool
+
+#ifdef __linux__
+#include <linux/perf_event.h>  // perf_event_attr, PERF_*
+#include <sys/syscall.h>       // __NR_perf_event_open
+#include <sys/ioctl.h>         // ioctl
+#include <unistd.h>            // syscall, read, close
+#include <cstring>             // memset, strerror
+#include <cerrno>              // errno
+#include <cstdint>             // uint64_t
+#endif
+
+double PerfCounters::PerfValues::ipc() const
+{
+    if (!has(PERF_CYCLES) || !has(PERF_INSTRUCTIONS) ||
+            values[PERF_CYCLES] == 0) {
+        return 0;
+    }
+    return values[PERF_INSTRUCTIONS] / values[PERF_CYCLES];
+}
+
+double PerfCounters::PerfValues::per_kilo_instruction(PerfEvent event) const
+{
+    if (!has(event) || !has(PERF_INSTRUCTIONS) ||
+            values[PERF_INSTRUCTIONS] == 0) {
+        return 0;
+    }
+    return values[event] * 1000 / values[PERF_INSTRUCTIONS];
+}
+
+PerfCounters::PerfValues PerfCounters::PerfValues::operator / (
+        double runs) const
+{
+    PerfValues res = *this;
+    for (double &val : res.values) {
+        val /= runs;
+    }
+    return res;
+}
+
+#ifdef __linux__
+
+namespace
+{
+    //   Sets type and config of event of PerfEvent
+    void set_event(PerfCounters::PerfEvent event, perf_event_attr &attr)
+    {
+        using namespace PerfCounters;
+
+        auto &type = attr.type;
+        auto &config = attr.config;
+        type = PERF_TYPE_HARDWARE;
+        switch (event) {
+        case PERF_CYCLES:
+            config = PERF_COUNT_HW_CPU_CYCLES;
+            break;
+        case PERF_INSTRUCTIONS:
+            config = PERF_COUNT_HW_INSTRUCTIONS;
+            break;
+        case PERF_L1D_MISSES:
+            type = PERF_TYPE_HW_CACHE;
+            config = PERF_COUNT_HW_CACHE_L1D |
+                    (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                    (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+            break;
+        case PERF_LLC_MISSES:
+            config = PERF_COUNT_HW_CACHE_MISSES;
+            break;
+        case PERF_BRANCH_MISSES:
+            config = PERF_COUNT_HW_BRANCH_MISSES;
+            break;
+        default:
+            config = 0;
+        }
+    }
+}
+
+PerfCounters::PerfCollector::PerfCollector()
+{
+    //   Calling thread (tid 0 means calling thread) and workers of pool
+    std::vector<long> tids = { 0 };
+    for (long tid : Parallel::get_thread_pool().get_worker_tids()) {
+        tids.push_back(tid);
+    }
+
+    fds.resize(tids.size());
+    for (size_t t = 0; t < tids.size(); ++t) {
+        for (int e = 0; e < PERF_NUM_EVENTS; ++e) {
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            set_event(PerfEvent(e), attr);
+            attr.disabled = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED |
+                    PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+            //   Given thread on any CPU (-1), without group
+            fds[t][e] = (tids[t] < 0 ? -1 : syscall(__NR_perf_event_open,
+                    &attr, tids[t], -1, -1, 0));
+            if (fds[t][e] < 0 && error.empty()) {
+                error = std::string("perf_event_open: ") +
+                        (tids[t] < 0 ? "unknown id of thread" :
+                        std::strerror(errno));
+            }
+        }
+    }
+}
+
+PerfCounters::PerfCollector::~PerfCollector()
+{
+    for (const auto &thread_fds : fds) {
+        for (int fd : thread_fds) {
+            if (fd >= 0) {
+                close(fd);
+            }
+        }
+    }
+}
+
+bool PerfCounters::PerfCollector::is_available() const
+{
+    for (int e = 0; e < PERF_NUM_EVENTS; ++e) {
+        bool opened = true;
+        for (const auto &thread_fds : fds) {
+            opened &= (thread_fds[e] >= 0);
+        }
+        if (opened) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void PerfCounters::PerfCollector::start()
+{
+    for (const auto &thread_fds : fds) {
+        for (int fd : thread_fds) {
+            if (fd >= 0) {
+                ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+                ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+            }
+        }
+    }
+}
+
+PerfCounters::PerfValues PerfCounters::PerfCollector::stop()
+{
+    for (const auto &thread_fds : fds) {
+        for (int fd : thread_fds) {
+            if (fd >= 0) {
+                ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+            }
+        }
+    }
+
+    //   Values of threads are summed. If event can't be read for one of
+    // threads, sum would be too small, so event is unavailable
+    PerfValues res;
+    for (int e = 0; e < PERF_NUM_EVENTS; ++e) {
+        bool ok = true;
+        double sum = 0;
+
+        for (const auto &thread_fds : fds) {
+            //   Value, time enabled, time running
+            uint64_t data[3];
+            if (thread_fds[e] < 0 || read(thread_fds[e], data,
+                    sizeof(data)) != sizeof(data)) {
+                ok = false;
+                break;
+            }
+
+            //   Thread which hasn't run while counter was enabled counts 0
+            if (data[2] != 0) {
+                sum += double(data[0]) * double(data[1]) / double(data[2]);
+            }
+        }
+
+        res.values[e] = (ok ? sum : 0);
+        res.available[e] = ok;
+    }
+    return res;
+}
+
+#else
+
+PerfCounters::PerfCollector::PerfCollector()
+    : error("hardware counters are supported only on Linux")
+{}
+
+PerfCounters::PerfCollector::~PerfCollector() {}
+
+bool PerfCounters::PerfCollector::is_available() const
+{
+    return false;
+}
+
+void PerfCounters::PerfCollector::start() {}
+
+PerfCounters::PerfValues PerfCounters::PerfCollector::stop()
+{
+    return PerfValues();
+}
+
+#endif
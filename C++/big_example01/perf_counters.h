@@ -0,0 +1,91 @@
+// perf_counters.h
+
+//   Hardware performance counters (Linux perf_event_open): cycles,
+// instructions, L1 data cache read misses, last level cache misses and
+// branch misses. With them benchmark shows not only time of kernel but
+// also why it takes such time: low IPC with many cache misses means that
+// kernel is memory-bound, high IPC - compute-bound.
+//   Counters can be not permitted (perf_event_paranoid, containers,
+// virtual machines) or not supported by CPU. Then they are just marked as
+// unavailable, and everything else works as before. On other systems all
+// counters are unavailable.
+//   Counters are opened for the thread which creates collector and for
+// each worker of thread pool (Parallel::get_thread_pool), and their values
+// are summed, so parallel kernels are counted fully. Threads created in
+// other ways are not counted. Event is available only if it's opened for
+// all these threads
+
+
+#ifndef PERF_COUNTERS_INCLUDE_GUARD
+#define PERF_COUNTERS_INCLUDE_GUARD
+
+#include <string>  // string
+#include <array>   // array
+#include <vector>  // vector
+
+namespace PerfCounters
+{
+    enum PerfEvent
+    {
+        PERF_CYCLES,
+        PERF_INSTRUCTIONS,
+        PERF_L1D_MISSES,
+        PERF_LLC_MISSES,
+        PERF_BRANCH_MISSES,
+
+        PERF_NUM_EVENTS,
+    };
+
+    //   Values of counters. If counter was multiplexed with others, value
+    // is scaled by time it was really counting
+    struct PerfValues
+    {
+        std::array<double, PERF_NUM_EVENTS> values{};
+        std::array<bool, PERF_NUM_EVENTS> available{};
+
+        bool has(PerfEvent event) const { return available[event]; }
+
+        //   Instructions per cycle. 0 if it's unknown
+        double ipc() const;
+
+        //   Number of events per 1000 instructions (misses per kilo
+        // instruction). 0 if it's unknown
+        double per_kilo_instruction(PerfEvent event) const;
+
+        //   All values divided by 'runs' (for average of one run)
+        PerfValues operator / (double runs) const;
+    };
+
+    //   Collector opens counters in constructor and closes them in
+    // destructor. Between 'start' and 'stop' counters are running
+    class PerfCollector
+    {
+    private:
+        //   fds[t][e] - counter of event 'e' of thread 't' (-1 if it isn't
+        // opened). Thread 0 is the thread which created collector
+        std::vector<std::array<int, PERF_NUM_EVENTS>> fds;
+
+        //   Reason why counters are unavailable (empty if all are opened)
+        std::string error;
+
+    public:
+        PerfCollector();
+        ~PerfCollector();
+
+        PerfCollector(const PerfCollector &) = delete;
+        PerfCollector &operator = (const PerfCollector &) = delete;
+
+        //   True if at least one event is available
+        bool is_available() const;
+
+        const std::string &get_error() const { return error; }
+
+        //   Resets and starts all opened counters
+        void start();
+
+        //   Stops counters and returns their values
+        PerfValues stop();
+    };
+}
+
+#endif // PERF_COUNTERS_INCLUDE_GUARD
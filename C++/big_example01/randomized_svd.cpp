@@ -0,0 +1,3 @@
+// randomized_svd.cpp
+
+#include "randomized_svd.h"
@@ -0,0 +1,335 @@
+// randomized_svd.h
+
+//   Randomized low-rank approximation of matrices (Halko, Martinsson,
+// Tropp). Range of m x n matrix A is sketched by Y = A W, where W is n x l
+// matrix of independent gaussian numbers (l = k + oversampling). Columns
+// of Y span range of A up to its singular values smaller than sigma_{k+1}.
+// With power iterations Y = (A A^T)^q A W small singular values fade
+// faster, which helps when spectrum of A decays slowly. After
+// orthonormalization of Y (Q) the small l x n matrix B = Q^T A is
+// decomposed by one-sided Jacobi method, and
+//     A ~ Q B = (Q U_B) S V^T.
+// Everything costs O(m n l (2q + 2)) operations, and products with A are
+// done in parallel by blocks of rows. Columns of W are generated by
+// separate generators seeded by number of column, so result doesn't
+// depend on number of threads
+
+
+#ifndef RANDOMIZED_SVD_INCLUDE_GUARD
+#define RANDOMIZED_SVD_INCLUDE_GUARD
+
+#include <vector>     // vector
+#include <random>     // mt19937, normal_distribution
+#include <limits>     // numeric_limits
+#include <stdexcept>  // invalid_argument
+#include <algorithm>  // min, sort
+#include <numeric>    // iota
+#include <cmath>      // abs, sqrt
+#include "matrix.h"
+#include "parallel.h"
+
+namespace MatrixFunctions
+{
+    //   Default parameters of randomized SVD and grain of parallel loops
+    // over rows of A
+    enum RSVD_constants
+    {
+        RSVD_OVERSAMPLING = 10,
+        RSVD_POWER_ITERATIONS = 2,
+        RSVD_MAX_SWEEPS = 30,
+        RSVD_GRAIN = 16,
+    };
+
+    //   Result of randomized SVD: A ~ U diag(S) V^T, U - m x k, V - n x k,
+    // S sorted in descending order
+    template <class T>
+    struct RandomizedSVD
+    {
+        Matrix<T> U, V;
+        std::vector<T> S;
+
+        //   Number of singular values bigger than tol * S[0]. If it's equal
+        // to k, real rank of A can be bigger
+        size_t rank = 0;
+    };
+
+    namespace RandomizedSVDDetail
+    {
+        //   C = A B (A - m x n, B - n x l), parallel by rows of A
+        template <class T>
+        Matrix<T> multiply(const Matrix<T> &A, const Matrix<T> &B)
+        {
+            size_t m = A.get_rows(), l = B.get_cols();
+            Matrix<T> C(m, l, T(0));
+
+            Parallel::parallel_for(0, m, [&](size_t i) {
+                const std::vector<T> &row = A[i];
+                std::vector<T> &c_row = C[i];
+                for (size_t j = 0; j < row.size(); ++j) {
+                    const T a = row[j];
+                    const std::vector<T> &b_row = B[j];
+                    for (size_t c = 0; c < l; ++c) {
+                        c_row[c] += a * b_row[c];
+                    }
+                }
+            }, RSVD_GRAIN);
+
+            return C;
+        }
+
+        //   C = A^T B (A - m x n, B - m x l), parallel by blocks of rows of
+        // C, so that each row of C is written by one thread
+        template <class T>
+        Matrix<T> multiply_transposed(const Matrix<T> &A, const Matrix<T> &B)
+        {
+            size_t m = A.get_rows(), n = A.get_cols(), l = B.get_cols();
+            Matrix<T> C(n, l, T(0));
+
+            size_t num_blocks = (n + RSVD_GRAIN - 1) / RSVD_GRAIN;
+            Parallel::parallel_for(0, num_blocks, [&](size_t block) {
+                size_t begin = block * RSVD_GRAIN;
+                size_t end = std::min(n, begin + RSVD_GRAIN);
+
+                for (size_t i = 0; i < m; ++i) {
+                    const std::vector<T> &row = A[i];
+                    const std::vector<T> &b_row = B[i];
+                    for (size_t j = begin; j < end; ++j) {
+                        const T a = row[j];
+                        std::vector<T> &c_row = C[j];
+                        for (size_t c = 0; c < l; ++c) {
+                            c_row[c] += a * b_row[c];
+                        }
+                    }
+                }
+            });
+
+            return C;
+        }
+
+        //   Orthonormalizes columns of Y in place by modified Gram-Schmidt
+        // with reorthogonalization. Columns which are linearly dependent
+        // on previous ones become zero
+        template <class T>
+        void orthonormalize(Matrix<T> &Y)
+        {
+            size_t m = Y.get_rows(), l = Y.get_cols();
+
+            //   Columns are copied to contiguous vectors
+            std::vector<std::vector<T>> cols(l, std::vector<T>(m));
+            for (size_t i = 0; i < m; ++i) {
+                for (size_t c = 0; c < l; ++c) {
+                    cols[c][i] = Y[i][c];
+                }
+            }
+
+            for (size_t c = 0; c < l; ++c) {
+                std::vector<T> &q = cols[c];
+
+                T init_norm = 0;
+                for (const T &val : q) {
+                    init_norm += val * val;
+                }
+                init_norm = std::sqrt(init_norm);
+
+                for (int pass = 0; pass < 2; ++pass) {
+                    for (size_t p = 0; p < c; ++p) {
+                        const std::vector<T> &prev = cols[p];
+                        T dot = 0;
+                        for (size_t i = 0; i < m; ++i) {
+                            dot += prev[i] * q[i];
+                        }
+                        for (size_t i = 0; i < m; ++i) {
+                            q[i] -= dot * prev[i];
+                        }
+                    }
+                }
+
+                T norm = 0;
+                for (const T &val : q) {
+                    norm += val * val;
+                }
+                norm = std::sqrt(norm);
+
+                bool dependent = (norm <= init_norm * T(m) *
+                        std::numeric_limits<T>::epsilon() || norm == T(0));
+                for (T &val : q) {
+                    val = (dependent ? T(0) : val / norm);
+                }
+            }
+
+            for (size_t i = 0; i < m; ++i) {
+                for (size_t c = 0; c < l; ++c) {
+                    Y[i][c] = cols[c][i];
+                }
+            }
+        }
+
+        //   One-sided Jacobi method for rows of B (l x n): rows are rotated
+        // in pairs until they are orthogonal. Then B = U W, where U is
+        // orthogonal and rows of W are orthogonal. B is replaced by W
+        template <class T>
+        Matrix<T> jacobi_rows(Matrix<T> &B)
+        {
+            size_t l = B.get_rows();
+            Matrix<T> U = Matrix<T>::get_I(l);
+            const T eps = std::numeric_limits<T>::epsilon();
+
+            for (int sweep = 0; sweep < RSVD_MAX_SWEEPS; ++sweep) {
+                bool rotated = false;
+
+                for (size_t p = 0; p < l; ++p) {
+                    for (size_t q = p + 1; q < l; ++q) {
+                        std::vector<T> &b_p = B[p], &b_q = B[q];
+
+                        T alpha = 0, beta = 0, gamma = 0;
+                        for (size_t j = 0; j < b_p.size(); ++j) {
+                            alpha += b_p[j] * b_p[j];
+                            beta += b_q[j] * b_q[j];
+                            gamma += b_p[j] * b_q[j];
+                        }
+
+                        if (std::abs(gamma) <= eps * std::sqrt(alpha * beta)
+                                || gamma == T(0)) {
+                            continue;
+                        }
+                        rotated = true;
+
+                        T zeta = (beta - alpha) / (2 * gamma);
+                        T t = (zeta >= 0 ? T(1) : T(-1)) /
+                                (std::abs(zeta) + std::sqrt(1 + zeta * zeta));
+                        T c = 1 / std::sqrt(1 + t * t), s = c * t;
+
+                        for (size_t j = 0; j < b_p.size(); ++j) {
+                            T x = b_p[j], y = b_q[j];
+                            b_p[j] = c * x - s * y;
+                            b_q[j] = s * x + c * y;
+                        }
+                        for (size_t i = 0; i < l; ++i) {
+                            T x = U[i][p], y = U[i][q];
+                            U[i][p] = c * x - s * y;
+                            U[i][q] = s * x + c * y;
+                        }
+                    }
+                }
+
+                if (!rotated) {
+                    break;
+                }
+            }
+
+            return U;
+        }
+    }
+
+    //   Orthonormal m x l matrix Q whose columns approximately span range
+    // of A. 'power_iterations' - number of multiplications by A A^T
+    template <class T>
+    Matrix<T> randomized_range_finder(const Matrix<T> &A, size_t l,
+            size_t power_iterations = RSVD_POWER_ITERATIONS,
+            unsigned seed = 0)
+    {
+        using namespace RandomizedSVDDetail;
+
+        size_t n = A.get_cols();
+
+        //   Gaussian sketch, generated by columns
+        Matrix<T> W(n, l);
+        Parallel::parallel_for(0, l, [&](size_t c) {
+            std::mt19937 gen(seed + c);
+            std::normal_distribution<T> nd;
+            for (size_t j = 0; j < n; ++j) {
+                W[j][c] = nd(gen);
+            }
+        });
+
+        Matrix<T> Q = multiply(A, W);
+        orthonormalize(Q);
+
+        for (size_t it = 0; it < power_iterations; ++it) {
+            Matrix<T> Z = multiply_transposed(A, Q);
+            orthonormalize(Z);
+            Q = multiply(A, Z);
+            orthonormalize(Q);
+        }
+
+        return Q;
+    }
+
+    //   Approximation of A by 'k' main singular triplets. Rank is estimated
+    // as number of singular values bigger than tol * (biggest one)
+    template <class T>
+    RandomizedSVD<T> randomized_svd(const Matrix<T> &A, size_t k,
+            T tol = T(1e-9),
+            size_t oversampling = RSVD_OVERSAMPLING,
+            size_t power_iterations = RSVD_POWER_ITERATIONS,
+            unsigned seed = 0)
+    {
+        using namespace RandomizedSVDDetail;
+
+        size_t m = A.get_rows(), n = A.get_cols();
+        if (k == 0) {
+            throw std::invalid_argument("randomized_svd: number of singular "
+                    "values must be positive");
+        }
+
+        k = std::min(k, std::min(m, n));
+        size_t l = std::min(k + oversampling, std::min(m, n));
+
+        Matrix<T> Q = randomized_range_finder(A, l, power_iterations, seed);
+
+        //   B = Q^T A (l x n) = (A^T Q)^T
+        Matrix<T> B = multiply_transposed(A, Q).get_transposed();
+        Matrix<T> UB = jacobi_rows(B);
+
+        std::vector<T> sigma(l);
+        for (size_t a = 0; a < l; ++a) {
+            T norm = 0;
+            for (const T &val : B[a]) {
+                norm += val * val;
+            }
+            sigma[a] = std::sqrt(norm);
+        }
+
+        std::vector<size_t> order(l);
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+            return sigma[a] > sigma[b];
+        });
+
+        RandomizedSVD<T> res;
+        res.S.resize(k);
+        res.V = Matrix<T>(n, k, T(0));
+        Matrix<T> UB_k(l, k);
+        for (size_t a = 0; a < k; ++a) {
+            size_t idx = order[a];
+            res.S[a] = sigma[idx];
+
+            if (sigma[idx] > T(0)) {
+                for (size_t j = 0; j < n; ++j) {
+                    res.V[j][a] = B[idx][j] / sigma[idx];
+                }
+            }
+            for (size_t i = 0; i < l; ++i) {
+                UB_k[i][a] = UB[i][idx];
+            }
+
+            if (res.S[a] > tol * res.S[0]) {
+                ++res.rank;
+            }
+        }
+        res.U = multiply(Q, UB_k);
+
+        return res;
+    }
+
+    //   Numerical rank of A by randomized SVD: number of singular values
+    // bigger than tol * (biggest one), but not more than 'max_rank'
+    template <class T>
+    size_t rank_randomized(const Matrix<T> &A, size_t max_rank,
+            T tol = T(1e-9))
+    {
+        return randomized_svd(A, max_rank, tol).rank;
+    }
+}
+
+#endif // RANDOMIZED_SVD_INCLUDE_GUARD
@@ -0,0 +1,202 @@
+// result_sink.cpp
+
+#include "result_sink.h"
+#include "tracing.h"
+#include <fstream>               // ifstream, ofstream
+#include <chrono>                // microseconds
+#include <cstdio>                // snprintf
+#include <stdexcept>             // invalid_argument
+#include <boost/filesystem.hpp>  // path, create_directories
+
+Results::ResultSink::ResultSink(const std::string &path)
+    : archive(path, std::ios::out | std::ios::trunc | std::ios::binary),
+      closed(false)
+{
+    if (!archive) {
+        throw std::invalid_argument("class ResultSink: can't open archive " +
+                path);
+    }
+
+    writer = std::thread([this]() { writer_loop(); });
+}
+
+Results::ResultSink::~ResultSink()
+{
+    close();
+}
+
+void Results::ResultSink::write(std::string file, std::string content)
+{
+    queue.push(Record{ std::move(file), std::move(content) });
+}
+
+void Results::ResultSink::close()
+{
+    if (closed.exchange(true)) {
+        return;
+    }
+
+    writer.join();
+    archive.close();
+}
+
+void Results::ResultSink::writer_loop()
+{
+    Record record;
+    while (true) {
+        //   All records which are in queue are written in one span
+        if (queue.pop(record)) {
+            TRACE_SCOPE("write records", "io");
+            do {
+                write_record(record);
+            } while (queue.pop(record));
+            continue;
+        }
+
+        //   Queue is empty. If sink is closed, nothing can be added, but
+        // records which were added before closing must be written
+        if (closed.load()) {
+            while (queue.pop(record)) {
+                write_record(record);
+            }
+            break;
+        }
+
+        std::this_thread::sleep_for(
+                std::chrono::microseconds(WRITER_SLEEP_US));
+    }
+
+    archive.flush();
+}
+
+void Results::ResultSink::write_record(const Record &record)
+{
+    archive << "{\"file\":\"" << json_escape(record.file) <<
+            "\",\"content\":\"" << json_escape(record.content) << "\"}\n";
+}
+
+std::string Results::json_escape(const std::string &str)
+{
+    std::string res;
+    res.reserve(str.size());
+
+    for (char c : str) {
+        switch (c) {
+        case '"':  res += "\\\""; break;
+        case '\\': res += "\\\\"; break;
+        case '\n': res += "\\n";  break;
+        case '\t': res += "\\t";  break;
+        case '\r': res += "\\r";  break;
+        default:
+            if ((unsigned char) c < 0x20) {
+                char buf[8];
+                std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+                res += buf;
+            } else {
+                res += c;
+            }
+        }
+    }
+
+    return res;
+}
+
+namespace
+{
+    const std::string exception_bad_record =
+            "parse_record: line is not a record of archive";
+
+    //   Reads JSON string starting at 'pos' (at opening quote) and moves
+    // 'pos' after closing quote. Only escapes written by 'json_escape'
+    // are supported
+    std::string read_json_string(const std::string &line, size_t &pos)
+    {
+        if (pos >= line.size() || line[pos] != '"') {
+            throw std::invalid_argument(exception_bad_record);
+        }
+
+        std::string res;
+        for (++pos; pos < line.size() && line[pos] != '"'; ++pos) {
+            if (line[pos] != '\\') {
+                res += line[pos];
+                continue;
+            }
+
+            if (++pos >= line.size()) {
+                break;
+            }
+            switch (line[pos]) {
+            case 'n': res += '\n'; break;
+            case 't': res += '\t'; break;
+            case 'r': res += '\r'; break;
+            case 'u':
+                if (pos + 4 >= line.size()) {
+                    throw std::invalid_argument(exception_bad_record);
+                }
+                res += (char) std::stoi(line.substr(pos + 1, 4), nullptr, 16);
+                pos += 4;
+                break;
+            default:  res += line[pos];
+            }
+        }
+
+        if (pos >= line.size()) {
+            throw std::invalid_argument(exception_bad_record);
+        }
+        ++pos;
+
+        return res;
+    }
+
+    //   Checks that 'expected' is at 'pos' and moves 'pos' after it
+    void expect(const std::string &line, size_t &pos,
+            const std::string &expected)
+    {
+        if (line.compare(pos, expected.size(), expected) != 0) {
+            throw std::invalid_argument(exception_bad_record);
+        }
+        pos += expected.size();
+    }
+}
+
+Results::Record Results::parse_record(const std::string &line)
+{
+    Record record;
+    size_t pos = 0;
+
+    expect(line, pos, "{\"file\":");
+    record.file = read_json_string(line, pos);
+    expect(line, pos, ",\"content\":");
+    record.content = read_json_string(line, pos);
+    expect(line, pos, "}");
+
+    return record;
+}
+
+void Results::expand_archive(const std::string &path, const std::string &root)
+{
+    TRACE_SCOPE("expand archive", "io");
+
+    std::ifstream archive(path, std::ios::binary);
+    if (!archive) {
+        throw std::invalid_argument("expand_archive: can't open archive " +
+                path);
+    }
+
+    std::string line;
+    while (std::getline(archive, line)) {
+        if (line.empty()) {
+            continue;
+        }
+
+        Record record = parse_record(line);
+        boost::filesystem::path file = boost::filesystem::path(root) /
+                record.file;
+        if (file.has_parent_path()) {
+            boost::filesystem::create_directories(file.parent_path());
+        }
+
+        std::ofstream fout(file.string(), std::ios::binary);
+        fout << record.content;
+    }
+}
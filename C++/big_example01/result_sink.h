@@ -0,0 +1,150 @@
+// result_sink.h
+
+//   Here I define sink for results of tests (answers, determinants,
+// inverse matrices, ...). Instead of opening one file per test, threads
+// which compute results put records (name of file and its content) to
+// lock-free queue, and one background thread appends them to single
+// archive in JSONL format (one JSON object per line):
+//     {"file":"answer_SLEGU/ans01.txt","content":"..."}
+// So threads don't wait for file system. After all results are written,
+// archive can be expanded to usual layout with one file per record
+
+
+#ifndef RESULT_SINK_INCLUDE_GUARD
+#define RESULT_SINK_INCLUDE_GUARD
+
+#include <string>   // string
+#include <fstream>  // ofstream
+#include <thread>   // thread
+#include <atomic>   // atomic
+#include <utility>  // move
+
+namespace Results
+{
+    //   Unbounded multi-producer single-consumer queue (Vyukov). 'push'
+    // takes one atomic exchange and can be called from any number of
+    // threads at once, 'pop' is called only by one consumer thread. Queue
+    // always contains one dummy node: 'tail' is the last popped node,
+    // elements are in nodes after it
+    template <class T>
+    class LockFreeQueue
+    {
+    private:
+        struct Node
+        {
+            std::atomic<Node *> next;
+            T value;
+
+            Node() : next(nullptr) {}
+        };
+
+        //   Producers add nodes after 'head', consumer takes them after
+        // 'tail'
+        std::atomic<Node *> head;
+        Node *tail;
+
+    public:
+        LockFreeQueue()
+        {
+            tail = new Node();
+            head.store(tail);
+        }
+
+        ~LockFreeQueue()
+        {
+            while (tail) {
+                Node *next = tail->next.load();
+                delete tail;
+                tail = next;
+            }
+        }
+
+        LockFreeQueue(const LockFreeQueue &) = delete;
+        LockFreeQueue &operator = (const LockFreeQueue &) = delete;
+
+        void push(T value)
+        {
+            Node *node = new Node();
+            node->value = std::move(value);
+
+            Node *prev = head.exchange(node, std::memory_order_acq_rel);
+            prev->next.store(node, std::memory_order_release);
+        }
+
+        //   Returns false if queue is empty. Element which is being added
+        // right now can be not seen yet
+        bool pop(T &value)
+        {
+            Node *next = tail->next.load(std::memory_order_acquire);
+            if (!next) {
+                return false;
+            }
+
+            value = std::move(next->value);
+            delete tail;
+            tail = next;
+            return true;
+        }
+    };
+
+    //   Record of archive: file and its whole content
+    struct Record
+    {
+        std::string file;
+        std::string content;
+    };
+
+    //   Sink which writes records to archive in background thread
+    class ResultSink
+    {
+    private:
+        //   Writer sleeps for WRITER_SLEEP_US microseconds when queue is
+        // empty
+        enum
+        {
+            WRITER_SLEEP_US = 200,
+        };
+
+        std::ofstream archive;
+        LockFreeQueue<Record> queue;
+        std::atomic<bool> closed;
+        std::thread writer;
+
+        //   Main loop of writer thread
+        void writer_loop();
+
+        //   Appends record to archive (only in writer thread)
+        void write_record(const Record &record);
+
+    public:
+        //   Creates (or truncates) archive. Throws invalid_argument if
+        // it can't be opened
+        explicit ResultSink(const std::string &path);
+
+        //   Calls 'close'
+        ~ResultSink();
+
+        ResultSink(const ResultSink &) = delete;
+        ResultSink &operator = (const ResultSink &) = delete;
+
+        //   Adds record. Can be called from many threads at once. 'file'
+        // gets the whole 'content', so each file must be written once
+        void write(std::string file, std::string content);
+
+        //   Waits until all records are written and closes archive. All
+        // calls of 'write' must be finished before it
+        void close();
+    };
+
+    //   Escaping of string for JSON and parsing of record from line of
+    // archive. 'parse_record' throws invalid_argument if line isn't record
+    std::string json_escape(const std::string &str);
+    Record parse_record(const std::string &line);
+
+    //   Writes each record of archive to its own file (relative to 'root').
+    // Directories are created if they don't exist
+    void expand_archive(const std::string &path,
+            const std::string &root = "");
+}
+
+#endif // RESULT_SINK_INCLUDE_GUARD
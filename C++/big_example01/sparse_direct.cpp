@@ -0,0 +1,3 @@
+// sparse_direct.cpp
+
+#include "sparse_direct.h"
@@ -0,0 +1,710 @@
+// sparse_direct.h
+
+//   Direct solver of SLE with sparse left part. Rows and columns are
+// reordered to reduce fill-in (RCM or minimum degree ordering), then
+// symbolic factorization finds structure of L and U factors. It depends
+// only on pattern of matrix, so it's made once and reused for matrices
+// with the same pattern and other values. Numeric factorization is
+// left-looking (column by column), the last columns, where factors
+// become dense, form one dense front which is factorized by usual LU
+// with partial pivoting.
+//   Sparse columns are factorized without pivoting, so the solver is
+// meant for matrices with diagonal dominance or positive definite ones
+
+
+#ifndef SPARSE_DIRECT_INCLUDE_GUARD
+#define SPARSE_DIRECT_INCLUDE_GUARD
+
+#include <vector>     // vector
+#include <set>        // set
+#include <string>     // string
+#include <limits>     // numeric_limits
+#include <stdexcept>  // invalid_argument, domain_error, logic_error
+#include <algorithm>  // sort, unique, reverse
+#include <cmath>      // abs, isfinite
+#include <utility>    // pair
+#include "matrix.h"
+#include "sparse_matrix.h"
+#include "gaussian_method.h"
+
+namespace SLESolvers
+{
+    //   Orderings of rows and columns
+    enum SD_ordering
+    {
+        SD_NATURAL,
+
+        //   Reverse Cuthill-McKee: reduces bandwidth of matrix
+        SD_RCM,
+
+        //   Approximate minimum degree: on each step eliminates node of
+        // elimination graph with (approximately) minimum number of
+        // neighbours
+        SD_MINIMUM_DEGREE,
+    };
+
+    //   Types of factorization
+    enum SD_factorization
+    {
+        //   A = L U for any matrix with symmetric or nonsymmetric values
+        SD_LU,
+
+        //   A = L D L^T for symmetric matrices (half of work of LU)
+        SD_LDLT,
+    };
+
+    //   Fill-reducing orderings. Ordering is vector 'perm': row (and
+    // column) 'i' of reordered matrix is row perm[i] of original one
+    namespace Ordering
+    {
+        //   Adjacency lists of graph of matrix A + A^T (without diagonal)
+        template <class T>
+        std::vector<std::vector<size_t>> get_adjacency(const SparseMatrix<T> &A)
+        {
+            size_t n = A.get_rows();
+            const auto &row_ptr = A.get_row_ptr();
+            const auto &col_ind = A.get_col_ind();
+
+            std::vector<std::vector<size_t>> adj(n);
+            for (size_t i = 0; i < n; ++i) {
+                for (size_t p = row_ptr[i]; p < row_ptr[i + 1]; ++p) {
+                    size_t j = col_ind[p];
+                    if (j != i) {
+                        adj[i].push_back(j);
+                        adj[j].push_back(i);
+                    }
+                }
+            }
+
+            for (auto &list : adj) {
+                std::sort(list.begin(), list.end());
+                list.erase(std::unique(list.begin(), list.end()), list.end());
+            }
+
+            return adj;
+        }
+
+        //   Reverse Cuthill-McKee ordering. Each connected component is
+        // traversed by BFS from pseudo-peripheral node, neighbours are
+        // visited in order of increasing degree. Then order is reversed
+        inline std::vector<size_t> reverse_cuthill_mckee(
+                const std::vector<std::vector<size_t>> &adj)
+        {
+            size_t n = adj.size();
+            std::vector<size_t> order;
+            std::vector<bool> visited(n, false);
+
+            //   BFS from 'start' over not visited nodes. Returns order of
+            // nodes and fills 'last_level' with nodes of the last level
+            std::vector<size_t> level(n);
+            auto bfs = [&](size_t start, std::vector<size_t> &last_level,
+                    bool sort_by_degree) {
+                std::vector<size_t> res(1, start);
+                std::vector<bool> in_bfs(n, false);
+                in_bfs[start] = true;
+                level[start] = 0;
+
+                for (size_t head = 0; head < res.size(); ++head) {
+                    size_t v = res[head];
+                    size_t first_new = res.size();
+
+                    for (size_t u : adj[v]) {
+                        if (!visited[u] && !in_bfs[u]) {
+                            in_bfs[u] = true;
+                            level[u] = level[v] + 1;
+                            res.push_back(u);
+                        }
+                    }
+
+                    if (sort_by_degree) {
+                        std::sort(res.begin() + first_new, res.end(),
+                                [&](size_t a, size_t b) {
+                                    return adj[a].size() < adj[b].size();
+                                });
+                    }
+                }
+
+                last_level.clear();
+                for (size_t v : res) {
+                    if (level[v] == level[res.back()]) {
+                        last_level.push_back(v);
+                    }
+                }
+                return res;
+            };
+
+            for (size_t s = 0; s < n; ++s) {
+                if (visited[s]) {
+                    continue;
+                }
+
+                //   Looking for pseudo-peripheral node: node of last BFS
+                // level with minimum degree while eccentricity grows
+                size_t start = s;
+                std::vector<size_t> last_level;
+                auto comp = bfs(start, last_level, false);
+                size_t ecc = level[comp.back()];
+
+                for (int attempt = 0; attempt < 10; ++attempt) {
+                    size_t cand = last_level[0];
+                    for (size_t v : last_level) {
+                        if (adj[v].size() < adj[cand].size()) {
+                            cand = v;
+                        }
+                    }
+
+                    std::vector<size_t> cand_last;
+                    auto cand_comp = bfs(cand, cand_last, false);
+                    if (level[cand_comp.back()] <= ecc) {
+                        break;
+                    }
+
+                    start = cand;
+                    ecc = level[cand_comp.back()];
+                    last_level = cand_last;
+                }
+
+                for (size_t v : bfs(start, last_level, true)) {
+                    visited[v] = true;
+                    order.push_back(v);
+                }
+            }
+
+            std::reverse(order.begin(), order.end());
+            return order;
+        }
+
+        //   Approximate minimum degree ordering. Elimination graph is
+        // stored as quotient graph: eliminated nodes become 'elements'
+        // (cliques given by list of their variables), so memory doesn't
+        // grow. Degree of variable is not computed exactly but bounded
+        // from above as in AMD algorithm: |A_i| + |L_p \ i| + sum of
+        // |L_e \ L_p| over other elements 'e' of variable 'i'
+        inline std::vector<size_t> minimum_degree(
+                const std::vector<std::vector<size_t>> &adj)
+        {
+            size_t n = adj.size();
+            enum { VARIABLE, ELEMENT, ABSORBED };
+
+            //   'vars[i]' - variables adjacent to 'i', 'elems[i]' -
+            // elements adjacent to 'i', 'elem_vars[e]' - variables of
+            // element 'e'
+            std::vector<std::vector<size_t>> vars(adj), elems(n), elem_vars(n);
+            std::vector<int> state(n, VARIABLE);
+            std::vector<size_t> degree(n);
+
+            std::set<std::pair<size_t, size_t>> queue;
+            for (size_t i = 0; i < n; ++i) {
+                degree[i] = adj[i].size();
+                queue.insert({ degree[i], i });
+            }
+
+            //   'in_pivot[i] == p + 1' means that 'i' is in L_p. 'outside[e]'
+            // - |L_e \ L_p| (or n if it isn't computed yet)
+            std::vector<size_t> in_pivot(n, 0), outside(n, n), touched;
+            std::vector<size_t> order;
+
+            for (size_t k = 0; k < n; ++k) {
+                size_t p = queue.begin()->second;
+                queue.erase(queue.begin());
+                order.push_back(p);
+                state[p] = ELEMENT;
+
+                //   L_p: variables adjacent to 'p' and variables of its
+                // elements, which are absorbed by new element
+                std::vector<size_t> &Lp = elem_vars[p];
+                auto add = [&](size_t i) {
+                    if (state[i] == VARIABLE && in_pivot[i] != p + 1) {
+                        in_pivot[i] = p + 1;
+                        Lp.push_back(i);
+                    }
+                };
+
+                for (size_t i : vars[p]) {
+                    add(i);
+                }
+                for (size_t e : elems[p]) {
+                    if (state[e] == ELEMENT) {
+                        for (size_t i : elem_vars[e]) {
+                            add(i);
+                        }
+                        state[e] = ABSORBED;
+                        std::vector<size_t>().swap(elem_vars[e]);
+                    }
+                }
+                std::vector<size_t>().swap(vars[p]);
+                std::vector<size_t>().swap(elems[p]);
+
+                //   |L_e \ L_p| for elements of variables of L_p
+                touched.clear();
+                for (size_t i : Lp) {
+                    for (size_t e : elems[i]) {
+                        if (state[e] != ELEMENT) {
+                            continue;
+                        }
+                        if (outside[e] == n) {
+                            auto &Le = elem_vars[e];
+                            Le.erase(std::remove_if(Le.begin(), Le.end(),
+                                    [&](size_t j) {
+                                        return state[j] != VARIABLE;
+                                    }), Le.end());
+                            outside[e] = Le.size();
+                            touched.push_back(e);
+                        }
+                        --outside[e];
+                    }
+                }
+
+                //   Update lists and degrees of variables of L_p
+                for (size_t i : Lp) {
+                    auto &Ei = elems[i];
+                    Ei.erase(std::remove_if(Ei.begin(), Ei.end(),
+                            [&](size_t e) {
+                                return state[e] != ELEMENT;
+                            }), Ei.end());
+
+                    auto &Ai = vars[i];
+                    Ai.erase(std::remove_if(Ai.begin(), Ai.end(),
+                            [&](size_t j) {
+                                return state[j] != VARIABLE ||
+                                        in_pivot[j] == p + 1;
+                            }), Ai.end());
+
+                    size_t d = Ai.size() + Lp.size() - 1;
+                    for (size_t e : Ei) {
+                        d += outside[e];
+                    }
+                    d = std::min(d, degree[i] + Lp.size() - 1);
+                    d = std::min(d, n - k - 2);
+
+                    Ei.push_back(p);
+
+                    queue.erase({ degree[i], i });
+                    degree[i] = d;
+                    queue.insert({ degree[i], i });
+                }
+
+                for (size_t e : touched) {
+                    outside[e] = n;
+                }
+            }
+
+            return order;
+        }
+    }
+
+
+    //   Sparse LU (or LDL^T) factorization
+    template <class T>
+    class SparseLU
+    {
+    private:
+        static const std::string exception_prefix;
+
+        size_t n = 0;
+        SD_factorization type = SD_LU;
+
+        //   Matrix which was analyzed (only its pattern is used)
+        SparseMatrix<T> pattern;
+
+        //   Ordering and inverse ordering
+        std::vector<size_t> perm, iperm;
+
+        //   Reordered matrix B = P A P^T by columns: column 'j' has rows
+        // Bi[p] for p from Bp[j] to Bp[j + 1], value of element is
+        // A.values[Bk[p]]
+        std::vector<size_t> Bp, Bi, Bk;
+
+        //   Structure of factors: column 'j' of L (rows > j) is Li[p],
+        // p from Lp[j] to Lp[j + 1]; column 'j' of U (rows < j) is Ui[p],
+        // p from Up[j] to Up[j + 1]. Rows are sorted
+        std::vector<size_t> Lp, Li, Up, Ui;
+
+        //   Columns from 'dense_start' form dense front
+        size_t dense_start = 0;
+
+        //   Values of factors. 'diag' is diagonal of U (or D for LDL^T)
+        std::vector<T> Lx, Ux, diag;
+        GaussianJordanElimination::LUFactorization<T> front;
+
+        bool factorized = false;
+
+    public:
+        SparseLU() = default;
+
+        //   Makes ordering and symbolic factorization of A
+        SparseLU(const SparseMatrix<T> &A, SD_ordering ordering =
+                SD_MINIMUM_DEGREE, SD_factorization type_init = SD_LU)
+        {
+            analyze(A, ordering, type_init);
+        }
+
+        //   Ordering and symbolic factorization
+        void analyze(const SparseMatrix<T> &A, SD_ordering ordering =
+                SD_MINIMUM_DEGREE, SD_factorization type_init = SD_LU)
+        {
+            if (A.get_rows() != A.get_cols()) {
+                throw std::invalid_argument(exception_prefix +
+                        "matrix must be square");
+            }
+
+            n = A.get_rows();
+            type = type_init;
+            pattern = A;
+            factorized = false;
+
+            //   Ordering
+            auto adj = Ordering::get_adjacency(A);
+            if (ordering == SD_RCM) {
+                perm = Ordering::reverse_cuthill_mckee(adj);
+            } else if (ordering == SD_MINIMUM_DEGREE) {
+                perm = Ordering::minimum_degree(adj);
+            } else {
+                perm.resize(n);
+                for (size_t i = 0; i < n; ++i) {
+                    perm[i] = i;
+                }
+            }
+
+            iperm.resize(n);
+            for (size_t i = 0; i < n; ++i) {
+                iperm[perm[i]] = i;
+            }
+
+            //   Columns of reordered matrix
+            const auto &row_ptr = A.get_row_ptr();
+            const auto &col_ind = A.get_col_ind();
+
+            Bp.assign(n + 1, 0);
+            for (size_t p = 0; p < col_ind.size(); ++p) {
+                ++Bp[iperm[col_ind[p]] + 1];
+            }
+            for (size_t j = 0; j < n; ++j) {
+                Bp[j + 1] += Bp[j];
+            }
+
+            Bi.resize(col_ind.size());
+            Bk.resize(col_ind.size());
+            std::vector<size_t> pos(Bp.begin(), Bp.end() - 1);
+            for (size_t r = 0; r < n; ++r) {
+                for (size_t p = row_ptr[r]; p < row_ptr[r + 1]; ++p) {
+                    size_t dst = pos[iperm[col_ind[p]]]++;
+                    Bi[dst] = iperm[r];
+                    Bk[dst] = p;
+                }
+            }
+
+            //   Graph of reordered matrix
+            std::vector<std::vector<size_t>> S(n);
+            for (size_t i = 0; i < n; ++i) {
+                for (size_t j : adj[perm[i]]) {
+                    S[i].push_back(iperm[j]);
+                }
+            }
+
+            //   Elimination tree (Liu's algorithm)
+            const size_t NONE = n;
+            std::vector<size_t> parent(n, NONE), ancestor(n, NONE);
+            for (size_t k = 0; k < n; ++k) {
+                for (size_t i : S[k]) {
+                    while (i != NONE && i < k) {
+                        size_t next = ancestor[i];
+                        ancestor[i] = k;
+                        if (next == NONE) {
+                            parent[i] = k;
+                        }
+                        i = next;
+                    }
+                }
+            }
+
+            //   Row 'k' of L consists of nodes of paths in elimination
+            // tree from neighbours of 'k' to 'k'. It's column 'k' of U
+            std::vector<size_t> mark(n, NONE), row;
+            std::vector<size_t> L_count(n, 0);
+            Up.assign(1, 0);
+            Ui.clear();
+
+            for (size_t k = 0; k < n; ++k) {
+                row.clear();
+                mark[k] = k;
+
+                for (size_t i : S[k]) {
+                    for (; i < k && mark[i] != k; i = parent[i]) {
+                        mark[i] = k;
+                        row.push_back(i);
+                    }
+                }
+
+                std::sort(row.begin(), row.end());
+                for (size_t i : row) {
+                    Ui.push_back(i);
+                    ++L_count[i];
+                }
+                Up.push_back(Ui.size());
+            }
+
+            //   Columns of L are transposed rows
+            Lp.assign(n + 1, 0);
+            for (size_t j = 0; j < n; ++j) {
+                Lp[j + 1] = Lp[j] + L_count[j];
+            }
+
+            Li.resize(Lp[n]);
+            std::vector<size_t> L_pos(Lp.begin(), Lp.end() - 1);
+            for (size_t k = 0; k < n; ++k) {
+                for (size_t p = Up[k]; p < Up[k + 1]; ++p) {
+                    Li[L_pos[Ui[p]]++] = k;
+                }
+            }
+
+            //   Dense front: last columns of L which have all elements
+            // under diagonal
+            dense_start = n;
+            while (dense_start > 0 &&
+                    L_count[dense_start - 1] == n - dense_start) {
+                --dense_start;
+            }
+        }
+
+        //   Numeric factorization. Matrix must have the same pattern as
+        // analyzed one
+        void factorize(const SparseMatrix<T> &A)
+        {
+            if (!A.has_same_pattern(pattern)) {
+                throw std::invalid_argument(exception_prefix +
+                        "pattern of matrix differs from analyzed one");
+            }
+
+            if (type == SD_LDLT &&
+                    !A.is_symmetric(std::numeric_limits<T>::epsilon() * 100)) {
+                throw std::domain_error(exception_prefix +
+                        "LDL^T factorization needs symmetric matrix");
+            }
+
+            const auto &values = A.get_values();
+            size_t d = dense_start;
+            size_t m = n - d;
+
+            Lx.assign(Li.size(), T(0));
+            Ux.assign(Ui.size(), T(0));
+            diag.assign(n, T(0));
+            Matrix<T> F(m, m, 0);
+
+            //   'x' - column which is computed now. 'next[k]' - position
+            // of first element of column 'k' of L which isn't used yet
+            // (for LDL^T)
+            std::vector<T> x(n, T(0));
+            std::vector<size_t> next(Lp.begin(), Lp.end() - 1);
+
+            auto check_pivot = [this](const T &pivot) {
+                if (!(std::abs(pivot) > 0) || !std::isfinite(pivot)) {
+                    throw std::domain_error(exception_prefix +
+                            "zero pivot, matrix needs pivoting");
+                }
+            };
+
+            for (size_t j = 0; j < n; ++j) {
+                for (size_t p = Bp[j]; p < Bp[j + 1]; ++p) {
+                    if (type == SD_LU || Bi[p] >= j) {
+                        x[Bi[p]] = values[Bk[p]];
+                    }
+                }
+
+                //   Updates by previous sparse columns
+                for (size_t q = Up[j]; q < Up[j + 1] && Ui[q] < d; ++q) {
+                    size_t k = Ui[q];
+
+                    if (type == SD_LU) {
+                        T ukj = x[k];
+                        for (size_t p = Lp[k]; p < Lp[k + 1]; ++p) {
+                            x[Li[p]] -= Lx[p] * ukj;
+                        }
+                    } else {
+                        //   Li[next[k]] == j, so U(k, j) = D(k) L(j, k)
+                        T ljk = Lx[next[k]];
+                        T ukj = ljk * diag[k];
+
+                        x[j] -= ljk * ukj;
+                        for (size_t p = next[k] + 1; p < Lp[k + 1]; ++p) {
+                            x[Li[p]] -= Lx[p] * ukj;
+                        }
+                        ++next[k];
+                    }
+                }
+
+                if (j < d) {
+                    //   Column of sparse part
+                    for (size_t q = Up[j]; q < Up[j + 1]; ++q) {
+                        Ux[q] = x[Ui[q]];
+                    }
+
+                    check_pivot(x[j]);
+                    diag[j] = x[j];
+
+                    for (size_t p = Lp[j]; p < Lp[j + 1]; ++p) {
+                        Lx[p] = x[Li[p]] / diag[j];
+                    }
+                } else {
+                    //   Column of dense front. Rows of U above front are
+                    // saved, other elements are moved to front
+                    for (size_t q = Up[j]; q < Up[j + 1] && Ui[q] < d; ++q) {
+                        Ux[q] = x[Ui[q]];
+                    }
+
+                    for (size_t i = (type == SD_LU ? d : j); i < n; ++i) {
+                        F[i - d][j - d] = x[i];
+                        if (type == SD_LDLT) {
+                            F[j - d][i - d] = x[i];
+                        }
+                    }
+                }
+
+                //   Clear column
+                for (size_t q = Up[j]; q < Up[j + 1]; ++q) {
+                    x[Ui[q]] = 0;
+                }
+                for (size_t p = Lp[j]; p < Lp[j + 1]; ++p) {
+                    x[Li[p]] = 0;
+                }
+                x[j] = 0;
+            }
+
+            if (m > 0) {
+                front = GaussianJordanElimination::
+                        lu_factorize_max_element(F);
+            }
+
+            factorized = true;
+        }
+
+        //   Solves SLE A X = B. All columns of B are solved
+        Matrix<T> solve(const Matrix<T> &B) const
+        {
+            if (!factorized) {
+                throw std::logic_error(exception_prefix +
+                        "matrix isn't factorized");
+            }
+
+            if (B.get_rows() != n) {
+                throw std::invalid_argument(exception_prefix +
+                        "right part of SLE has wrong number of rows");
+            }
+
+            size_t d = dense_start;
+            size_t m = n - d;
+
+            Matrix<T> X(n, B.get_cols());
+            std::vector<T> b(n);
+            Matrix<T> b2(m, 1);
+
+            for (size_t c = 0; c < B.get_cols(); ++c) {
+                for (size_t i = 0; i < n; ++i) {
+                    b[i] = B[perm[i]][c];
+                }
+
+                //   L y = b (L has ones on diagonal)
+                for (size_t k = 0; k < d; ++k) {
+                    for (size_t p = Lp[k]; p < Lp[k + 1]; ++p) {
+                        b[Li[p]] -= Lx[p] * b[k];
+                    }
+                }
+
+                //   Dense front
+                if (m > 0) {
+                    for (size_t i = 0; i < m; ++i) {
+                        b2[i][0] = b[d + i];
+                    }
+                    b2 = GaussianJordanElimination::lu_solve(front, b2);
+                    for (size_t i = 0; i < m; ++i) {
+                        b[d + i] = b2[i][0];
+                    }
+                }
+
+                if (type == SD_LU) {
+                    //   U x = y by columns of U
+                    for (size_t j = n; j-- > d; ) {
+                        for (size_t q = Up[j]; q < Up[j + 1] && Ui[q] < d;
+                                ++q) {
+                            b[Ui[q]] -= Ux[q] * b[j];
+                        }
+                    }
+                    for (size_t j = d; j-- > 0; ) {
+                        b[j] /= diag[j];
+                        for (size_t q = Up[j]; q < Up[j + 1]; ++q) {
+                            b[Ui[q]] -= Ux[q] * b[j];
+                        }
+                    }
+                } else {
+                    //   D L^T x = y by columns of L
+                    for (size_t k = d; k-- > 0; ) {
+                        T sum = b[k] / diag[k];
+                        for (size_t p = Lp[k]; p < Lp[k + 1]; ++p) {
+                            sum -= Lx[p] * b[Li[p]];
+                        }
+                        b[k] = sum;
+                    }
+                }
+
+                for (size_t i = 0; i < n; ++i) {
+                    X[perm[i]][c] = b[i];
+                }
+            }
+
+            return X;
+        }
+
+        //   Number of elements in L and U factors (without dense front)
+        size_t get_factors_nnz() const
+        {
+            return Li.size() + (type == SD_LU ? Ui.size() : 0) + n;
+        }
+
+        //   Size of dense front
+        size_t get_dense_front_size() const
+        {
+            return n - dense_start;
+        }
+    };
+
+    template <class T>
+    const std::string SparseLU<T>::exception_prefix = "class SparseLU: ";
+
+
+    //   Sparse direct solver of SLE. All columns of f are solved
+    template <class T>
+    Matrix<T> SLE_sparse_direct(const SparseMatrix<T> &A, const Matrix<T> &f,
+            SD_ordering ordering = SD_MINIMUM_DEGREE,
+            SD_factorization type = SD_LU)
+    {
+        //   If number of rows of A and f are not equal we leave
+        if (A.get_rows() != f.get_rows()) {
+            throw std::invalid_argument("SLE_sparse_direct: left and right "
+                    "parts of SLE must have the same number of rows");
+        }
+
+        SparseLU<T> lu(A, ordering, type);
+        lu.factorize(A);
+
+        return lu.solve(f);
+    }
+
+    //   Sparse direct solver for dense left part. Zeros are dropped first
+    template <class T>
+    Matrix<T> SLE_sparse_direct(const Matrix<T> &A, const Matrix<T> &f,
+            SD_ordering ordering = SD_MINIMUM_DEGREE,
+            SD_factorization type = SD_LU)
+    {
+        return SLE_sparse_direct(SparseMatrix<T>(A), f, ordering, type);
+    }
+
+    //   Sparse direct solver with some standard constants
+    template <class T>
+    Matrix<T> SLE_sparse_direct_standard(const Matrix<T> &A,
+            const Matrix<T> &f)
+    {
+        return SLE_sparse_direct(A, f);
+    }
+}
+
+#endif // SPARSE_DIRECT_INCLUDE_GUARD
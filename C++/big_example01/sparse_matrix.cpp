@@ -0,0 +1,3 @@
+// sparse_matrix.cpp
+
+#include "sparse_matrix.h"
@@ -0,0 +1,392 @@
+// sparse_matrix.h
+
+//   Definition and implementation of class SparseMatrix. It stores only
+// nonzero elements of matrix in CSR (compressed sparse row) format
+
+
+#ifndef SPARSE_MATRIX_INCLUDE_GUARD
+#define SPARSE_MATRIX_INCLUDE_GUARD
+
+#include <vector>     // vector
+#include <stdexcept>  // invalid_argument, out_of_range
+#include <string>     // string
+#include <algorithm>  // sort, lower_bound, max
+#include <cmath>      // abs
+#include "matrix.h"
+#include "parallel.h"
+
+
+//   SparseMatrix class. Elements of row 'i' are stored in 'values' from
+// position row_ptr[i] to position row_ptr[i + 1] (not including it).
+// Columns of these elements are stored in 'col_ind' in increasing order
+template <class T>
+class SparseMatrix
+{
+private:
+    //   Exception's messages
+    static const std::string exception_prefix;
+    static const std::string exception_out_of_range;
+    static const std::string exception_matrices_sizes_do_not_match;
+
+    //   Number of rows in one chunk of parallel matrix-vector product
+    enum
+    {
+        PARALLEL_GRAIN = 256,
+    };
+
+    size_t rows = 0, cols = 0;
+    std::vector<size_t> row_ptr = std::vector<size_t>(1, 0);
+    std::vector<size_t> col_ind;
+    std::vector<T> values;
+
+public:
+    //   Element of matrix given by its position: (row, col, value)
+    struct Triplet
+    {
+        size_t row, col;
+        T val;
+    };
+
+    //   Constructors. Dense matrix is converted by dropping exact zeros.
+    // Triplets may repeat, then their values are summed up
+    SparseMatrix() = default;
+    SparseMatrix(size_t rows_init, size_t cols_init);
+    SparseMatrix(const Matrix<T> &A);
+    SparseMatrix(size_t rows_init, size_t cols_init,
+            std::vector<Triplet> triplets);
+
+    //   Getters
+    size_t get_rows() const;
+    size_t get_cols() const;
+    size_t get_nnz() const;
+
+    //   Raw CSR arrays
+    const std::vector<size_t> &get_row_ptr() const;
+    const std::vector<size_t> &get_col_ind() const;
+    const std::vector<T> &get_values() const;
+
+    //   Values can be changed without changing the pattern of matrix
+    std::vector<T> &set_values();
+
+    //   Returns element (i, j) (zero if it isn't stored)
+    T at(size_t i, size_t j) const;
+
+    //   Returns diagonal of matrix
+    std::vector<T> get_diagonal() const;
+
+    //   Conversion to dense matrix
+    Matrix<T> to_matrix() const;
+
+    //   Returns transposed matrix
+    SparseMatrix<T> get_transposed() const;
+
+    //   Returns true if both matrices store elements at the same places
+    bool has_same_pattern(const SparseMatrix<T> &B) const;
+
+    //   Returns true if |A[i][j] - A[j][i]| <= tol * max(|A[i][j]|, 
+    // |A[j][i]|) for all elements
+    bool is_symmetric(const T &tol = T(0)) const;
+
+    //   y = A * x. Rows are processed in parallel
+    void multiply(const std::vector<T> &x, std::vector<T> &y) const;
+
+    //   Sparse matrix product
+    template <class U>
+    friend SparseMatrix<U> operator * (const SparseMatrix<U> &,
+            const SparseMatrix<U> &);
+};
+
+
+template <class T>
+const std::string SparseMatrix<T>::exception_prefix = "class SparseMatrix: ";
+
+template <class T>
+const std::string SparseMatrix<T>::exception_out_of_range = exception_prefix +
+        "index of element is out of matrix";
+
+template <class T>
+const std::string SparseMatrix<T>::exception_matrices_sizes_do_not_match =
+        exception_prefix + "sizes of matrices do not match";
+
+template <class T>
+SparseMatrix<T>::SparseMatrix(size_t rows_init, size_t cols_init)
+{
+    rows = rows_init;
+    cols = cols_init;
+    row_ptr.assign(rows + 1, 0);
+}
+
+template <class T>
+SparseMatrix<T>::SparseMatrix(const Matrix<T> &A)
+{
+    rows = A.get_rows();
+    cols = A.get_cols();
+    row_ptr.assign(rows + 1, 0);
+
+    for (size_t i = 0; i < rows; ++i) {
+        const std::vector<T> &row = A[i];
+
+        for (size_t j = 0; j < cols; ++j) {
+            if (row[j] != T(0)) {
+                col_ind.push_back(j);
+                values.push_back(row[j]);
+            }
+        }
+
+        row_ptr[i + 1] = col_ind.size();
+    }
+}
+
+template <class T>
+SparseMatrix<T>::SparseMatrix(size_t rows_init, size_t cols_init,
+        std::vector<Triplet> triplets)
+{
+    rows = rows_init;
+    cols = cols_init;
+    row_ptr.assign(rows + 1, 0);
+
+    //   Sort triplets by position and then merge equal positions
+    std::sort(triplets.begin(), triplets.end(),
+            [](const Triplet &a, const Triplet &b) {
+                return a.row < b.row || (a.row == b.row && a.col < b.col);
+            });
+
+    for (size_t k = 0; k < triplets.size(); ++k) {
+        if (triplets[k].row >= rows || triplets[k].col >= cols) {
+            throw std::out_of_range(exception_out_of_range);
+        }
+
+        if (k > 0 && triplets[k].row == triplets[k - 1].row &&
+                triplets[k].col == triplets[k - 1].col) {
+            values.back() += triplets[k].val;
+            continue;
+        }
+
+        col_ind.push_back(triplets[k].col);
+        values.push_back(triplets[k].val);
+        ++row_ptr[triplets[k].row + 1];
+    }
+
+    for (size_t i = 0; i < rows; ++i) {
+        row_ptr[i + 1] += row_ptr[i];
+    }
+}
+
+template <class T>
+size_t SparseMatrix<T>::get_rows() const
+{
+    return rows;
+}
+
+template <class T>
+size_t SparseMatrix<T>::get_cols() const
+{
+    return cols;
+}
+
+template <class T>
+size_t SparseMatrix<T>::get_nnz() const
+{
+    return values.size();
+}
+
+template <class T>
+const std::vector<size_t> &SparseMatrix<T>::get_row_ptr() const
+{
+    return row_ptr;
+}
+
+template <class T>
+const std::vector<size_t> &SparseMatrix<T>::get_col_ind() const
+{
+    return col_ind;
+}
+
+template <class T>
+const std::vector<T> &SparseMatrix<T>::get_values() const
+{
+    return values;
+}
+
+template <class T>
+std::vector<T> &SparseMatrix<T>::set_values()
+{
+    return values;
+}
+
+template <class T>
+T SparseMatrix<T>::at(size_t i, size_t j) const
+{
+    if (i >= rows || j >= cols) {
+        throw std::out_of_range(exception_out_of_range);
+    }
+
+    //   Columns in row are sorted, so I use binary search
+    auto first = col_ind.begin() + row_ptr[i];
+    auto last = col_ind.begin() + row_ptr[i + 1];
+    auto it = std::lower_bound(first, last, j);
+
+    if (it == last || *it != j) {
+        return T(0);
+    }
+    return values[it - col_ind.begin()];
+}
+
+template <class T>
+std::vector<T> SparseMatrix<T>::get_diagonal() const
+{
+    std::vector<T> diag(std::min(rows, cols), T(0));
+
+    for (size_t i = 0; i < diag.size(); ++i) {
+        diag[i] = at(i, i);
+    }
+
+    return diag;
+}
+
+template <class T>
+Matrix<T> SparseMatrix<T>::to_matrix() const
+{
+    Matrix<T> A(rows, cols, 0);
+
+    for (size_t i = 0; i < rows; ++i) {
+        std::vector<T> &row = A[i];
+
+        for (size_t k = row_ptr[i]; k < row_ptr[i + 1]; ++k) {
+            row[col_ind[k]] = values[k];
+        }
+    }
+
+    return A;
+}
+
+template <class T>
+SparseMatrix<T> SparseMatrix<T>::get_transposed() const
+{
+    SparseMatrix<T> B(cols, rows);
+
+    //   Count elements in each column, then place them. Rows are
+    // visited in increasing order, so columns of B stay sorted
+    for (size_t k = 0; k < col_ind.size(); ++k) {
+        ++B.row_ptr[col_ind[k] + 1];
+    }
+    for (size_t j = 0; j < cols; ++j) {
+        B.row_ptr[j + 1] += B.row_ptr[j];
+    }
+
+    B.col_ind.resize(col_ind.size());
+    B.values.resize(values.size());
+
+    std::vector<size_t> pos(B.row_ptr.begin(), B.row_ptr.end() - 1);
+    for (size_t i = 0; i < rows; ++i) {
+        for (size_t k = row_ptr[i]; k < row_ptr[i + 1]; ++k) {
+            size_t dst = pos[col_ind[k]]++;
+
+            B.col_ind[dst] = i;
+            B.values[dst] = values[k];
+        }
+    }
+
+    return B;
+}
+
+template <class T>
+bool SparseMatrix<T>::has_same_pattern(const SparseMatrix<T> &B) const
+{
+    return rows == B.rows && cols == B.cols && row_ptr == B.row_ptr &&
+            col_ind == B.col_ind;
+}
+
+template <class T>
+bool SparseMatrix<T>::is_symmetric(const T &tol) const
+{
+    if (rows != cols) {
+        return false;
+    }
+
+    //   Each stored element is compared with its symmetric one in both
+    // directions, so element which is stored only below (or above) the
+    // diagonal is compared with zero
+    for (size_t i = 0; i < rows; ++i) {
+        for (size_t k = row_ptr[i]; k < row_ptr[i + 1]; ++k) {
+            size_t j = col_ind[k];
+            if (j == i) {
+                continue;
+            }
+
+            T a = values[k], b = at(j, i);
+            if (std::abs(a - b) > tol * std::max(std::abs(a), std::abs(b))) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+template <class T>
+void SparseMatrix<T>::multiply(const std::vector<T> &x,
+        std::vector<T> &y) const
+{
+    if (x.size() != cols) {
+        throw std::invalid_argument(exception_matrices_sizes_do_not_match);
+    }
+
+    y.resize(rows);
+
+    Parallel::parallel_for(0, rows, [&](size_t i) {
+        T sum = 0;
+        for (size_t k = row_ptr[i]; k < row_ptr[i + 1]; ++k) {
+            sum += values[k] * x[col_ind[k]];
+        }
+        y[i] = sum;
+    }, PARALLEL_GRAIN);
+}
+
+template <class T>
+SparseMatrix<T> operator * (const SparseMatrix<T> &A,
+        const SparseMatrix<T> &B)
+{
+    if (A.get_cols() != B.get_rows()) {
+        throw std::invalid_argument(SparseMatrix<T>::
+                exception_matrices_sizes_do_not_match);
+    }
+
+    SparseMatrix<T> C(A.get_rows(), B.get_cols());
+
+    //   Row by row product (Gustavson's algorithm). 'acc' accumulates
+    // current row of C, 'mark' shows which columns are already used
+    std::vector<T> acc(B.get_cols(), T(0));
+    std::vector<size_t> mark(B.get_cols(), A.get_rows());
+    std::vector<size_t> used;
+
+    for (size_t i = 0; i < A.get_rows(); ++i) {
+        used.clear();
+
+        for (size_t ka = A.row_ptr[i]; ka < A.row_ptr[i + 1]; ++ka) {
+            size_t k = A.col_ind[ka];
+
+            for (size_t kb = B.row_ptr[k]; kb < B.row_ptr[k + 1]; ++kb) {
+                size_t j = B.col_ind[kb];
+
+                if (mark[j] != i) {
+                    mark[j] = i;
+                    acc[j] = T(0);
+                    used.push_back(j);
+                }
+                acc[j] += A.values[ka] * B.values[kb];
+            }
+        }
+
+        std::sort(used.begin(), used.end());
+        for (size_t j : used) {
+            C.col_ind.push_back(j);
+            C.values.push_back(acc[j]);
+        }
+        C.row_ptr[i + 1] = C.col_ind.size();
+    }
+
+    return C;
+}
+
+#endif // SPARSE_MATRIX_INCLUDE_GUARD
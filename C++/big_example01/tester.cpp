@@ -1,3 +1,116 @@
 // tester.cpp
 
 #include "tester.h"
+#include <new>       // bad_alloc
+#include <cstdlib>   // malloc, free
+#include <atomic>    // atomic
+#include <iomanip>   // setprecision
+#include <sstream>   // ostringstream
+
+//   Counter of allocations. Global 'operator new' is replaced here, all 
+// other forms of 'new' (arrays, nothrow) call it
+static std::atomic<size_t> num_allocations(0);
+
+void *operator new(size_t size)
+{
+    num_allocations.fetch_add(1, std::memory_order_relaxed);
+
+    void *ptr = std::malloc(size ? size : 1);
+    if (!ptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void operator delete(void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept
+{
+    std::free(ptr);
+}
+
+size_t get_num_allocations()
+{
+    return num_allocations.load(std::memory_order_relaxed);
+}
+
+void print_benchmark_json(const std::string &name, 
+        const std::vector<BenchmarkResult> &results, std::ostream &out)
+{
+    std::ostringstream res;
+    res << std::setprecision(6);
+
+    res << "{\n";
+    res << "  \"name\": \"" << name << "\",\n";
+    res << "  \"tests\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchmarkResult &r = results[i];
+        res << "    { \"test\": " << r.test;
+        if (r.failed) {
+            res << ", \"failed\": true }";
+        } else {
+            res << ", \"failed\": false" <<
+                    ", \"min_s\": " << r.min_time <<
+                    ", \"median_s\": " << r.median_time <<
+                    ", \"p99_s\": " << r.p99_time << ", \"gflops\": ";
+
+            //   Unknown rate is null, not 0 GFLOP/s
+            if (r.flop_rate_known) {
+                res << r.flop_rate / 1e9;
+            } else {
+                res << "null";
+            }
+            res << ", \"allocations\": " << r.allocations;
+
+            //   Hardware counters are null if they are unavailable
+            if (r.perf_available) {
+                res << ", \"ipc\": " << r.ipc <<
+                        ", \"l1_mpki\": " << r.l1_mpki <<
+                        ", \"llc_mpki\": " << r.llc_mpki <<
+                        ", \"branch_mpki\": " << r.branch_mpki;
+            } else {
+                res << ", \"ipc\": null, \"l1_mpki\": null" <<
+                        ", \"llc_mpki\": null, \"branch_mpki\": null";
+            }
+            res << " }";
+        }
+        res << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    res << "  ]\n";
+    res << "}\n";
+
+    out << res.str();
+}
+
+void print_benchmark_csv(const std::string &name, 
+        const std::vector<BenchmarkResult> &results, std::ostream &out)
+{
+    std::ostringstream res;
+    res << std::setprecision(6);
+
+    //   Fields of unknown rate and of hardware counters (if they are
+    // unavailable) are empty
+    res << "name,test,failed,min_s,median_s,p99_s,gflops,allocations,"
+            "ipc,l1_mpki,llc_mpki,branch_mpki\n";
+    for (const BenchmarkResult &r : results) {
+        res << name << ',' << r.test << ',' << r.failed << ',' << 
+                r.min_time << ',' << r.median_time << ',' << r.p99_time << 
+                ',';
+        if (r.flop_rate_known) {
+            res << r.flop_rate / 1e9;
+        }
+        res << ',' << r.allocations << ',';
+        if (r.perf_available) {
+            res << r.ipc << ',' << r.l1_mpki << ',' << r.llc_mpki << ',' << 
+                    r.branch_mpki;
+        } else {
+            res << ",,,";
+        }
+        res << '\n';
+    }
+
+    out << res.str();
+}
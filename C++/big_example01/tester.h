@@ -6,8 +6,62 @@
 #ifndef TESTER_INCLUDE_GUARD
 #define TESTER_INCLUDE_GUARD
 
-#include <iostream>  // ostream
-#include <vector>    // vector
+#include <iostream>    // ostream
+#include <sstream>     // ostringstream
+#include <vector>      // vector
+#include <string>      // string
+#include <functional>  // function
+#include <chrono>      // steady_clock, duration
+#include <algorithm>   // sort, min
+#include <cmath>       // ceil
+#include <limits>      // numeric_limits
+#include <iomanip>     // setprecision
+#include "parallel.h"
+#include "perf_counters.h"
+
+//   Benchmark mode: number of measured runs of each test and number of
+// runs before them (warm-up: caches, lazy initialization, thread pool)
+enum Tester_benchmark_constants
+{
+    TESTER_BENCHMARK_RUNS = 10,
+    TESTER_BENCHMARK_WARMUP = 2,
+};
+
+//   Results of benchmark of one test. Times are in seconds
+struct BenchmarkResult
+{
+    size_t test = 0;
+
+    //   True if solution threw exception on this test
+    bool failed = false;
+
+    double min_time = 0, median_time = 0, p99_time = 0;
+
+    //   Floating point operations per second by median time. It's known
+    // only if number of operations of test is given
+    bool flop_rate_known = false;
+    double flop_rate = 0;
+
+    //   Number of memory allocations per run
+    double allocations = 0;
+
+    //   Hardware counters per run (if they are available): instructions 
+    // per cycle and misses per 1000 instructions
+    bool perf_available = false;
+    double ipc = 0, l1_mpki = 0, llc_mpki = 0, branch_mpki = 0;
+};
+
+//   Number of calls of global 'operator new' since start of program. 
+// Operator is replaced in tester.cpp
+size_t get_num_allocations();
+
+//   Print results of benchmark of solution 'name' in JSON and CSV. 
+// Output of different builds can be compared by diff
+void print_benchmark_json(const std::string &name, 
+        const std::vector<BenchmarkResult> &results, std::ostream &out);
+void print_benchmark_csv(const std::string &name, 
+        const std::vector<BenchmarkResult> &results, std::ostream &out);
+
 
 //   I use this class to test many of written algorithms. I just create 
 // instance of class Tester, then I add tests to it, and then I can run 
@@ -53,15 +107,55 @@ public:
     // they go around the circle
     const T &next_test() const;
 
+    //   Returns test number 'i'. Unlike 'next_test' it doesn't change 
+    // state of object, so it can be called from many threads at once
+    const T &get_test(size_t i) const;
+
     //   Compare user answer with right answer
     bool check_answer(const A &usr_ans, std::ostream &out = std::cout, 
             std::ostream &err = std::cerr) const;
 
+    //   Compare user answer with right answer of test number 'i'. It 
+    // doesn't change state of object too
+    bool check_answer(size_t i, const A &usr_ans, 
+            std::ostream &out = std::cout, 
+            std::ostream &err = std::cerr) const;
+
+
+    //   Checks user answer of test number 'i' by function 
+    // verifier(test, usr_ans, err) instead of comparing with right answer, 
+    // so tests without right answer can be checked too. Verifier returns 
+    // true if answer is correct and can print details to 'err'
+    template <class V>
+    bool check_answer_by(size_t i, const A &usr_ans, V verifier, 
+            std::ostream &out = std::cout, 
+            std::ostream &err = std::cerr) const;
+
 
     //   Run all tests on solution function
     //   Returns true if all tests passed and false otherwise
     template <class F>
     bool run_all_tests(F solution, std::ostream &out = std::cout) const;
+
+    //   The same as 'run_all_tests', but tests are run in parallel. 
+    // Messages of each test are collected separately and printed in 
+    // order of tests after all tests, so output is the same as output 
+    // of 'run_all_tests'. 'solution' must be safe to call from many 
+    // threads at once
+    template <class F>
+    bool run_all_tests_parallel(F solution, 
+            std::ostream &out = std::cout) const;
+
+    //   Benchmark: runs solution on each test 'warmup' times and then 
+    // 'runs' times with measuring of time and allocations. Answers are 
+    // not checked. 'flop_count' gives number of floating point 
+    // operations for test (if it's known). Tests are run one by one, so 
+    // solution can use all threads
+    template <class F>
+    std::vector<BenchmarkResult> benchmark(F solution, 
+            size_t runs = TESTER_BENCHMARK_RUNS, 
+            size_t warmup = TESTER_BENCHMARK_WARMUP,
+            std::function<double(const T &)> flop_count = nullptr) const;
 };
 
 
@@ -142,6 +236,17 @@ const T &Tester<T, A>::next_test() const
     return tests[last_test_given];
 }
 
+template <class T, class A>
+const T &Tester<T, A>::get_test(size_t i) const
+{
+    if (i >= get_num_tests()) {
+        throw std::out_of_range(exception_prefix + "there is no test with "
+                "such number");
+    }
+
+    return tests[i];
+}
+
 template <class T, class A>
 bool Tester<T, A>::check_answer(const A &usr_ans, 
         std::ostream &out, std::ostream &err) const
@@ -159,26 +264,66 @@ bool Tester<T, A>::check_answer(const A &usr_ans,
                 "of tests");
     }
 
+    return check_answer(last_test_given, usr_ans, out, err);
+}
+
+template <class T, class A>
+bool Tester<T, A>::check_answer(size_t i, const A &usr_ans, 
+        std::ostream &out, std::ostream &err) const
+{
+    if (i >= get_num_tests()) {
+        throw std::out_of_range(exception_prefix + "there is no test with "
+                "such number");
+    }
+
     //   Compare user answer 'usr_ans' and right answer
-    bool ret_val = (answers[last_test_given] == usr_ans);
+    bool ret_val = (answers[i] == usr_ans);
 
     //   Print information about testing
     //   OK - test passed, WA - wrong answer, PR - pending review (for 
     // cases when there is no answer for test)
-    if (answers[last_test_given].get_rows() == 0) {
-        out << "[PR] Test #" << last_test_given + 1 << " can't be checked\n";
+    if (answers[i].get_rows() == 0) {
+        out << "[PR] Test #" << i + 1 << " can't be checked\n";
 
-        err << "[PR] Test #" << last_test_given + 1 << " can't be checked\n";
+        err << "[PR] Test #" << i + 1 << " can't be checked\n";
     } else if (ret_val) {
-        out << "[OK] Test #" << last_test_given + 1 << " passed\n";
+        out << "[OK] Test #" << i + 1 << " passed\n";
 
-        err << "[OK] Test #" << last_test_given + 1 << " passed\n";
+        err << "[OK] Test #" << i + 1 << " passed\n";
     } else {
-        out << "[WA] Test #" << last_test_given + 1 << " failed\n";
+        out << "[WA] Test #" << i + 1 << " failed\n";
 
-        err << "[WA] Test #" << last_test_given + 1 << " failed:\n";
-        err << "Test:\n" << tests[last_test_given] << std::endl;
-        err << "Rigth answer:\n" << answers[last_test_given] << std::endl;
+        err << "[WA] Test #" << i + 1 << " failed:\n";
+        err << "Test:\n" << tests[i] << std::endl;
+        err << "Rigth answer:\n" << answers[i] << std::endl;
+        err << "Your answer:\n" << usr_ans << std::endl;
+    }
+
+    return ret_val;
+}
+
+template <class T, class A>
+template <class V>
+bool Tester<T, A>::check_answer_by(size_t i, const A &usr_ans, V verifier, 
+        std::ostream &out, std::ostream &err) const
+{
+    if (i >= get_num_tests()) {
+        throw std::out_of_range(exception_prefix + "there is no test with "
+                "such number");
+    }
+
+    std::ostringstream details;
+    bool ret_val = verifier(tests[i], usr_ans, details);
+
+    if (ret_val) {
+        out << "[OK] Test #" << i + 1 << " passed\n";
+
+        err << "[OK] Test #" << i + 1 << " passed\n";
+    } else {
+        out << "[WA] Test #" << i + 1 << " failed\n";
+
+        err << "[WA] Test #" << i + 1 << " failed:\n";
+        err << details.str();
         err << "Your answer:\n" << usr_ans << std::endl;
     }
 
@@ -214,4 +359,118 @@ bool Tester<T, A>::run_all_tests(F solution, std::ostream &out) const
     return all_tests_passed;
 }
 
+template <class T, class A>
+template <class F>
+bool Tester<T, A>::run_all_tests_parallel(F solution, 
+        std::ostream &out) const 
+{
+    size_t n = get_num_tests();
+
+    //   Messages of each test: verdicts (they go to std::cout and 
+    // std::cerr as in 'check_answer') and exceptions of solution
+    std::vector<std::ostringstream> verdict_out(n), verdict_err(n);
+    std::vector<std::ostringstream> solution_err(n);
+    std::vector<char> passed(n, 0);
+
+    auto run_test = [&](size_t i) {
+        //   Here I handle with exceptions which solution can throw
+        try {
+            passed[i] = check_answer(i, solution(get_test(i)), 
+                    verdict_out[i], verdict_err[i]);
+        } catch (std::logic_error &e) {
+            solution_err[i] << e.what() << std::endl;
+        }
+    };
+
+    //   Other exceptions are rethrown by 'parallel_for'
+    Parallel::parallel_for(0, n, run_test);
+
+    //   Print messages in order of tests
+    bool all_tests_passed = true;
+    for (size_t i = 0; i < n; ++i) {
+        std::cout << verdict_out[i].str();
+        std::cerr << verdict_err[i].str();
+        out << solution_err[i].str();
+        all_tests_passed &= (passed[i] != 0);
+    }
+
+    //   Print message about testing
+    if (all_tests_passed) {
+        out << "Testing finished successfully!\n";
+    } else {
+        out << "Some tests were failed\n";
+    }
+
+    return all_tests_passed;
+}
+
+template <class T, class A>
+template <class F>
+std::vector<BenchmarkResult> Tester<T, A>::benchmark(F solution, 
+        size_t runs, size_t warmup, 
+        std::function<double(const T &)> flop_count) const
+{
+    using clock = std::chrono::steady_clock;
+    using namespace PerfCounters;
+
+    runs = std::max<size_t>(runs, 1);
+    std::vector<BenchmarkResult> results(get_num_tests());
+
+    //   Counters are opened once. If they are not permitted, only time 
+    // and allocations are measured
+    PerfCollector perf;
+
+    for (size_t i = 0; i < get_num_tests(); ++i) {
+        BenchmarkResult &res = results[i];
+        res.test = i + 1;
+
+        const T &test = get_test(i);
+        std::vector<double> times(runs);
+        size_t allocations = 0;
+
+        try {
+            for (size_t r = 0; r < warmup; ++r) {
+                solution(test);
+            }
+
+            perf.start();
+            for (size_t r = 0; r < runs; ++r) {
+                size_t alloc_start = get_num_allocations();
+                auto start = clock::now();
+                auto ans = solution(test);
+                auto finish = clock::now();
+                allocations += get_num_allocations() - alloc_start;
+
+                times[r] = std::chrono::duration<double>(finish - 
+                        start).count();
+            }
+            PerfValues counters = perf.stop();
+
+            res.perf_available = counters.has(PERF_INSTRUCTIONS);
+            res.ipc = counters.ipc();
+            res.l1_mpki = counters.per_kilo_instruction(PERF_L1D_MISSES);
+            res.llc_mpki = counters.per_kilo_instruction(PERF_LLC_MISSES);
+            res.branch_mpki = counters.per_kilo_instruction(
+                    PERF_BRANCH_MISSES);
+        } catch (std::logic_error &) {
+            res.failed = true;
+            continue;
+        }
+
+        std::sort(times.begin(), times.end());
+        res.min_time = times[0];
+        res.median_time = (times[(runs - 1) / 2] + times[runs / 2]) / 2;
+        res.p99_time = times[std::min(runs - 1, 
+                (size_t) std::ceil(0.99 * runs) - 1)];
+        res.allocations = double(allocations) / runs;
+
+        if (flop_count && res.median_time > 0) {
+            res.flop_rate = flop_count(test) / res.median_time;
+            res.flop_rate_known = true;
+        }
+    }
+
+    return results;
+}
+
 #endif // TESTER_INCLUDE_GUARD
@@ -9,9 +9,13 @@
 
 #include <utility>      // pair
 #include <functional>   // function
+#include <vector>       // vector
+#include <memory>       // shared_ptr, make_shared
 #include "matrix.h"
 #include "tester.h"
 #include "matrix_functions.h"
+#include "parallel.h"
+#include "tracing.h"
 
 namespace Tests
 {
@@ -423,47 +427,68 @@ namespace Tests
         ));
 
         //   Here I create tests from information about them and add this 
-        // tests to Tester object
+        // tests to Tester object. Generation of big matrices takes most of
+        // time, so each generated test is described by function, tests are
+        // generated in parallel and then added in the same order
+        using TestType = std::pair<Matrix<T>, Matrix<T>>;
+        std::vector<std::function<TestType()>> generators;
+
         //   Example 1
         for (auto test_info : generated_tests_example1) {
-            tester.add_test(std::make_pair(
-                example1::get_A<T>(test_info.n, test_info.m),
-                Matrix<T>::generate_matrix(test_info.n, 1, 
-                        test_info.m, test_info.f)
-            ), Matrix<T>());
+            generators.push_back([test_info]() {
+                return std::make_pair(
+                    example1::get_A<T>(test_info.n, test_info.m),
+                    Matrix<T>::generate_matrix(test_info.n, 1, 
+                            test_info.m, test_info.f)
+                );
+            });
         }
 
         //   Example 2
         for (auto test_info : generated_tests_example2) {
-            tester.add_test(std::make_pair(
-                example2::get_A<T>(test_info.n, test_info.m),
-                Matrix<T>::generate_matrix(test_info.n, 1, 
-                        test_info.m, test_info.f)
-            ), Matrix<T>());
+            generators.push_back([test_info]() {
+                return std::make_pair(
+                    example2::get_A<T>(test_info.n, test_info.m),
+                    Matrix<T>::generate_matrix(test_info.n, 1, 
+                            test_info.m, test_info.f)
+                );
+            });
         }
 
 
         //   And some positive definite matrices
         std::vector<size_t> pos_def_sizes = { 10, 20, 30, 40, 50 };
         for (auto n : pos_def_sizes) {
-            //   Generating random matrix n x n with rank n
-            Matrix<T> A;
-            while (MatrixFunctions::rank_matrix(A = 
-                    Matrix<T>::make_random_matrix(n, n, n, n)) < n) {}
-
-            //   Generating diagonal matrix
-            auto diag = Matrix<T>::generate_matrix(n, n, 0, 
-            [](int i, int j, size_t rows, size_t cols, const T &val) {
-                return i == j ? i + 1 : 0;
+            generators.push_back([n]() {
+                //   Generating random matrix n x n with rank n
+                Matrix<T> A;
+                while (MatrixFunctions::rank_matrix(A = 
+                        Matrix<T>::make_random_matrix(n, n, n, n)) < n) {}
+
+                //   Generating diagonal matrix
+                auto diag = Matrix<T>::generate_matrix(n, n, 0, 
+                [](int i, int j, size_t rows, size_t cols, const T &val) {
+                    return i == j ? i + 1 : 0;
+                });
+
+                auto B = A * diag * MatrixFunctions::inverse_matrix(A);
+
+                //   And here we get positive definite matrix
+                return std::make_pair(
+                        B * B.get_transposed(),
+                        Matrix<T>::make_random_matrix(n, n, 1, 1)
+                        );
             });
+        }
 
-            auto B = A * diag * MatrixFunctions::inverse_matrix(A);
+        std::vector<TestType> generated(generators.size());
+        Parallel::parallel_for(0, generators.size(), [&](size_t i) {
+            TRACE_SCOPE("generate test", "tests", i + 1);
+            generated[i] = generators[i]();
+        }, 1);
 
-            //   And here we get positive definite matrix
-            tester.add_test(std::make_pair(
-                    B * B.get_transposed(),
-                    Matrix<T>::make_random_matrix(n, n, 1, 1)
-                    ), Matrix<T>());
+        for (auto &test : generated) {
+            tester.add_test(test, Matrix<T>());
         }
 
         //   One more test with small positive definite left matrix for which 
@@ -495,6 +520,23 @@ namespace Tests
 
        return tester;
     }
+
+    //   Tests shared by all users. They are generated once, on first call
+    // (initialization of static variable is thread-safe), and can't be 
+    // changed. Tests must be taken by 'get_test', because 'next_test' 
+    // changes state of Tester
+    template <class T>
+    std::shared_ptr<const Tester<std::pair<Matrix<T>, Matrix<T>>, Matrix<T>>>
+            get_shared_tests()
+    {
+        using TesterType = Tester<std::pair<Matrix<T>, Matrix<T>>, Matrix<T>>;
+
+        static const std::shared_ptr<const TesterType> tests = 
+                std::make_shared<const TesterType>(
+                create_tester_with_tests<T>());
+
+        return tests;
+    }
 }
 
 #endif // TESTS_INCLUDE_GUARD
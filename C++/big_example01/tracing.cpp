@@ -0,0 +1,96 @@
+// tracing.cpp
+
+#include "tracing.h"
+#include "result_sink.h"  // json_escape
+#include <fstream>        // ofstream
+#include <iomanip>        // fixed, setprecision
+#include <memory>         // shared_ptr, make_shared
+#include <mutex>          // mutex, lock_guard
+#include <chrono>         // steady_clock, duration
+#include <stdexcept>      // invalid_argument
+
+std::atomic<bool> Tracing::TracingDetail::enabled(false);
+
+namespace
+{
+    using clock = std::chrono::steady_clock;
+
+    const clock::time_point program_start = clock::now();
+
+    //   All buffers ever created. They are owned here too, so events of
+    // finished threads are kept. Mutex is taken only when thread registers
+    // its buffer and when events are written or cleared
+    std::mutex registry_mutex;
+    std::vector<std::shared_ptr<Tracing::ThreadBuffer>> registry;
+}
+
+Tracing::ThreadBuffer &Tracing::TracingDetail::get_buffer()
+{
+    static thread_local std::shared_ptr<ThreadBuffer> buffer;
+    if (!buffer) {
+        buffer = std::make_shared<ThreadBuffer>();
+        buffer->events.reserve(TRACE_BUFFER_RESERVE);
+
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        buffer->tid = registry.size();
+        registry.push_back(buffer);
+    }
+    return *buffer;
+}
+
+double Tracing::TracingDetail::now_us()
+{
+    return std::chrono::duration<double, std::micro>(clock::now() -
+            program_start).count();
+}
+
+void Tracing::start()
+{
+    {
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        for (auto &buffer : registry) {
+            buffer->events.clear();
+        }
+    }
+    TracingDetail::enabled.store(true);
+}
+
+void Tracing::stop()
+{
+    TracingDetail::enabled.store(false);
+}
+
+void Tracing::write_trace(const std::string &path)
+{
+    std::ofstream fout(path);
+    if (!fout) {
+        throw std::invalid_argument("write_trace: can't open file " + path);
+    }
+
+    std::lock_guard<std::mutex> lock(registry_mutex);
+
+    fout << "{\"traceEvents\":[\n";
+    fout << std::fixed << std::setprecision(3);
+
+    bool first = true;
+    for (const auto &buffer : registry) {
+        if (buffer->events.empty()) {
+            continue;
+        }
+
+        //   Name of thread's line in viewer
+        fout << (first ? "" : ",\n") << "{\"name\":\"thread_name\"," <<
+                "\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->tid <<
+                ",\"args\":{\"name\":\"thread " << buffer->tid << "\"}}";
+        first = false;
+
+        for (const TraceEvent &event : buffer->events) {
+            fout << ",\n{\"name\":\"" << Results::json_escape(event.name) <<
+                    "\",\"cat\":\"" << event.category << "\",\"ph\":\"" <<
+                    event.phase << "\",\"ts\":" << event.timestamp <<
+                    ",\"pid\":1,\"tid\":" << buffer->tid << "}";
+        }
+    }
+
+    fout << "\n],\"displayTimeUnit\":\"ms\"}\n";
+}
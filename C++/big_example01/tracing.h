@@ -0,0 +1,142 @@
+// tracing.h
+
+//   Timeline of program. Scoped spans (TRACE_SCOPE) record begin and end
+// events of solvers, generation of tests and I/O, and 'write_trace' dumps
+// them in Chrome trace format (JSON), which can be opened in
+// chrome://tracing or ui.perfetto.dev. Each thread has its own line, so
+// it's seen which thread did what and where time of each phase goes.
+//   Each thread writes events only to its own buffer, without locks (the
+// buffer is registered once, on the first event of thread). Tracing is
+// switched on at run time by 'start'. When it's off, span only checks
+// one atomic flag.
+//   Events are read by 'write_trace' after 'stop', when no span is open
+
+
+#ifndef TRACING_INCLUDE_GUARD
+#define TRACING_INCLUDE_GUARD
+
+#include <string>   // string, to_string
+#include <cstddef>  // size_t
+#include <vector>   // vector
+#include <atomic>   // atomic
+#include <cstdint>  // uint32_t
+#include <utility>  // move
+
+namespace Tracing
+{
+    //   Number of events reserved in buffer of each thread, so buffer is
+    // rarely reallocated while tracing
+    enum
+    {
+        TRACE_BUFFER_RESERVE = 4096,
+    };
+
+    //   Event of Chrome trace: 'phase' is 'B' (begin) or 'E' (end),
+    // 'timestamp' is in microseconds from start of program. Category must
+    // be a string literal
+    struct TraceEvent
+    {
+        std::string name;
+        const char *category;
+        char phase;
+        double timestamp;
+    };
+
+    //   Events of one thread. Only this thread adds events to it
+    struct ThreadBuffer
+    {
+        uint32_t tid;
+        std::vector<TraceEvent> events;
+    };
+
+    namespace TracingDetail
+    {
+        extern std::atomic<bool> enabled;
+
+        //   Buffer of calling thread (it's created and registered on the
+        // first call)
+        ThreadBuffer &get_buffer();
+
+        //   Microseconds from start of program
+        double now_us();
+    }
+
+    inline bool is_enabled()
+    {
+        return TracingDetail::enabled.load(std::memory_order_relaxed);
+    }
+
+    //   'start' clears events of previous tracing and switches tracing on,
+    // 'stop' switches it off. They are called when no span is open
+    void start();
+    void stop();
+
+    //   Writes all events to file 'path' in Chrome trace format. Throws
+    // invalid_argument if file can't be opened
+    void write_trace(const std::string &path);
+
+    //   Span which begins in constructor and ends in destructor. If
+    // tracing was off at construction, span records nothing
+    class ScopedSpan
+    {
+    private:
+        const char *category;
+        bool active;
+
+        void begin(std::string name)
+        {
+            ThreadBuffer &buffer = TracingDetail::get_buffer();
+            buffer.events.push_back(TraceEvent{ std::move(name), category,
+                    'B', TracingDetail::now_us() });
+        }
+
+    public:
+        ScopedSpan(const char *name, const char *category_init)
+            : category(category_init), active(is_enabled())
+        {
+            if (active) {
+                begin(name);
+            }
+        }
+
+        //   Name is "name #id" (it's built only if tracing is on)
+        ScopedSpan(const char *name, const char *category_init, size_t id)
+            : category(category_init), active(is_enabled())
+        {
+            if (active) {
+                begin(std::string(name) + " #" + std::to_string(id));
+            }
+        }
+
+        ScopedSpan(const std::string &name, const char *category_init)
+            : category(category_init), active(is_enabled())
+        {
+            if (active) {
+                begin(name);
+            }
+        }
+
+        //   End is recorded even if tracing was stopped inside span, so
+        // begin and end events are always paired
+        ~ScopedSpan()
+        {
+            if (active) {
+                ThreadBuffer &buffer = TracingDetail::get_buffer();
+                buffer.events.push_back(TraceEvent{ std::string(), category,
+                        'E', TracingDetail::now_us() });
+            }
+        }
+
+        ScopedSpan(const ScopedSpan &) = delete;
+        ScopedSpan &operator = (const ScopedSpan &) = delete;
+    };
+}
+
+//   TRACE_SCOPE(name, category) or TRACE_SCOPE(name, category, id) - span
+// from this line to the end of current scope
+#define TRACE_CONCAT_DETAIL(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_DETAIL(a, b)
+#define TRACE_SCOPE(...)                                                    \
+    Tracing::ScopedSpan TRACE_CONCAT(trace_span_, __LINE__)(__VA_ARGS__)
+
+#endif // TRACING_INCLUDE_GUARD
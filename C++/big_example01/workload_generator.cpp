@@ -0,0 +1,3 @@
+// workload_generator.cpp
+
+#include "workload_generator.h"
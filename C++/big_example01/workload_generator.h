@@ -0,0 +1,475 @@
+// workload_generator.h
+
+//   Generator of big synthetic SLE with known solution. Tests from tests.h
+// have sizes up to 100, here sizes up to tens of thousands are supported.
+// Left part has chosen structure, exact solution x* is known, and right
+// part is computed as f = A x*, so answer of any solver can be checked by
+// residual (MatrixFunctions::relative_residual) and by distance to x*.
+//   Elements are produced by hash of (seed, i, j) instead of sequential
+// random generator, so each row can be generated independently of the
+// others: rows are generated in parallel, and result doesn't depend on
+// number of threads. Dense matrix of size 50000 takes 20 GB, so besides
+// generation in memory the generator can write system to stream in binary
+// format by blocks of rows without storing whole matrix.
+//   Binary format of matrix: 4 bytes "MTRX", 4 bytes - size of element,
+// 8 bytes - number of rows, 8 bytes - number of columns, then elements by
+// rows. File of SLE contains three matrices one by one: A, f and x*
+
+
+#ifndef WORKLOAD_GENERATOR_INCLUDE_GUARD
+#define WORKLOAD_GENERATOR_INCLUDE_GUARD
+
+#include <iostream>   // istream, ostream
+#include <vector>     // vector
+#include <string>     // string
+#include <cstdint>    // uint32_t, uint64_t
+#include <cstring>    // memcmp
+#include <stdexcept>  // invalid_argument
+#include <algorithm>  // min, max
+#include <cmath>      // abs, sqrt, pow, sin
+#include "matrix.h"
+#include "parallel.h"
+
+namespace Workloads
+{
+    //   Structure of left part:
+    // 1) DENSE - all elements are random numbers from [-1, 1)
+    // 2) DIAGONALLY_DOMINANT - the same, but diagonal element of each row
+    //    is bigger than sum of absolute values of other elements
+    // 3) SPD - symmetric and diagonally dominant with positive diagonal
+    //    (so positive definite)
+    // 4) BANDED - diagonally dominant with nonzero elements only at
+    //    |i - j| <= bandwidth
+    // 5) SPARSE - diagonally dominant with about 'nonzeros_per_row' random
+    //    nonzero elements in each row besides diagonal
+    // 6) ILL_CONDITIONED - A = H1 S H2, where H1, H2 are Householder
+    //    reflections and S is diagonal with values from 1 to 1 / cond
+    //    (geometric progression), so condition number of A in 2-norm is
+    //    exactly 'condition_number'
+    enum WorkloadStructure
+    {
+        WORKLOAD_DENSE,
+        WORKLOAD_DIAGONALLY_DOMINANT,
+        WORKLOAD_SPD,
+        WORKLOAD_BANDED,
+        WORKLOAD_SPARSE,
+        WORKLOAD_ILL_CONDITIONED,
+    };
+
+    //   Number of rows in block which is generated in parallel and written
+    // to stream at once (per thread)
+    enum Workload_constants
+    {
+        WORKLOAD_BLOCK_ROWS = 16,
+    };
+
+    struct WorkloadParams
+    {
+        WorkloadStructure structure = WORKLOAD_DENSE;
+        size_t n = 0;
+
+        //   For BANDED
+        size_t bandwidth = 1;
+
+        //   For SPARSE
+        size_t nonzeros_per_row = 5;
+
+        //   For ILL_CONDITIONED
+        double condition_number = 1e6;
+
+        unsigned long long seed = 0;
+    };
+
+    //   SLE A x = f with exact solution x
+    template <class T>
+    struct Workload
+    {
+        Matrix<T> A, f, x;
+    };
+
+    namespace WorkloadDetail
+    {
+        const char binary_magic[4] = { 'M', 'T', 'R', 'X' };
+
+        //   splitmix64 mixing function
+        inline uint64_t hash(uint64_t x)
+        {
+            x += 0x9e3779b97f4a7c15ULL;
+            x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+            return x ^ (x >> 31);
+        }
+
+        inline uint64_t hash(uint64_t seed, uint64_t i, uint64_t j)
+        {
+            return hash(hash(hash(seed) ^ i) ^ j);
+        }
+
+        //   Number from [-1, 1) by hash
+        inline double to_unit(uint64_t h)
+        {
+            return double(h >> 11) * (2.0 / 9007199254740992.0) - 1;
+        }
+
+        template <class T>
+        void write_value(std::ostream &out, const T &val)
+        {
+            out.write(reinterpret_cast<const char *>(&val), sizeof(val));
+        }
+
+        template <class T>
+        T read_value(std::istream &in)
+        {
+            T val;
+            in.read(reinterpret_cast<char *>(&val), sizeof(val));
+            if (!in) {
+                throw std::invalid_argument("read_matrix_binary: unexpected "
+                        "end of stream");
+            }
+            return val;
+        }
+    }
+
+    //   Writes header of binary matrix, elements must be written after it
+    template <class T>
+    void write_matrix_header(std::ostream &out, size_t rows, size_t cols)
+    {
+        using namespace WorkloadDetail;
+
+        out.write(binary_magic, sizeof(binary_magic));
+        write_value(out, uint32_t(sizeof(T)));
+        write_value(out, uint64_t(rows));
+        write_value(out, uint64_t(cols));
+    }
+
+    template <class T>
+    void write_matrix_binary(const Matrix<T> &A, std::ostream &out)
+    {
+        write_matrix_header<T>(out, A.get_rows(), A.get_cols());
+        for (size_t i = 0; i < A.get_rows(); ++i) {
+            out.write(reinterpret_cast<const char *>(A[i].data()),
+                    A.get_cols() * sizeof(T));
+        }
+    }
+
+    //   Throws invalid_argument if stream doesn't contain matrix with
+    // elements of type T
+    template <class T>
+    Matrix<T> read_matrix_binary(std::istream &in)
+    {
+        using namespace WorkloadDetail;
+
+        char magic[sizeof(binary_magic)];
+        in.read(magic, sizeof(magic));
+        if (!in || std::memcmp(magic, binary_magic, sizeof(magic)) != 0) {
+            throw std::invalid_argument("read_matrix_binary: stream doesn't "
+                    "contain matrix");
+        }
+        if (read_value<uint32_t>(in) != sizeof(T)) {
+            throw std::invalid_argument("read_matrix_binary: size of "
+                    "elements doesn't match");
+        }
+
+        size_t rows = read_value<uint64_t>(in);
+        size_t cols = read_value<uint64_t>(in);
+
+        Matrix<T> A(rows, cols);
+        for (size_t i = 0; i < rows; ++i) {
+            in.read(reinterpret_cast<char *>(A[i].data()), cols * sizeof(T));
+            if (!in) {
+                throw std::invalid_argument("read_matrix_binary: unexpected "
+                        "end of stream");
+            }
+        }
+        return A;
+    }
+
+    //   Reads SLE written by 'WorkloadGenerator::write_binary'
+    template <class T>
+    Workload<T> read_workload_binary(std::istream &in)
+    {
+        Workload<T> res;
+        res.A = read_matrix_binary<T>(in);
+        res.f = read_matrix_binary<T>(in);
+        res.x = read_matrix_binary<T>(in);
+        return res;
+    }
+
+
+    //   Generator of SLE. Everything which is needed for all rows (vectors
+    // of Householder reflections) is computed in constructor, then any
+    // row can be generated in O(n)
+    template <class T>
+    class WorkloadGenerator
+    {
+    private:
+        static const std::string exception_prefix;
+
+        WorkloadParams params;
+
+        //   For ILL_CONDITIONED: unit vectors of reflections H1, H2,
+        // diagonal of S, and c = u^T S w
+        std::vector<double> u, w, sigma;
+        double c = 0;
+
+        //   Exact solution
+        std::vector<T> solution;
+
+        //   Random number from [-1, 1) for element (i, j). If 'symmetric'
+        // is set, it's the same for (i, j) and (j, i)
+        double element(size_t i, size_t j, bool symmetric) const;
+
+        //   Random unit vector number 'k'
+        std::vector<double> unit_vector(uint64_t k) const;
+
+    public:
+        //   Throws invalid_argument if parameters are incorrect
+        WorkloadGenerator(const WorkloadParams &params_init);
+
+        size_t get_size() const { return params.n; }
+
+        //   Row 'i' of A
+        void get_row(size_t i, std::vector<T> &row) const;
+
+        //   Element 'i' of exact solution
+        T get_solution(size_t i) const;
+
+        //   Element 'i' of right part for given row 'i' of A. It's
+        // computed with long double accumulator
+        T get_right_part(const std::vector<T> &row) const;
+
+        //   Whole SLE in memory, rows are generated in parallel
+        Workload<T> generate() const;
+
+        //   Writes A, f and x* to stream in binary format. Only
+        // WORKLOAD_BLOCK_ROWS rows per thread are kept in memory
+        void write_binary(std::ostream &out) const;
+    };
+
+
+    template <class T>
+    const std::string WorkloadGenerator<T>::exception_prefix =
+            "class WorkloadGenerator: ";
+
+    template <class T>
+    WorkloadGenerator<T>::WorkloadGenerator(const WorkloadParams &params_init)
+        : params(params_init)
+    {
+        size_t n = params.n;
+        if (n == 0) {
+            throw std::invalid_argument(exception_prefix + "size of SLE "
+                    "must be positive");
+        }
+        if (params.structure == WORKLOAD_ILL_CONDITIONED &&
+                !(params.condition_number >= 1)) {
+            throw std::invalid_argument(exception_prefix + "condition "
+                    "number must be at least 1");
+        }
+
+        //   Solution is smooth with values from [1, 3], so its relative 
+        // error is well defined
+        solution.resize(n);
+        for (size_t i = 0; i < n; ++i) {
+            solution[i] = T(2 + std::sin(double(i + 1)));
+        }
+
+        if (params.structure != WORKLOAD_ILL_CONDITIONED) {
+            return;
+        }
+
+        u = unit_vector(0);
+        w = unit_vector(1);
+
+        sigma.resize(n);
+        for (size_t k = 0; k < n; ++k) {
+            sigma[k] = (n == 1 ? 1 : std::pow(params.condition_number,
+                    -double(k) / double(n - 1)));
+        }
+
+        for (size_t k = 0; k < n; ++k) {
+            c += u[k] * sigma[k] * w[k];
+        }
+    }
+
+    template <class T>
+    double WorkloadGenerator<T>::element(size_t i, size_t j,
+            bool symmetric) const
+    {
+        if (symmetric && i > j) {
+            std::swap(i, j);
+        }
+        return WorkloadDetail::to_unit(WorkloadDetail::hash(params.seed,
+                i, j));
+    }
+
+    template <class T>
+    std::vector<double> WorkloadGenerator<T>::unit_vector(uint64_t k) const
+    {
+        std::vector<double> v(params.n);
+        double norm = 0;
+        for (size_t i = 0; i < params.n; ++i) {
+            v[i] = WorkloadDetail::to_unit(WorkloadDetail::hash(
+                    ~params.seed, k, i));
+            norm += v[i] * v[i];
+        }
+
+        norm = std::sqrt(norm);
+        for (double &val : v) {
+            val /= norm;
+        }
+        return v;
+    }
+
+    template <class T>
+    void WorkloadGenerator<T>::get_row(size_t i, std::vector<T> &row) const
+    {
+        size_t n = params.n;
+        row.assign(n, T(0));
+
+        switch (params.structure) {
+        case WORKLOAD_DENSE:
+            for (size_t j = 0; j < n; ++j) {
+                row[j] = T(element(i, j, false));
+            }
+            return;
+
+        //   A = (I - 2 u u^T) S (I - 2 w w^T), so
+        //     A[i][j] = s_i [i = j] - 2 s_i w_i w_j - 2 u_i u_j s_j
+        //             + 4 c u_i w_j
+        case WORKLOAD_ILL_CONDITIONED:
+            for (size_t j = 0; j < n; ++j) {
+                row[j] = T(-2 * sigma[i] * w[i] * w[j] -
+                        2 * u[i] * u[j] * sigma[j] + 4 * c * u[i] * w[j]);
+            }
+            row[i] += T(sigma[i]);
+            return;
+
+        case WORKLOAD_DIAGONALLY_DOMINANT:
+        case WORKLOAD_SPD:
+            for (size_t j = 0; j < n; ++j) {
+                row[j] = T(element(i, j, params.structure == WORKLOAD_SPD));
+            }
+            break;
+
+        case WORKLOAD_BANDED: {
+            size_t begin = (i > params.bandwidth ? i - params.bandwidth : 0);
+            size_t end = std::min(n, i + params.bandwidth + 1);
+            for (size_t j = begin; j < end; ++j) {
+                row[j] = T(element(i, j, false));
+            }
+            break;
+        }
+
+        //   Element is nonzero with probability nonzeros_per_row / n
+        case WORKLOAD_SPARSE:
+            for (size_t j = 0; j < n; ++j) {
+                uint64_t h = WorkloadDetail::hash(params.seed, i, j);
+                if (h % n < params.nonzeros_per_row) {
+                    row[j] = T(WorkloadDetail::to_unit(
+                            WorkloadDetail::hash(h)));
+                }
+            }
+            break;
+        }
+
+        //   Diagonal dominance
+        T sum = 0;
+        for (size_t j = 0; j < n; ++j) {
+            if (j != i) {
+                sum += std::abs(row[j]);
+            }
+        }
+        row[i] = sum + 1;
+    }
+
+    template <class T>
+    T WorkloadGenerator<T>::get_solution(size_t i) const
+    {
+        return solution[i];
+    }
+
+    template <class T>
+    T WorkloadGenerator<T>::get_right_part(const std::vector<T> &row) const
+    {
+        long double sum = 0;
+        for (size_t j = 0; j < row.size(); ++j) {
+            if (row[j] != T(0)) {
+                sum += (long double) row[j] * solution[j];
+            }
+        }
+        return T(sum);
+    }
+
+    template <class T>
+    Workload<T> WorkloadGenerator<T>::generate() const
+    {
+        size_t n = params.n;
+        Workload<T> res;
+        res.A = Matrix<T>(n, n);
+        res.f = Matrix<T>(n, 1);
+        res.x = Matrix<T>(n, 1);
+
+        Parallel::parallel_for(0, n, [&](size_t i) {
+            std::vector<T> row;
+            get_row(i, row);
+            res.f[i][0] = get_right_part(row);
+            res.x[i][0] = get_solution(i);
+            res.A[i] = std::move(row);
+        }, WORKLOAD_BLOCK_ROWS);
+
+        return res;
+    }
+
+    template <class T>
+    void WorkloadGenerator<T>::write_binary(std::ostream &out) const
+    {
+        size_t n = params.n;
+        size_t batch = WORKLOAD_BLOCK_ROWS * Parallel::get_num_threads();
+
+        std::vector<std::vector<T>> rows(std::min(batch, n));
+        std::vector<T> f(n);
+
+        write_matrix_header<T>(out, n, n);
+        for (size_t begin = 0; begin < n; begin += batch) {
+            size_t end = std::min(n, begin + batch);
+
+            Parallel::parallel_for(begin, end, [&](size_t i) {
+                std::vector<T> &row = rows[i - begin];
+                get_row(i, row);
+                f[i] = get_right_part(row);
+            }, WORKLOAD_BLOCK_ROWS);
+
+            for (size_t i = begin; i < end; ++i) {
+                out.write(reinterpret_cast<const char *>(
+                        rows[i - begin].data()), n * sizeof(T));
+            }
+        }
+
+        write_matrix_header<T>(out, n, 1);
+        out.write(reinterpret_cast<const char *>(f.data()), n * sizeof(T));
+
+        write_matrix_header<T>(out, n, 1);
+        out.write(reinterpret_cast<const char *>(solution.data()),
+                n * sizeof(T));
+    }
+
+
+    //   Maximum relative error of solution x compared to exact one
+    template <class T>
+    T solution_error(const Workload<T> &workload, const Matrix<T> &x)
+    {
+        if (x.get_rows() != workload.x.get_rows() || x.get_cols() != 1) {
+            throw std::invalid_argument("solution_error: sizes of "
+                    "matrices don't match");
+        }
+
+        T err = 0;
+        for (size_t i = 0; i < x.get_rows(); ++i) {
+            err = std::max(err, std::abs(x[i][0] - workload.x[i][0]) /
+                    std::abs(workload.x[i][0]));
+        }
+        return err;
+    }
+}
+
+#endif // WORKLOAD_GENERATOR_INCLUDE_GUARD
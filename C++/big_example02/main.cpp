@@ -13,38 +13,76 @@
 #include "types.h"
 #include "ODE_solvers.h"
 #include <iostream>       // std::cin, std::cout
+#include <fstream>        // std::ofstream
+#include <string>         // std::string, std::stoul
 
 using namespace std;
 using namespace Types;
 
 
-int main()
+//   Measures time of solver on all tests of tester and writes results to
+// files 'benchmark_<name>.json' and 'benchmark_<name>.csv'
+template <class Tester, class F>
+void run_benchmark(const Tester &tester, F solver, const string &name, 
+        size_t runs)
 {
-    cout << "\tODE solver testing\n";
+    cout << "  " << name << "\n";
+    auto results = tester.benchmark(solver, runs);
+
+    ofstream json("benchmark_" + name + ".json");
+    print_benchmark_json(name, results, json);
+    ofstream csv("benchmark_" + name + ".csv");
+    print_benchmark_csv(name, results, csv);
+}
+
+
+int main(int argc, char **argv)
+{
+    //   Benchmark mode: './main --benchmark [runs]'. Answers are not 
+    // checked, only time of solvers is measured
+    bool benchmark = (argc > 1 && string(argv[1]) == "--benchmark");
+    size_t runs = (argc > 2 ? stoul(argv[2]) : TESTER_BENCHMARK_RUNS);
+
     Tester<ODETestType, ODEAnswerType> ODE_tester;
     Tests::create_ODE_tests(ODE_tester);
 
+    Tester<ODESystemTestType, ODESystemAnswerType> ODE_system_tester;
+    Tests::create_ODE_system_tests(ODE_system_tester);
+
+    Tester<BVPTestType, BVPAnswerType> BVP_tester;
+    Tests::create_BVP_tests(BVP_tester);
+
+    if (benchmark) {
+        cout << "\tBenchmark\n";
+        run_benchmark(ODE_tester, RK_solvers::solve_RK2_wrap, "RK2", runs);
+        run_benchmark(ODE_tester, RK_solvers::solve_RK4_wrap, "RK4", runs);
+        run_benchmark(ODE_system_tester, RK_solvers::solve_system_RK2_wrap, 
+                "system_RK2", runs);
+        run_benchmark(ODE_system_tester, RK_solvers::solve_system_RK4_wrap, 
+                "system_RK4", runs);
+        run_benchmark(BVP_tester, FDM_solvers::solve_FDM2_wrap, "FDM2", 
+                runs);
+        return 0;
+    }
+
+    cout << "\tODE solver testing\n";
     cout << "  RK2\n";
-    ODE_tester.run_all_tests(RK_solvers::solve_RK2_wrap, cerr);
+    ODE_tester.run_all_tests_parallel(RK_solvers::solve_RK2_wrap, cerr);
     cout << "  RK4\n";
-    ODE_tester.run_all_tests(RK_solvers::solve_RK4_wrap, cerr);
+    ODE_tester.run_all_tests_parallel(RK_solvers::solve_RK4_wrap, cerr);
 
     
     cout << "\n\tODE system solver testing\n";
-    Tester<ODESystemTestType, ODESystemAnswerType> ODE_system_tester;
-    Tests::create_ODE_system_tests(ODE_system_tester);
 
     cout << "  RK2\n";
-    ODE_system_tester.run_all_tests(RK_solvers::solve_system_RK2_wrap, cerr);
+    ODE_system_tester.run_all_tests_parallel(RK_solvers::solve_system_RK2_wrap, cerr);
     cout << "  RK4\n";
-    ODE_system_tester.run_all_tests(RK_solvers::solve_system_RK4_wrap, cerr);
+    ODE_system_tester.run_all_tests_parallel(RK_solvers::solve_system_RK4_wrap, cerr);
 
 
     cout << "\n\tBVP solver testing\n";
-    Tester<BVPTestType, BVPAnswerType> BVP_tester;
-    Tests::create_BVP_tests(BVP_tester);
 
     cout << "  FDM2\n";
-    BVP_tester.run_all_tests(FDM_solvers::solve_FDM2_wrap, cerr);
+    BVP_tester.run_all_tests_parallel(FDM_solvers::solve_FDM2_wrap, cerr);
 }
 
@@ -6,8 +6,58 @@
 #ifndef TESTER_INCLUDE_GUARD
 #define TESTER_INCLUDE_GUARD
 
-#include <iostream>  // std::ostream, std::scientific
-#include <vector>    // std::vector
+#include <iostream>   // std::ostream, std::scientific
+#include <sstream>    // std::ostringstream
+#include <vector>     // std::vector
+#include <thread>     // std::thread
+#include <atomic>     // std::atomic
+#include <exception>  // std::exception_ptr, std::current_exception
+#include <algorithm>  // std::max, std::min, std::sort
+#include <string>     // std::string
+#include <functional> // std::function
+#include <chrono>     // std::chrono::steady_clock, std::chrono::duration
+#include <cmath>      // std::ceil
+#include <limits>     // std::numeric_limits
+#include <iomanip>    // std::setprecision
+
+
+//   Benchmark mode: number of measured runs of each test and number of
+// runs before them (warm-up: caches, lazy initialization, thread pool)
+enum Tester_benchmark_constants
+{
+    TESTER_BENCHMARK_RUNS = 10,
+    TESTER_BENCHMARK_WARMUP = 2,
+};
+
+//   Results of benchmark of one test. Times are in seconds
+struct BenchmarkResult
+{
+    size_t test = 0;
+
+    //   True if solution threw exception on this test
+    bool failed = false;
+
+    double min_time = 0, median_time = 0, p99_time = 0;
+
+    //   Floating point operations per second by median time. It's known
+    // only if number of operations of test is given
+    bool flop_rate_known = false;
+    double flop_rate = 0;
+
+    //   Number of memory allocations per run
+    double allocations = 0;
+};
+
+//   Number of calls of global 'operator new' since start of program. 
+// Operator is replaced in tester.cpp
+size_t get_num_allocations();
+
+//   Print results of benchmark of solution 'name' in JSON and CSV. 
+// Output of different builds can be compared by diff
+void print_benchmark_json(const std::string &name, 
+        const std::vector<BenchmarkResult> &results, std::ostream &out);
+void print_benchmark_csv(const std::string &name, 
+        const std::vector<BenchmarkResult> &results, std::ostream &out);
 
 
 //   I use this class to test many of written algorithms. I just create 
@@ -54,15 +104,45 @@ public:
     // they go around the circle
     const T &next_test() const;
 
+    //   Returns test number 'i'. Unlike 'next_test' it doesn't change 
+    // state of object, so it can be called from many threads at once
+    const T &get_test(size_t i) const;
+
     //   Compare user answer with right answer
     bool check_answer(const A &usr_ans, std::ostream &out = std::cout, 
             std::ostream &err = std::cerr) const;
 
+    //   Compare user answer with right answer of test number 'i'. It 
+    // doesn't change state of object too
+    bool check_answer(size_t i, const A &usr_ans, 
+            std::ostream &out = std::cout, 
+            std::ostream &err = std::cerr) const;
+
 
     //   Run all tests on solution function
     //   Returns true if all tests passed and false otherwise
     template <class F>
     bool run_all_tests(F solution, std::ostream &out = std::cout) const;
+
+    //   The same as 'run_all_tests', but tests are run in parallel. 
+    // Messages of each test are collected separately and printed in 
+    // order of tests after all tests, so output is the same as output 
+    // of 'run_all_tests'. 'solution' must be safe to call from many 
+    // threads at once
+    template <class F>
+    bool run_all_tests_parallel(F solution, 
+            std::ostream &out = std::cout) const;
+
+    //   Benchmark: runs solution on each test 'warmup' times and then 
+    // 'runs' times with measuring of time and allocations. Answers are 
+    // not checked. 'flop_count' gives number of floating point 
+    // operations for test (if it's known). Tests are run one by one, so 
+    // solution can use all threads
+    template <class F>
+    std::vector<BenchmarkResult> benchmark(F solution, 
+            size_t runs = TESTER_BENCHMARK_RUNS, 
+            size_t warmup = TESTER_BENCHMARK_WARMUP,
+            std::function<double(const T &)> flop_count = nullptr) const;
 };
 
 
@@ -143,6 +223,17 @@ const T &Tester<T, A>::next_test() const
     return tests[last_test_given];
 }
 
+template <class T, class A>
+const T &Tester<T, A>::get_test(size_t i) const
+{
+    if (i >= get_num_tests()) {
+        throw std::out_of_range(exception_prefix + "there is no test with "
+                "such number");
+    }
+
+    return tests[i];
+}
+
 template <class T, class A>
 bool Tester<T, A>::check_answer(const A &usr_ans, 
         std::ostream &out, std::ostream &err) const
@@ -160,22 +251,34 @@ bool Tester<T, A>::check_answer(const A &usr_ans,
                 "of tests");
     }
 
+    return check_answer(last_test_given, usr_ans, out, err);
+}
+
+template <class T, class A>
+bool Tester<T, A>::check_answer(size_t i, const A &usr_ans, 
+        std::ostream &out, std::ostream &err) const
+{
+    if (i >= get_num_tests()) {
+        throw std::out_of_range(exception_prefix + "there is no test with "
+                "such number");
+    }
+
     //   Always returns 1 because there is no WA (wrong answer) verdict
     bool ret_val = 1;
 
     //   Print information about testing. OK - test passed, PR - pending 
     // review (for cases when there is no answer for test)
-    if (answers[last_test_given].size() == 0) {
-        out << "[PR] Test #" << last_test_given + 1 << " can't be checked\n";
+    if (answers[i].size() == 0) {
+        out << "[PR] Test #" << i + 1 << " can't be checked\n";
 
         //   For opportunity to build graph
-        err << "Test #" << last_test_given + 1 << ":\n";
+        err << "Test #" << i + 1 << ":\n";
         usr_ans.print(err);
         err << std::endl;
     } else {
-        out << "[OK] Test #" << last_test_given + 1 << " passed -> ";
+        out << "[OK] Test #" << i + 1 << " passed -> ";
         out << std::scientific << "Maximum difference: " << 
-                answers[last_test_given] - usr_ans << std::endl;
+                answers[i] - usr_ans << std::endl;
     }
 
     return ret_val;
@@ -210,4 +313,131 @@ bool Tester<T, A>::run_all_tests(F solution, std::ostream &out) const
     return all_tests_passed;
 }
 
+template <class T, class A>
+template <class F>
+bool Tester<T, A>::run_all_tests_parallel(F solution, 
+        std::ostream &out) const 
+{
+    size_t n = get_num_tests();
+
+    //   Messages of each test: verdicts (they go to std::cout and 
+    // std::cerr as in 'check_answer') and exceptions of solution
+    std::vector<std::ostringstream> verdict_out(n), verdict_err(n);
+    std::vector<std::ostringstream> solution_err(n);
+    std::vector<char> passed(n, 0);
+
+    auto run_test = [&](size_t i) {
+        //   Here I handle with exceptions which solution can throw
+        try {
+            passed[i] = check_answer(i, solution(get_test(i)), 
+                    verdict_out[i], verdict_err[i]);
+        } catch (std::logic_error &e) {
+            solution_err[i] << e.what() << std::endl;
+        }
+    };
+
+    //   Tests are taken by threads one by one. Other exceptions are 
+    // rethrown after all threads finish
+    std::atomic<size_t> next(0);
+    std::vector<std::exception_ptr> failures(n);
+    auto worker = [&]() {
+        for (size_t i = next++; i < n; i = next++) {
+            try {
+                run_test(i);
+            } catch (...) {
+                failures[i] = std::current_exception();
+            }
+        }
+    };
+
+    size_t num_threads = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::thread> threads;
+    for (size_t k = 1; k < std::min(num_threads, n); ++k) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    for (const auto &failure : failures) {
+        if (failure) {
+            std::rethrow_exception(failure);
+        }
+    }
+
+    //   Print messages in order of tests
+    bool all_tests_passed = true;
+    for (size_t i = 0; i < n; ++i) {
+        std::cout << verdict_out[i].str();
+        std::cerr << verdict_err[i].str();
+        out << solution_err[i].str();
+        all_tests_passed &= (passed[i] != 0);
+    }
+
+    //   Print message about testing
+    if (all_tests_passed) {
+        out << "Testing finished successfully!\n";
+    } else {
+        out << "Some tests were failed\n";
+    }
+
+    return all_tests_passed;
+}
+
+template <class T, class A>
+template <class F>
+std::vector<BenchmarkResult> Tester<T, A>::benchmark(F solution, 
+        size_t runs, size_t warmup, 
+        std::function<double(const T &)> flop_count) const
+{
+    using clock = std::chrono::steady_clock;
+
+    runs = std::max<size_t>(runs, 1);
+    std::vector<BenchmarkResult> results(get_num_tests());
+
+    for (size_t i = 0; i < get_num_tests(); ++i) {
+        BenchmarkResult &res = results[i];
+        res.test = i + 1;
+
+        const T &test = get_test(i);
+        std::vector<double> times(runs);
+        size_t allocations = 0;
+
+        try {
+            for (size_t r = 0; r < warmup; ++r) {
+                solution(test);
+            }
+
+            for (size_t r = 0; r < runs; ++r) {
+                size_t alloc_start = get_num_allocations();
+                auto start = clock::now();
+                auto ans = solution(test);
+                auto finish = clock::now();
+                allocations += get_num_allocations() - alloc_start;
+
+                times[r] = std::chrono::duration<double>(finish - 
+                        start).count();
+            }
+        } catch (std::logic_error &) {
+            res.failed = true;
+            continue;
+        }
+
+        std::sort(times.begin(), times.end());
+        res.min_time = times[0];
+        res.median_time = (times[(runs - 1) / 2] + times[runs / 2]) / 2;
+        res.p99_time = times[std::min(runs - 1, 
+                (size_t) std::ceil(0.99 * runs) - 1)];
+        res.allocations = double(allocations) / runs;
+
+        if (flop_count && res.median_time > 0) {
+            res.flop_rate = flop_count(test) / res.median_time;
+            res.flop_rate_known = true;
+        }
+    }
+
+    return results;
+}
+
 #endif // TESTER_INCLUDE_GUARD
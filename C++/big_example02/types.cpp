@@ -1,7 +1,9 @@
 // types.cpp
 
 #include "types.h"
-#include <cmath>      // abs
+#include <cmath>      // std::abs
+#include <limits>     // std::numeric_limits
+#include <algorithm>  // std::max
 #include <vector>     // std::vector
 #include <ostream>    // std::ostream
 
@@ -22,7 +24,7 @@ double ODEAnswerType::operator - (const ODEAnswerType &another) const
 
     double max_dif = 0;
     for (int i = 0; i < ans.size(); ++i) {
-        max_dif = std::max(max_dif, abs(ans[i] - another.ans[i]));
+        max_dif = std::max(max_dif, std::abs(ans[i] - another.ans[i]));
     }
 
     return max_dif;